@@ -0,0 +1,340 @@
+#define TINYOBJLOADER_IMPLEMENTATION //This needs to be defined exactly once so that tinyOBJ will work
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include <stb_image.h>
+#include "tinyobjloader/tiny_obj_loader.h"
+#include "headers/assets.h"
+#include "headers/pack.h"
+#include "headers/texture.h"
+
+
+/**
+ *	Constructor
+ *	@param jobs			- Where the decoding runs
+ *	@param uploadBudget	- Bytes update() may send to the GPU per call
+ */
+AssetLoader::AssetLoader(JobSystem& jobs, size_t uploadBudget) : jobs(jobs) {
+	this->uploadBudget = std::max<size_t>(uploadBudget, 4096);
+}
+
+/**
+ *	Destructor, waits for decoding still going on
+ */
+AssetLoader::~AssetLoader() {
+	jobs.wait(decoding);
+}
+
+/**
+ *	Starts loading a texture with a single image
+ *	@param path - Name of the PNG (or anything stb_image reads) in the asset pack (or the loose file)
+ *	@return The asset's id
+ */
+int AssetLoader::loadTexture(const std::string& path) {
+	return loadTextures(MipChain::cacheName(path), { path });
+}
+
+/**
+ *	Starts loading an array texture, its images packed into the layers
+ *	@param name	  - Name of the array the packer built out of the images
+ *	@param images - Names of the images, see getLayer() for where they end up
+ *	@return The asset's id
+ */
+int AssetLoader::loadTextures(const std::string& name, const std::vector<std::string>& images) {
+	assets.emplace_back(new Asset());
+	Asset* asset  = assets.back().get();
+	asset->path	  = name;
+	asset->images = images;
+
+	// The images are only decoded when the pack has no usable chain of them,
+	// each in its own job, and the chain is built once all of them are in
+	std::vector<JobSystem::TaskHandle> steps = { jobs.submit([this, asset](int) { parseTexture(*asset); }) };
+	asset->decoded.resize(images.size());
+	for (size_t i = 0; i < images.size(); i++)
+		steps.push_back(jobs.submit([this, asset, i](int) { decodeImage(*asset, i); }, { steps[0] }));
+	decoding.push_back(jobs.submit([this, asset](int) { buildTexture(*asset); }, steps));
+	return (int)assets.size() - 1;
+}
+
+/**
+ *	Starts parsing a model
+ *	@param path - Name of the .obj in the asset pack (or the loose file), its .mtl sits next to it
+ *	@return The asset's id
+ */
+int AssetLoader::loadModel(const std::string& path) {
+	assets.emplace_back(new Asset());
+	Asset* asset = assets.back().get();
+	asset->path	 = path;
+	asset->model = true;
+	decoding.push_back(jobs.submit([this, asset](int) { decodeModel(*asset); }));
+	return (int)assets.size() - 1;
+}
+
+/**
+ *	Finds where every image went in the texture's mip chain
+ *	@return false if one of them isn't in it
+ */
+bool AssetLoader::findLayers(Asset& asset) {
+	asset.layers.assign(asset.images.size(), Layer());
+	for (size_t i = 0; i < asset.images.size(); i++) {
+		Layer& layer = asset.layers[i];
+		int	   image = asset.mips.findImage(asset.images[i]);
+		if (image < 0) return false;
+		asset.mips.getImageRect(image, layer.layer, layer.offsetU, layer.offsetV, layer.scaleU, layer.scaleV);
+	}
+	return true;
+}
+
+/**
+ *	Uses the mip chain the packer made when it holds every image
+ */
+void AssetLoader::parseTexture(Asset& asset) {
+	AssetPack::View cached = AssetPack::mounted().find(asset.path);
+	if (!cached) return;
+
+	if (asset.mips.parse(cached.data, cached.size) && findLayers(asset)) {
+		asset.packed = true;
+		asset.state	 = DECODED;
+		return;
+	}
+	std::cout << "The cached texture " << asset.path << " is broken or out of date, decoding its images" << std::endl;
+}
+
+/**
+ *	Decodes one of the images (out of the pack or the loose file), unless
+ *	parseTexture() found the chain already
+ */
+void AssetLoader::decodeImage(Asset& asset, size_t index) {
+	if (asset.packed) return;
+
+	const std::string& name = asset.images[index];
+	MipChain::Image image = { nullptr, 0, 0, name };
+	int bpp;
+	AssetPack::View view = AssetPack::mounted().find(name);
+	image.pixels = view ? stbi_load_from_memory(view.data, (int)view.size, &image.width, &image.height, &bpp, STBI_rgb_alpha)
+						: stbi_load(AssetPack::loosePath(name).c_str(), &image.width, &image.height, &bpp, STBI_rgb_alpha);
+	if (!image.pixels) std::cout << "Couldnt load the texture " << name << std::endl;
+	asset.decoded[index] = image;
+}
+
+/**
+ *	Builds the mip chain out of the decoded images, once every one of them is done
+ */
+void AssetLoader::buildTexture(Asset& asset) {
+	if (asset.packed) return;
+
+	bool built = asset.mips.build(asset.decoded) && findLayers(asset);
+	for (const MipChain::Image& image : asset.decoded)
+		if (image.pixels) stbi_image_free((void*)image.pixels);
+	asset.decoded.clear();
+	asset.state = built ? DECODED : FAILED;
+}
+
+/**
+ *	Reads the OBJ into interleaved vertices. The models are Y-up and the
+ *	game is Z-up, so every position and normal is turned (x, y, z) -> (z, x, y).
+ */
+void AssetLoader::decodeModel(Asset& asset) {
+	tinyobj::attrib_t				 attrib;
+	std::vector<tinyobj::shape_t>	 shapes;
+	std::vector<tinyobj::material_t> materials;		// Unused, the ghosts use one texture
+	std::string						 warn, err;
+
+	AssetStream obj(asset.path);
+	AssetStream mtl(asset.path.substr(0, asset.path.rfind('.')) + ".mtl");
+	tinyobj::MaterialStreamReader materialReader(mtl);
+
+	bool loaded = obj && tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &obj, mtl ? &materialReader : nullptr);
+	if (!warn.empty()) std::cout << warn << std::endl;
+	if (!err.empty())  std::cerr << err << std::endl;
+	if (!loaded) {
+		std::cout << "Couldnt load the model " << asset.path << std::endl;
+		asset.state = FAILED;
+		return;
+	}
+
+	// Faces without a normal point up, faces without texture coordinates use the corner of the texture
+	const float up[3] = { 0.f, 1.f, 0.f }, corner[2] = { 0.f, 0.f };
+	auto has = [](int index, size_t count, int size) { return index >= 0 && (size_t)index * size < count; };
+
+	std::vector<float> vertices;
+	for (const auto& shape : shapes)
+		for (const auto& index : shape.mesh.indices) {
+			const float* v = &attrib.vertices[index.vertex_index * 3];
+			const float* n = has(index.normal_index,   attrib.normals.size(),	3) ? &attrib.normals[index.normal_index * 3]	   : up;
+			const float* t = has(index.texcoord_index, attrib.texcoords.size(), 2) ? &attrib.texcoords[index.texcoord_index * 2] : corner;
+			float vertex[modelFloats] = { v[2], v[0], v[1], n[2], n[0], n[1], t[0], t[1] };
+			vertices.insert(vertices.end(), vertex, vertex + modelFloats);
+		}
+
+	asset.data.resize(vertices.size() * sizeof(float));
+	std::memcpy(asset.data.data(), vertices.data(), asset.data.size());
+	asset.state = DECODED;
+}
+
+/**
+ *	GL thread: makes the texture or vertex buffer at its full size, the
+ *	contents follow in uploadChunk()
+ */
+void AssetLoader::beginUpload(Asset& asset) {
+	if (asset.model) {
+		glGenVertexArrays(1, &asset.vao);
+		glBindVertexArray(asset.vao);
+
+		glGenBuffers(1, &asset.vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, asset.vbo);
+		glBufferData(GL_ARRAY_BUFFER, std::max<size_t>(asset.data.size(), 1), nullptr, GL_STATIC_DRAW);
+
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * modelFloats, nullptr);
+
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * modelFloats, (void*)(sizeof(float) * 3));
+
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(float) * modelFloats, (void*)(sizeof(float) * 6));
+		glBindVertexArray(0);
+	}
+	else {
+		glGenTextures(1, &asset.texture);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, asset.texture);
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, asset.mips.getLevels(), GL_RGBA8, asset.mips.getWidth(), asset.mips.getHeight(),
+					   asset.mips.getLayers());
+
+		//Wrapping
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		//Filtering, trilinear between the mip levels
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		glGenBuffers(1, &asset.staging);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, asset.staging);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, asset.mips.getSize(), nullptr, GL_STREAM_DRAW);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	asset.uploaded = 0;
+	asset.state	   = UPLOADING;
+}
+
+/**
+ *	@return Bytes the GPU gets of an asset: its vertices, or every mip level
+ */
+size_t AssetLoader::uploadSize(Asset& asset) {
+	return asset.model ? asset.data.size() : asset.mips.getSize();
+}
+
+/**
+ *	GL thread: sends the next part of an asset. Textures go in whole rows
+ *	of one mip level, copied into the pixel buffer and from there into the
+ *	texture, so the driver can do the copy without stalling us.
+ *	@return Bytes sent
+ */
+size_t AssetLoader::uploadChunk(Asset& asset, size_t budget) {
+	size_t total = uploadSize(asset);
+	size_t bytes = std::min(budget, total - asset.uploaded);
+
+	// Textures go one layer of one level at a time, in the order they are stored
+	int	   level = 0, layer = 0;
+	size_t row	 = 0;
+	if (!asset.model) {
+		int levels = asset.mips.getLevels(), layers = asset.mips.getLayers();
+		while (level * layers + layer + 1 < levels * layers) {
+			int nextLevel = layer + 1 < layers ? level : level + 1, nextLayer = (layer + 1) % layers;
+			if (asset.mips.getOffset(nextLevel, nextLayer) > asset.uploaded) break;
+			level = nextLevel;
+			layer = nextLayer;
+		}
+		size_t layerEnd = asset.mips.getOffset(level, layer) + (size_t)asset.mips.getWidth(level) * asset.mips.getHeight(level) * 4;
+		row	  = (size_t)asset.mips.getWidth(level) * 4;
+		bytes = std::max(row, std::min(bytes, layerEnd - asset.uploaded) / row * row);		// At least one row, always whole ones
+	}
+	const unsigned char* source = asset.model ? asset.data.data() : asset.mips.getPixels(0);
+
+	GLenum target = asset.model ? GL_ARRAY_BUFFER : GL_PIXEL_UNPACK_BUFFER;
+	glBindBuffer(target, asset.model ? asset.vbo : asset.staging);
+	if (bytes > 0) {
+		// Every range is written once, so nothing in it can still be in use
+		void* mapped = glMapBufferRange(target, asset.uploaded, bytes,
+										GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if (mapped) {
+			std::memcpy(mapped, source + asset.uploaded, bytes);
+			glUnmapBuffer(target);
+		}
+		if (!asset.model) {
+			glBindTexture(GL_TEXTURE_2D_ARRAY, asset.texture);
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, (GLint)((asset.uploaded - asset.mips.getOffset(level, layer)) / row), layer,
+							asset.mips.getWidth(level), (GLsizei)(bytes / row), 1, GL_RGBA, GL_UNSIGNED_BYTE, (void*)asset.uploaded);
+		}
+	}
+	glBindBuffer(target, 0);
+
+	asset.uploaded += bytes;
+	if (asset.uploaded >= total) {
+		// The texture keeps its copy, the pixel buffer and decoded pixels can go.
+		// Models keep their vertices, getModelVertices() counts them.
+		if (asset.staging) glDeleteBuffers(1, &asset.staging);
+		asset.staging = 0;
+		asset.mips.clear();
+		asset.state = READY;
+	}
+	return bytes;
+}
+
+/**
+ *	GL thread, once per frame: uploads what has been decoded, up to the budget
+ */
+void AssetLoader::update() {
+	size_t budget = uploadBudget;
+	for (auto& asset : assets) {
+		if (budget == 0) break;
+
+		int state = asset->state.load();
+		if (state == DECODED) { beginUpload(*asset); state = UPLOADING; }
+		while (budget > 0 && asset->state == UPLOADING) budget -= std::min(budget, uploadChunk(*asset, budget));
+	}
+}
+
+/**
+ *	@return true once every asset is ready (or failed)
+ */
+bool AssetLoader::isDone() {
+	for (auto& asset : assets)
+		if (asset->state != READY && asset->state != FAILED) return false;
+	return true;
+}
+
+/**
+ *	@return 0 -> 1, decoding counts as the first half of every asset and uploading as the second
+ */
+float AssetLoader::getProgress() {
+	if (assets.empty()) return 1.f;
+
+	float progress = 0.f;
+	for (auto& asset : assets) {
+		switch (asset->state.load()) {
+		case DECODED:	progress += 0.5f; break;
+		case UPLOADING: progress += 0.5f + 0.5f * asset->uploaded / std::max<size_t>(uploadSize(*asset), 1); break;
+		case READY:
+		case FAILED:	progress += 1.f;  break;
+		}
+	}
+	return progress / assets.size();
+}
+
+/**
+ *	Deletes every GL object the loader made. Call it while the context is still alive.
+ */
+void AssetLoader::release() {
+	jobs.wait(decoding);
+	for (auto& asset : assets) {
+		if (asset->texture) glDeleteTextures(1, &asset->texture);
+		if (asset->vbo)		glDeleteBuffers(1, &asset->vbo);
+		if (asset->staging) glDeleteBuffers(1, &asset->staging);
+		if (asset->vao)		glDeleteVertexArrays(1, &asset->vao);
+		asset->texture = asset->vbo = asset->staging = asset->vao = 0;
+	}
+}
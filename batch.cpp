@@ -0,0 +1,159 @@
+#include <cstddef>
+#include <iostream>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "headers/batch.h"
+
+
+/**
+ *	Constructor
+ *	@param maxQuads - Quads one frame can hold, more are dropped
+ */
+SpriteBatch::SpriteBatch(int maxQuads) : maxQuads(maxQuads) {
+
+}
+
+/**
+ *	Destructor
+ */
+SpriteBatch::~SpriteBatch() {
+
+}
+
+/**
+ *	Makes the vertex array over the stream buffer, on the GL thread
+ *	@param shader - Program with the sprite shaders
+ *	@return false if the quads wouldn't fit the 16 bit indices
+ */
+bool SpriteBatch::init(GLuint shader, StreamBuffer& stream) {
+	if (maxQuads <= 0 || maxQuads * 4 > 65536) {
+		std::cout << "Couldnt make a sprite batch of " << maxQuads << " quads" << std::endl;
+		return false;
+	}
+	this->shader = shader;
+	this->stream = &stream;
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+
+	// Every quad is 2 triangles over its own 4 vertices, the same indices serve every frame
+	std::vector<uint16_t> indices;
+	for (int i = 0; i < maxQuads; i++)
+		for (int corner : { 0, 1, 2, 2, 3, 0 }) indices.push_back((uint16_t)(i * 4 + corner));
+	glGenBuffers(1, &ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+
+	// The vertices are wherever begin() got them, flush() says where with the base vertex
+	glBindBuffer(GL_ARRAY_BUFFER, stream.getBuffer());
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, x));
+
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, colour));
+
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, u));
+
+	glEnableVertexAttribArray(3);
+	glVertexAttribIPointer(3, 1, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, layer));
+	glBindVertexArray(0);
+	return true;
+}
+
+/**
+ *	Deletes the vertex array, while the context is still there
+ */
+void SpriteBatch::release() {
+	if (ebo) glDeleteBuffers(1, &ebo);
+	if (vao) glDeleteVertexArrays(1, &vao);
+	ebo = vao = 0;
+	stream	 = nullptr;
+	vertices = nullptr;
+}
+
+/**
+ *	Starts a frame, taking room for every quad out of the stream buffer.
+ *	Call after StreamBuffer::beginFrame().
+ */
+void SpriteBatch::begin() {
+	count	 = 0;
+	flushed	 = 0;
+	draws	 = 0;
+	range	 = stream ? stream->allocate(sizeof(Vertex) * maxQuads * 4, sizeof(Vertex)) : StreamBuffer::Range();
+	vertices = (Vertex*)range.data;
+}
+
+/**
+ *	Draws the quads added since the last flush, with one call
+ *	@param projection - Matrix of this pass: the camera's for the world, pixels for the HUD
+ */
+void SpriteBatch::flush(const glm::mat4& projection, const glm::mat4& view) {
+	if (!vertices || count == flushed) return;
+
+	stream->commit(range, sizeof(Vertex) * flushed * 4, sizeof(Vertex) * (count - flushed) * 4);
+	glBindVertexArray(vao);
+	glUseProgram(shader);
+	glUniformMatrix4fv(glGetUniformLocation(shader, "u_ProjectionMat"), 1, false, glm::value_ptr(projection));
+	glUniformMatrix4fv(glGetUniformLocation(shader, "u_ViewMat"), 1, false, glm::value_ptr(view));
+
+	GLint first = (GLint)(range.offset / sizeof(Vertex)) + flushed * 4;
+	glDrawElementsBaseVertex(GL_TRIANGLES, (count - flushed) * 6, GL_UNSIGNED_SHORT, nullptr, first);
+
+	flushed = count;
+	draws++;
+}
+
+/**
+ *	Adds a textured quad, (x0, y0) gets (u0, v0) and (x1, y1) gets (u1, v1)
+ *	@param image - Layer of the array texture to sample, u and v go over the image
+ */
+void SpriteBatch::quad(float x0, float y0, float x1, float y1, const AssetLoader::Layer& image,
+					   float u0, float v0, float u1, float v1, uint32_t colour, float z) {
+	if (!vertices || count == maxQuads) return;
+
+	u0 = image.offsetU + u0 * image.scaleU; u1 = image.offsetU + u1 * image.scaleU;
+	v0 = image.offsetV + v0 * image.scaleV; v1 = image.offsetV + v1 * image.scaleV;
+
+	Vertex* vertex = vertices + count * 4;
+	vertex[0] = { x0, y0, z, u0, v0, image.layer, colour };
+	vertex[1] = { x1, y0, z, u1, v0, image.layer, colour };
+	vertex[2] = { x1, y1, z, u1, v1, image.layer, colour };
+	vertex[3] = { x0, y1, z, u0, v1, image.layer, colour };
+	count++;
+}
+
+/**
+ *	Adds one frame of a sprite sheet cut into columns x rows
+ */
+void SpriteBatch::sprite(float x0, float y0, float x1, float y1, const AssetLoader::Layer& image,
+						 int columns, int rows, SpriteFrame frame, uint32_t colour, float z) {
+	quad(x0, y0, x1, y1, image, (float)frame.column / columns, (float)frame.row / rows,
+		 (float)(frame.column + 1) / columns, (float)(frame.row + 1) / rows, colour, z);
+}
+
+/**
+ *	Adds a line of text with its top left corner at x, y (y pointing down),
+ *	one quad per character that has a glyph
+ *	@param size - Height of a character cell
+ *	@return Where the next character would go
+ */
+float SpriteBatch::text(const std::string& text, float x, float y, float size, uint32_t colour) {
+	for (char c : text) {
+		int glyph = c - FontSheet::first;
+		if (c != ' ' && glyph >= 0 && glyph < FontSheet::columns * FontSheet::rows)
+			sprite(x, y, x + size, y + size, font, FontSheet::columns, FontSheet::rows,
+				   { (uint8_t)(glyph % FontSheet::columns), (uint8_t)(glyph / FontSheet::columns) }, colour);
+		x += size * FontSheet::advance;
+	}
+	return x;
+}
+
+/**
+ *	@return How wide text() draws a line
+ */
+float SpriteBatch::textWidth(const std::string& text, float size) {
+	return text.size() * size * FontSheet::advance;
+}
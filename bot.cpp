@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "headers/bot.h"
+#include "headers/parallel.h"
+
+
+/**
+ *	Constructor
+ *	@param threads - Searches run on this many threads, every core if 0
+ */
+MctsBot::MctsBot(const std::string& levelPath, uint32_t seed, int ghostAmount, int threads) {
+	workers.resize(threadCount(threads));
+	for (size_t i = 0; i < workers.size(); i++) {
+		workers[i].game.reset(new Game(levelPath, seed, ghostAmount, true));
+		workers[i].rng.seed(seed + i);
+	}
+}
+
+/**
+ *	Destructor
+ */
+MctsBot::~MctsBot() {
+
+}
+
+/**
+ *	Picks the next heading
+ *	@param rollouts - Playouts spread over all threads
+ *	@return The action, feed headingInput(action) to the game for getDecisionTicks() ticks
+ */
+int MctsBot::think(const GameState& root, int rollouts) {
+	int perWorker = std::max(1, rollouts / (int)workers.size());
+	auto start = std::chrono::steady_clock::now();
+
+	parallelFor((int)workers.size(), (int)workers.size(), [&](int, int i) {
+		search(workers[i], root, perWorker);
+	});
+
+	seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	int visits[actions] = { 0 };
+	for (auto& worker : workers) {
+		this->rollouts += worker.completed;
+		for (int a = 0; a < actions; a++) visits[a] += worker.rootVisits[a];
+	}
+
+	int best = 0;
+	for (int a = 1; a < actions; a++)
+		if (visits[a] > visits[best]) best = a;
+	return best;
+}
+
+/**
+ *	@return Rollouts per second of thinking so far, over all threads
+ */
+double MctsBot::getRolloutsPerSecond() {
+	return seconds > 0.0 ? rollouts / seconds : 0.0;
+}
+
+/**
+ *	Plays one decision in the worker's game
+ *	@return false once the game is over
+ */
+bool MctsBot::play(Worker& worker, int action) {
+	InputFrame input = headingInput(action);
+	for (int t = 0; t < decisionTicks && !worker.game->isDone(); t++) worker.game->tick(input);
+	return !worker.game->isDone();
+}
+
+/**
+ *	Plays random decisions from where the game is, mostly keeping the heading
+ *	@return 0 -> 1, half for staying alive and half for pellets eaten since the root
+ */
+float MctsBot::rollout(Worker& worker, int rootPellets) {
+	int action = worker.rng() % actions;
+	for (int d = 0; d < rolloutDepth && !worker.game->isDone(); d++) {
+		if (worker.rng() % 4 == 0) action = worker.rng() % actions;
+		play(worker, action);
+	}
+
+	float eaten = (float)(rootPellets - worker.game->getMap().getp_count());
+	return (worker.game->isDone() ? 0.f : 0.5f) + 0.5f * eaten / (eaten + pelletScale / 3.f);
+}
+
+/**
+ *	Grows the worker's tree from the root state: walk down by UCT, add one
+ *	node, play randomly to the depth limit and add the reward up the path.
+ *	Every playout starts by restoring the root, so the tree stores no states.
+ *	The worker's completed count says how many playouts actually ran.
+ */
+void MctsBot::search(Worker& worker, const GameState& root, int rollouts) {
+	std::vector<Node>& tree = worker.tree;
+	tree.clear();
+	tree.emplace_back();
+	worker.completed = 0;
+
+	for (int r = 0; r < rollouts; r++) {
+		if (!worker.game->restore(root)) break;			// Same root every time, it won't fit the next one either
+
+		int node = 0;
+		bool alive = !worker.game->isDone();
+		while (alive) {
+			int untried = -1;
+			for (int a = 0; a < actions && untried < 0; a++)
+				if (tree[node].children[a] < 0) untried = a;
+
+			if (untried >= 0) {
+				int child = (int)tree.size();
+				tree.emplace_back();
+				tree[child].parent = node;
+				tree[node].children[untried] = child;
+				alive = play(worker, untried);
+				node = child;
+				break;
+			}
+
+			// Every child has been tried, go down the most promising one
+			float logVisits = std::log((float)tree[node].visits);
+			int	  bestAction = 0;
+			float bestScore	 = -1.f;
+			for (int a = 0; a < actions; a++) {
+				const Node& child = tree[tree[node].children[a]];
+				float score = child.value / child.visits + exploration * std::sqrt(logVisits / child.visits);
+				if (score > bestScore) { bestScore = score; bestAction = a; }
+			}
+			alive = play(worker, bestAction);
+			node  = tree[node].children[bestAction];
+		}
+
+		float reward = rollout(worker, root.pelletCount);
+		for (; node >= 0; node = tree[node].parent) {
+			tree[node].visits++;
+			tree[node].value += reward;
+		}
+		worker.completed++;
+	}
+
+	for (int a = 0; a < actions; a++)
+		worker.rootVisits[a] = tree[0].children[a] >= 0 ? tree[tree[0].children[a]].visits : 0;
+}
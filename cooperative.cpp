@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+
+#include "headers/cooperative.h"
+#include "headers/distances.h"
+
+namespace {
+	const int		moveX[5]	= { 0, 0, 0, -1, 1 };		// Wait, up, down, left, right
+	const int		moveY[5]	= { 0, -1, 1, 0, 0 };
+
+	typedef std::pair<int, int> Entry;						// (f, node)
+}
+
+
+/**
+ *	Reserves a tile for an agent at an absolute step
+ */
+void ReservationTable::reserve(int x, int y, int step, int agent) {
+	if (agent >= (int)byAgent.size()) byAgent.resize(agent + 1);
+	if (agent >= (int)parkedBy.size()) parkedBy.resize(agent + 1, UINT64_MAX);
+
+	uint64_t k = key(x, y, step);
+	cells[k] = agent;
+	byAgent[agent].push_back(k);
+}
+
+/**
+ *	Drops every reservation an agent holds
+ */
+void ReservationTable::release(int agent) {
+	if (agent >= (int)byAgent.size()) return;
+
+	for (uint64_t k : byAgent[agent]) {
+		auto it = cells.find(k);
+		if (it != cells.end() && it->second == agent) cells.erase(it);
+	}
+	byAgent[agent].clear();
+
+	auto it = parked.find(parkedBy[agent]);
+	if (it != parked.end() && it->second.first == agent) parked.erase(it);
+}
+
+/**
+ *	Keeps a tile for an agent from a step on, until the agent is released
+ */
+void ReservationTable::park(int x, int y, int step, int agent) {
+	if (agent >= (int)parkedBy.size()) parkedBy.resize(agent + 1, UINT64_MAX);
+
+	uint64_t k = key(x, y, 0);
+	parked[k] = { agent, step };
+	parkedBy[agent] = k;
+}
+
+/**
+ *	@return The agent holding the tile at that step, -1 if it is free
+ */
+int ReservationTable::owner(int x, int y, int step) {
+	auto it = cells.find(key(x, y, step));
+	if (it != cells.end()) return it->second;
+
+	auto park = parked.find(key(x, y, 0));
+	return park != parked.end() && park->second.second <= step ? park->second.first : -1;
+}
+
+
+/**
+ *	Constructor
+ *	@param mapArr	 - The level grid, 1 is a wall and everything else is walkable
+ *	@param distances - Baked distance table used as the heuristic, manhattan distance if nullptr
+ *	@param window	 - How many steps every agent plans (and reserves) ahead
+ */
+CooperativePlanner::CooperativePlanner(const std::vector<std::vector<int>>& mapArr, DistanceTable* distances, int window) {
+	this->distances = distances;
+	this->window	= std::max(2, window);
+	height			= (int)mapArr.size();
+	width			= height > 0 ? (int)mapArr[0].size() : 0;
+
+	walls.resize(width * height);
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			walls[y * width + x] = mapArr[y][x] == 1;
+}
+
+/**
+ *	Destructor
+ */
+CooperativePlanner::~CooperativePlanner() {
+
+}
+
+bool CooperativePlanner::isWalkable(int x, int y) {
+	return x >= 0 && y >= 0 && x < width && y < height && !walls[y * width + x];
+}
+
+int CooperativePlanner::heuristic(int x, int y, int goalX, int goalY) {
+	int manhattan = std::abs(goalX - x) + std::abs(goalY - y);
+	if (!distances || !distances->isBaked()) return manhattan;
+	return std::max(manhattan, distances->estimate(x, y, goalX, goalY));
+}
+
+/**
+ *	Adds an agent standing on a tile. It holds its tile until its first replan,
+ *	which is staggered against the other agents.
+ *	@return The agent's id
+ */
+int CooperativePlanner::addAgent(int x, int y) {
+	int id = (int)agents.size();
+	agents.emplace_back();
+
+	Agent& agent	= agents.back();
+	agent.goalX		= x;
+	agent.goalY		= y;
+	agent.planStart = step;
+	agent.replanAt	= step + 1 + id % (window / 2);
+	agent.plan.assign(window + 1, { x, y });
+
+	for (int t = 0; t <= window; t++) reservations.reserve(x, y, step + t, id);
+	reservations.park(x, y, step + window + 1, id);
+	return id;
+}
+
+/**
+ *	Sets where an agent wants to go. Picked up the next time it replans.
+ */
+void CooperativePlanner::setGoal(int agent, int x, int y) {
+	agents[agent].goalX = x;
+	agents[agent].goalY = y;
+}
+
+/**
+ *	Tile an agent stands on at the current step (ahead = 0) or a later one
+ */
+std::pair<int, int> CooperativePlanner::getTile(int agent, int ahead) {
+	const Agent& a = agents[agent];
+	int k = std::max(0, std::min((int)a.plan.size() - 1, step + ahead - a.planStart));
+	return a.plan[k];
+}
+
+/**
+ *	Advances one step and replans the agents whose window is half used up
+ */
+void CooperativePlanner::update() {
+	step++;
+	for (int i = 0; i < (int)agents.size(); i++)
+		if (step >= agents[i].replanAt) replan(i);
+}
+
+/**
+ *	@return true if nobody else holds the tile from that step of the window to its end
+ */
+bool CooperativePlanner::canWait(int agent, int x, int y, int from) {
+	for (int t = from + 1; t <= window; t++) {
+		int taken = reservations.owner(x, y, step + t);
+		if (taken >= 0 && taken != agent) return false;
+	}
+	return true;
+}
+
+/**
+ *	Space-time A* over the next `window` steps from where the agent stands now.
+ *	Waiting on the goal is free, so agents that arrive stay put.
+ *	When the budget runs out first the plan waits out the window on the end
+ *	of the deepest path whose last tile stays free. The steps of a path were
+ *	checked on the way, only the wait wasn't, and a tile parked before the
+ *	other agents planned can still be in their way. Failing that the old plan
+ *	is kept if the rest of it is still free, and failing that too the deepest
+ *	path is taken anyway, it is free for as long as it goes.
+ */
+void CooperativePlanner::replan(int id) {
+	Agent& agent = agents[id];
+	std::pair<int, int> start = getTile(id, 0);
+	reservations.release(id);
+	replans++;
+
+	pool.clear();
+	open.clear();
+	visited.clear();
+
+	auto stateKey = [](int x, int y, int t) {
+		return ((uint64_t)(uint32_t)t << 40) | ((uint64_t)(y & 0xFFFFF) << 20) | (uint64_t)(x & 0xFFFFF);
+	};
+	auto push = [&](int x, int y, int t, int g, int parent) {
+		uint64_t k = stateKey(x, y, t);
+		auto it = visited.find(k);
+		if (it != visited.end() && pool[it->second].g <= g) return;
+
+		int node = (int)pool.size();
+		pool.push_back({ x, y, t, g, parent });
+		visited[k] = node;
+		open.push_back({ g + heuristic(x, y, agent.goalX, agent.goalY), node });
+		std::push_heap(open.begin(), open.end(), std::greater<Entry>());
+	};
+
+	push(start.first, start.second, 0, 0, -1);
+	int found = -1, deepest = 0, expanded = 0;
+
+	while (!open.empty() && expanded < maxExpand) {
+		std::pop_heap(open.begin(), open.end(), std::greater<Entry>());
+		int current = open.back().second;
+		open.pop_back();
+
+		SearchNode node = pool[current];
+		if (visited[stateKey(node.x, node.y, node.t)] != current) continue;		// Stale entry
+		if (node.t > pool[deepest].t) deepest = current;
+		if (node.t == window) { found = current; break; }
+		expanded++;
+
+		int now = step + node.t;
+		bool atGoal = node.x == agent.goalX && node.y == agent.goalY;
+		for (int m = 0; m < 5; m++) {
+			int nx = node.x + moveX[m], ny = node.y + moveY[m];
+			if (!isWalkable(nx, ny)) continue;
+
+			int taken = reservations.owner(nx, ny, now + 1);
+			if (taken >= 0 && taken != id) continue;
+
+			// Two agents swapping tiles would pass through each other
+			int coming = reservations.owner(nx, ny, now);
+			if (m != 0 && coming >= 0 && coming != id && reservations.owner(node.x, node.y, now + 1) == coming) continue;
+
+			push(nx, ny, node.t + 1, node.g + (m == 0 && atGoal ? 0 : 1), current);
+		}
+	}
+
+	if (found < 0) {
+		for (int node = 0; node < (int)pool.size(); node++)
+			if ((found < 0 || pool[node].t > pool[found].t) && canWait(id, pool[node].x, pool[node].y, pool[node].t))
+				found = node;
+	}
+
+	int done = step - agent.planStart;
+	if (found < 0 && canWait(id, agent.plan.back().first, agent.plan.back().second, (int)agent.plan.size() - 1 - done)) {
+		agent.plan.erase(agent.plan.begin(), agent.plan.begin() + std::min(done, (int)agent.plan.size() - 1));
+	}
+	else {
+		if (found < 0) found = deepest;
+		agent.plan.assign(pool[found].t + 1, start);
+		for (int node = found; node >= 0; node = pool[node].parent)
+			agent.plan[pool[node].t] = { pool[node].x, pool[node].y };
+	}
+	agent.plan.resize(window + 1, agent.plan.back());
+
+	agent.planStart = step;
+	agent.replanAt	= step + window / 2;
+	for (int t = 0; t <= window; t++)
+		reservations.reserve(agent.plan[t].first, agent.plan[t].second, step + t, id);
+	reservations.park(agent.plan[window].first, agent.plan[window].second, step + window + 1, id);
+}
@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "headers/culling.h"
+
+
+/**
+ *	Constructor
+ */
+Frustum::Frustum(const glm::mat4& projection, const glm::mat4& view) {
+	glm::mat4	 viewProjection = projection * view;
+	const float* m = glm::value_ptr(viewProjection);		// Column major
+
+	// Left, right, bottom, top, near, far: the 4th row plus or minus the 1st, 2nd and 3rd
+	for (int p = 0; p < 6; p++) {
+		int	  row  = p / 2;
+		float sign = p % 2 == 0 ? 1.f : -1.f;
+		for (int c = 0; c < 4; c++) planes[p][c] = m[c * 4 + 3] + sign * m[c * 4 + row];
+
+		float length = std::sqrt(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+		if (length > 0.f)
+			for (float& value : planes[p]) value /= length;
+	}
+}
+
+/**
+ *	Hands the planes to a culling shader, as uniform vec4 u_Planes[6]
+ */
+void Frustum::apply(GLuint program) const {
+	glUniform4fv(glGetUniformLocation(program, "u_Planes"), 6, &planes[0][0]);
+}
+
+
+/**
+ *	Constructor
+ */
+InstanceCulling::InstanceCulling() {
+
+}
+
+/**
+ *	Destructor
+ */
+InstanceCulling::~InstanceCulling() {
+
+}
+
+/**
+ *	Makes the command buffer, on the GL thread
+ *	@param cullShader - Compute program with the instance culling shader
+ */
+bool InstanceCulling::init(GLuint cullShader) {
+	shader = cullShader;
+
+	glGenBuffers(1, &command);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(DrawCommand), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	glGenBuffers(1, &visible);
+	if (!command || !visible) {
+		std::cout << "Couldnt make the buffers for culling" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/**
+ *	Deletes the buffers, while the context is still there
+ */
+void InstanceCulling::release() {
+	if (command) glDeleteBuffers(1, &command);
+	if (visible) glDeleteBuffers(1, &visible);
+	command = visible = 0;
+	capacity = 0;
+}
+
+/**
+ *	Culls this frame's instances, ready to be drawn from getCommand() and getVisible()
+ *	@param transforms - One mat4 per instance, count of them
+ *	@param radius	  - Of a sphere around the model's origin that holds all of it
+ *	@param vertices	  - Vertices of the model, first is where they start
+ */
+void InstanceCulling::cull(StreamBuffer& stream, const StreamBuffer::Range& transforms, int count,
+						   const Frustum& frustum, float radius, GLuint vertices, GLuint first) {
+	if (!begin(transforms ? count : 0, vertices, first)) return;
+	stream.bind(GL_SHADER_STORAGE_BUFFER, 2, transforms);
+	dispatch(count, frustum, radius);
+}
+
+/**
+ *	Culls instances whose transformations are in a buffer of their own
+ */
+void InstanceCulling::cull(GLuint transforms, int count, const Frustum& frustum, float radius, GLuint vertices, GLuint first) {
+	if (!begin(transforms ? count : 0, vertices, first)) return;
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, transforms);
+	dispatch(count, frustum, radius);
+}
+
+/**
+ *	Resets the command to no instances and makes room for count of them
+ *	@return false if there is nothing to cull
+ */
+bool InstanceCulling::begin(int count, GLuint vertices, GLuint first) {
+	if (!command) return false;
+
+	// The shader counts the visible instances in
+	DrawCommand start = { vertices, 0, first, 0 };
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(DrawCommand), &start);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	if (count <= 0) return false;
+
+	// Room for every instance being visible, grown in doublings
+	if (count > capacity) {
+		capacity = std::max(count, capacity * 2);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, visible);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)capacity * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+	return true;
+}
+
+/**
+ *	Runs the culling shader over the transformations bound at binding 2
+ */
+void InstanceCulling::dispatch(int count, const Frustum& frustum, float radius) {
+	glUseProgram(shader);
+	frustum.apply(shader);
+	glUniform1ui(glGetUniformLocation(shader, "u_Count"), (GLuint)count);
+	glUniform1f(glGetUniformLocation(shader, "u_Radius"), radius);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, visible);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, command);
+	glDispatchCompute((count + 63) / 64, 1, 1);
+
+	// The draw reads the command and the transformations the shader wrote
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
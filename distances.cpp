@@ -0,0 +1,403 @@
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iostream>
+
+#include "headers/distances.h"
+#include "headers/pack.h"
+#include "headers/parallel.h"
+
+namespace {
+	const char		fileMagic[4]	= { 'P', 'D', 'S', 'T' };
+	const uint32_t	fileVersion		= 1;
+	const int		dirX[4]			= { 0, 0, -1, 1 };
+	const int		dirY[4]			= { -1, 1, 0, 0 };
+
+	/**
+	 *	Offset of the pair (i, j), i < j, in the packed upper triangle
+	 */
+	inline size_t triangle(size_t i, size_t j) {
+		if (i > j) std::swap(i, j);
+		return j * (j - 1) / 2 + i;
+	}
+
+	/**
+	 *	searchALT()'s memory, one per thread and reused by every query. g is
+	 *	stamped instead of cleared, so a query only touches what it visits.
+	 */
+	struct AltScratch {
+		std::vector<int>					g;
+		std::vector<uint32_t>				stamp;
+		std::vector<std::pair<int, int>>	open;			// (f, tile) binary heap
+		uint32_t							gen		= 0;
+	};
+}
+
+
+/**
+ *	Constructor
+ *	@param mapArr - The level grid, 1 is a wall and everything else is walkable
+ */
+DistanceTable::DistanceTable(const std::vector<std::vector<int>>& mapArr) : grid(mapArr) {
+	height = (int)grid.size();
+	width  = height > 0 ? (int)grid[0].size() : 0;
+
+	index.assign(width * height, -1);
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			if (grid[y][x] == 1) continue;
+			index[y * width + x] = (int)tiles.size();
+			tiles.push_back({ x, y });
+		}
+	}
+	walkable = (int)tiles.size();
+	exact	 = walkable <= apspLimit;
+
+	// The neighbours never change, so the searches use this instead of the grid
+	neighbours.assign(walkable * 4, -1);
+	for (int i = 0; i < walkable; i++) {
+		for (int d = 0; d < 4; d++) {
+			int nx = tiles[i].first + dirX[d], ny = tiles[i].second + dirY[d];
+			if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+			neighbours[i * 4 + d] = index[ny * width + nx];
+		}
+	}
+
+	// Multi source BFS through walls too, so any target tile maps to a walkable one
+	nearest.assign(width * height, -1);
+	std::vector<int> queue;
+	for (int i = 0; i < walkable; i++) {
+		int cell = tiles[i].second * width + tiles[i].first;
+		nearest[cell] = i;
+		queue.push_back(cell);
+	}
+	for (size_t head = 0; head < queue.size(); head++) {
+		int cx = queue[head] % width, cy = queue[head] / width;
+		for (int d = 0; d < 4; d++) {
+			int nx = cx + dirX[d], ny = cy + dirY[d];
+			if (nx < 0 || ny < 0 || nx >= width || ny >= height || nearest[ny * width + nx] >= 0) continue;
+			nearest[ny * width + nx] = nearest[queue[head]];
+			queue.push_back(ny * width + nx);
+		}
+	}
+}
+
+/**
+ *	Destructor
+ */
+DistanceTable::~DistanceTable() {
+
+}
+
+/**
+ *	Walkable index of a tile, -1 for walls and tiles outside the map
+ */
+int DistanceTable::tileIndex(int x, int y) {
+	if (x < 0 || y < 0 || x >= width || y >= height) return -1;
+	return index[y * width + x];
+}
+
+/**
+ *	Closest walkable tile to any point, also outside the map.
+ *	Lets targets that land in walls (like the arcade ghosts' scatter corners)
+ *	be used with distance() without any searching.
+ */
+std::pair<int, int> DistanceTable::snap(int x, int y) {
+	if (walkable == 0) return { x, y };
+	x = std::max(0, std::min(width - 1, x));
+	y = std::max(0, std::min(height - 1, y));
+	return tiles[nearest[y * width + x]];
+}
+
+/**
+ *	Breadth first search from one walkable tile
+ *	@param dist  - Filled with the distance to every walkable tile (UINT32_MAX if unreachable)
+ *	@param queue - Scratch space, reused between calls
+ */
+void DistanceTable::bfs(int source, std::vector<uint32_t>& dist, std::vector<int>& queue) {
+	dist.assign(walkable, UINT32_MAX);
+	queue.resize(walkable);
+
+	int head = 0, tail = 0;
+	dist[source] = 0;
+	queue[tail++] = source;
+
+	while (head < tail) {
+		int current = queue[head++];
+		const int* next = &neighbours[current * 4];
+		for (int d = 0; d < 4; d++) {
+			if (next[d] < 0 || dist[next[d]] != UINT32_MAX) continue;
+			dist[next[d]] = dist[current] + 1;
+			queue[tail++] = next[d];
+		}
+	}
+}
+
+/**
+ *	Bakes the table for this level, using every core unless told otherwise
+ */
+void DistanceTable::bake(int threads) {
+	threads = threadCount(threads);
+	if (exact)	bakeAPSP(threads);
+	else		bakeALT(threads);
+	baked = true;
+}
+
+/**
+ *	One BFS per walkable tile, each source filling its own part of the triangle.
+ *	The table is built with 16 bit cells and narrowed to 8 bits when every
+ *	distance fits, which is the case for the classic levels.
+ */
+void DistanceTable::bakeAPSP(int threads) {
+	size_t cells = (size_t)walkable * (walkable - 1) / 2;
+	std::vector<uint16_t> wide(cells, INF);
+	std::vector<uint32_t> longest(threads, 0);
+
+	std::vector<std::vector<uint32_t>> dists(threads);
+	std::vector<std::vector<int>>	   queues(threads);
+
+	parallelFor(walkable, threads, [&](int worker, int source) {
+		std::vector<uint32_t>& dist = dists[worker];
+		bfs(source, dist, queues[worker]);
+
+		for (int j = source + 1; j < walkable; j++) {
+			if (dist[j] == UINT32_MAX) continue;
+			wide[triangle(source, j)] = (uint16_t)std::min<uint32_t>(dist[j], INF - 1);
+			longest[worker] = std::max(longest[worker], dist[j]);
+		}
+	});
+
+	cellBytes = *std::max_element(longest.begin(), longest.end()) < 0xFF ? 1 : 2;
+	apsp.resize(cells * cellBytes);
+
+	if (cellBytes == 1) {
+		for (size_t i = 0; i < cells; i++)
+			apsp[i] = wide[i] == INF ? 0xFF : (uint8_t)wide[i];
+	}
+	else
+		std::memcpy(apsp.data(), wide.data(), cells * sizeof(uint16_t));
+}
+
+/**
+ *	Picks landmarks on the edges of the map (corners and edge midpoints work well
+ *	for mazes) and runs one BFS per landmark in parallel.
+ */
+void DistanceTable::bakeALT(int threads) {
+	const int targets[landmarks][2] = {
+		{ 0, 0 },			{ width - 1, 0 },			{ 0, height - 1 },		{ width - 1, height - 1 },
+		{ width / 2, 0 },	{ width / 2, height - 1 },	{ 0, height / 2 },		{ width - 1, height / 2 }
+	};
+
+	// Nearest walkable tile to each target, skipping duplicates
+	landmarkTiles.clear();
+	for (int l = 0; l < landmarks; l++) {
+		int best = -1; long bestDist = 0;
+		for (int i = 0; i < walkable; i++) {
+			long dx = tiles[i].first - targets[l][0], dy = tiles[i].second - targets[l][1];
+			long d = dx * dx + dy * dy;
+			if (best < 0 || d < bestDist) { best = i; bestDist = d; }
+		}
+		if (best >= 0 && std::find(landmarkTiles.begin(), landmarkTiles.end(), best) == landmarkTiles.end())
+			landmarkTiles.push_back(best);
+	}
+
+	alt.assign(landmarkTiles.size() * walkable, INF);
+	std::vector<std::vector<uint32_t>> dists(threads);
+	std::vector<std::vector<int>>	   queues(threads);
+
+	parallelFor((int)landmarkTiles.size(), threads, [&](int worker, int l) {
+		bfs(landmarkTiles[l], dists[worker], queues[worker]);
+		uint16_t* row = &alt[(size_t)l * walkable];
+		for (int i = 0; i < walkable; i++)		// Saturating keeps the bound admissible
+			row[i] = (uint16_t)std::min<uint32_t>(dists[worker][i], INF);
+	});
+}
+
+/**
+ *	Exact walking distance between two tiles, -1 if there is no path.
+ *	O(1) with the all-pairs table, an ALT guided A* otherwise.
+ */
+int DistanceTable::distance(int x0, int y0, int x1, int y1) {
+	int from = tileIndex(x0, y0), to = tileIndex(x1, y1);
+	if (from < 0 || to < 0 || !baked) return -1;
+	if (from == to) return 0;
+
+	if (!exact) return searchALT(from, to);
+
+	size_t cell = triangle(from, to);
+	if (cellBytes == 1)
+		return apsp[cell] == 0xFF ? -1 : apsp[cell];
+
+	uint16_t value;
+	std::memcpy(&value, &apsp[cell * 2], sizeof(value));
+	return value == INF ? -1 : value;
+}
+
+/**
+ *	Lower bound of the walking distance, never more than the real one.
+ *	Exact for the all-pairs table, O(landmarks) for the ALT table.
+ */
+int DistanceTable::estimate(int x0, int y0, int x1, int y1) {
+	if (exact) {
+		int d = distance(x0, y0, x1, y1);
+		return d >= 0 ? d : std::abs(x1 - x0) + std::abs(y1 - y0);
+	}
+
+	int from = tileIndex(x0, y0), to = tileIndex(x1, y1);
+	int best = std::abs(x1 - x0) + std::abs(y1 - y0);
+	if (from < 0 || to < 0 || !baked) return best;
+
+	for (size_t l = 0; l < landmarkTiles.size(); l++) {
+		const uint16_t* row = &alt[l * walkable];
+		if (row[from] == INF && row[to] == INF) continue;
+		best = std::max(best, std::abs((int)row[from] - (int)row[to]));
+	}
+	return best;
+}
+
+/**
+ *	A* between two walkable tiles using the landmark heuristic
+ */
+int DistanceTable::searchALT(int from, int to) {
+	typedef std::pair<int, int> Entry;		// (f, tile)
+	static thread_local AltScratch scratch;
+	if (scratch.g.size() < (size_t)walkable) {
+		scratch.g.resize(walkable);
+		scratch.stamp.assign(walkable, 0);
+		scratch.gen = 0;
+	}
+	uint32_t gen = ++scratch.gen;
+	if (gen == 0) {											// Wrapped, old stamps could match again
+		std::fill(scratch.stamp.begin(), scratch.stamp.end(), 0);
+		gen = scratch.gen = 1;
+	}
+
+	auto h = [&](int tile) {
+		return estimate(tiles[tile].first, tiles[tile].second, tiles[to].first, tiles[to].second);
+	};
+	auto push = [&](int tile, int g) {
+		scratch.stamp[tile] = gen;
+		scratch.g[tile]		= g;
+		scratch.open.push_back({ g + h(tile), tile });
+		std::push_heap(scratch.open.begin(), scratch.open.end(), std::greater<Entry>());
+	};
+
+	scratch.open.clear();
+	push(from, 0);
+	while (!scratch.open.empty()) {
+		std::pop_heap(scratch.open.begin(), scratch.open.end(), std::greater<Entry>());
+		Entry top = scratch.open.back();
+		scratch.open.pop_back();
+		int current = top.second, g = scratch.g[current];
+		if (current == to) return g;
+		if (top.first - h(current) > g) continue;				// Stale entry
+
+		for (int d = 0; d < 4; d++) {
+			int next = neighbours[current * 4 + d];
+			if (next < 0) continue;
+			if (scratch.stamp[next] == gen && scratch.g[next] <= g + 1) continue;
+			push(next, g + 1);
+		}
+	}
+	return -1;
+}
+
+/**
+ *	Bytes used by the baked table
+ */
+size_t DistanceTable::getMemoryUsage() {
+	return apsp.size() + alt.size() * sizeof(uint16_t) + index.size() * sizeof(int)
+		 + neighbours.size() * sizeof(int) + nearest.size() * sizeof(int) + tiles.size() * sizeof(std::pair<int, int>);
+}
+
+/**
+ *	FNV-1a over the grid, so a table baked for an older version of a level is rejected
+ */
+uint32_t DistanceTable::gridHash() {
+	uint32_t hash = 2166136261u;
+	auto mix = [&](uint32_t value) {
+		for (int b = 0; b < 4; b++) { hash ^= (value >> (b * 8)) & 0xFF; hash *= 16777619u; }
+	};
+	mix(width); mix(height);
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++) mix(grid[y][x] == 1);
+	return hash;
+}
+
+/**
+ *	Writes the baked table, for the packer
+ *	@return true if everything was written
+ */
+bool DistanceTable::save(std::ostream& out) {
+	if (!baked) return false;
+
+	uint32_t header[7] = { fileVersion, (uint32_t)width, (uint32_t)height, gridHash(),
+						   (uint32_t)exact, (uint32_t)cellBytes, (uint32_t)landmarkTiles.size() };
+	out.write(fileMagic, sizeof(fileMagic));
+	out.write((const char*)header, sizeof(header));
+
+	if (exact) {
+		uint64_t size = apsp.size();
+		out.write((const char*)&size, sizeof(size));
+		out.write((const char*)apsp.data(), size);
+	}
+	else {
+		out.write((const char*)landmarkTiles.data(), landmarkTiles.size() * sizeof(int));
+		out.write((const char*)alt.data(), alt.size() * sizeof(uint16_t));
+	}
+	return (bool)out;
+}
+
+/**
+ *	Reads a table baked by save()
+ *	@return false if the file is missing, broken or was baked for a different grid
+ */
+bool DistanceTable::load(std::istream& in) {
+	if (!in) return false;
+
+	char	 magic[4];
+	uint32_t header[7];
+	in.read(magic, sizeof(magic));
+	in.read((char*)header, sizeof(header));
+	if (!in || std::memcmp(magic, fileMagic, sizeof(magic)) != 0 || header[0] != fileVersion
+		|| header[1] != (uint32_t)width || header[2] != (uint32_t)height || header[3] != gridHash()
+		|| header[4] != (uint32_t)exact)
+		return false;
+
+	if (exact) {
+		uint64_t size = 0;
+		in.read((char*)&size, sizeof(size));
+		cellBytes = (int)header[5];
+		if ((cellBytes != 1 && cellBytes != 2) || size != (uint64_t)walkable * (walkable - 1) / 2 * cellBytes)
+			return false;
+		apsp.resize(size);
+		in.read((char*)apsp.data(), size);
+	}
+	else {
+		if (header[6] > (uint32_t)landmarks) return false;
+		landmarkTiles.resize(header[6]);
+		alt.resize((size_t)header[6] * walkable);
+		in.read((char*)landmarkTiles.data(), landmarkTiles.size() * sizeof(int));
+		in.read((char*)alt.data(), alt.size() * sizeof(uint16_t));
+
+		// The landmarks index the walkable tiles, a broken file mustn't send the search outside them
+		for (int tile : landmarkTiles)
+			if (tile < 0 || tile >= walkable) return false;
+	}
+
+	baked = (bool)in;
+	return baked;
+}
+
+/**
+ *	Loads the table the packer baked for a level, or bakes it here if the
+ *	pack has none or it was baked for a different grid
+ *	@param name - The level's name in the pack, the table is <name>.dist
+ */
+bool DistanceTable::loadOrBake(const std::string& name) {
+	AssetStream in(name + ".dist");
+	if (load(in)) return true;
+
+	bake();
+	return baked;
+}
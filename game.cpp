@@ -0,0 +1,174 @@
+#include <cstring>
+
+#include "headers/game.h"
+#include "headers/parallel.h"
+
+
+/**
+ *	Constructor
+ *	@param seed			- Decides where the ghosts spawn and which way they wander
+ *	@param headless		- Simulate only, no GL objects (no window needed)
+ *	@param cooperative	- Ghosts chase pacman together (WHCA*) instead of by personality
+ */
+Game::Game(const std::string& levelPath, uint32_t seed, int ghostAmount, bool headless, bool cooperative)
+	: levelPath(levelPath), seed(seed), cooperative(cooperative),
+	  map(levelPath, headless), distances(map.getMapArray()),
+	  planner(map.getMapArray(), &distances), pacman(&map) {
+
+	pelletTotal = map.getp_count();
+
+	// Tile distances for ghost targeting, baked into the pack by the packer
+	distances.loadOrBake(levelPath);
+
+	for (int i = 0; i < ghostAmount; i++) {
+		Ghosts* ghost = new Ghosts(&map);
+		ghost->initGhost(seed + i);
+
+		// Each ghost gets one of the arcade personalities, they share the mode timers
+		ghost->setBrain((Personality)(i % (WANDERER + 1)), &distances, &modes, &targets);
+
+		// Ghosts reserve the tiles they plan to walk on, so they spread out instead of stacking
+		if (cooperative) ghost->setPlanner(&planner);
+		ghosts.push_back(ghost);
+	}
+	save(start);
+}
+
+/**
+ *	Destructor
+ */
+Game::~Game() {
+	for (auto ghost : ghosts) delete ghost;
+}
+
+/**
+ *	Advances the game one tick
+ */
+void Game::tick(const InputFrame& input) {
+	done = pacman.movement(input, step, ghosts, done);
+
+	targets.pacTile	   = pacman.coordsToTile(pacman.getPacPos().first, pacman.getPacPos().second - 1.f);
+	targets.pacDir	   = pacman.getDirection();
+	targets.chaserTile = ghosts.empty() ? targets.pacTile : ghosts[0]->getTile();
+	modes.update();
+
+	if (cooperative && !ghosts.empty()) {
+		// One planner step is the time a ghost takes to walk one tile
+		if (!done) {
+			planClock += step * ghosts[0]->getSpeed();
+			while (planClock >= 1.0) {
+				for (int i = 0; i < planner.getAgentCount(); i++)
+					planner.setGoal(i, targets.pacTile.first, targets.pacTile.second);
+				planner.update();
+				planClock -= 1.0;
+			}
+		}
+		for (auto ghost : ghosts) ghost->followPlan(planClock, done);
+	}
+	else if ((int)ghosts.size() >= parallelGhosts)
+		// Ghosts only read what they share (map, distances, modes, targets), so they can all move at once
+		parallelFor((int)ghosts.size(), threadCount(), [&](int, int i) { ghosts[i]->movement(step, done); });
+	else
+		for (auto ghost : ghosts) ghost->movement(step, done);
+
+	ticks++;
+}
+
+/**
+ *	Hash of everything that moves, for checking two runs ended up the same
+ */
+uint64_t Game::checksum() {
+	uint64_t hash = 14695981039346656037ull;
+	auto mix = [&](const void* data, size_t size) {
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++) { hash ^= bytes[i]; hash *= 1099511628211ull; }
+	};
+
+	std::pair<float, float> pac = pacman.getPacPos();
+	mix(&ticks, sizeof(ticks));
+	mix(&pac.first, sizeof(float));
+	mix(&pac.second, sizeof(float));
+	mix(&done, sizeof(done));
+
+	for (auto ghost : ghosts) {
+		std::pair<float, float> pos = ghost->getGhostPos(0);
+		mix(&pos.first, sizeof(float));
+		mix(&pos.second, sizeof(float));
+	}
+
+	int pellets = map.getp_count();
+	mix(&pellets, sizeof(pellets));
+	for (int y = 0; y < map.getHeight(); y++)
+		for (int x = 0; x < map.getWidth(); x++) {
+			bool pellet = map.getPellet(x, y);
+			mix(&pellet, sizeof(pellet));
+		}
+	return hash;
+}
+
+/**
+ *	Copies the game into a snapshot.
+ *	The cooperative planner's reservations are not plain data, so games
+ *	using it can't be saved.
+ *	@return false if the game doesn't fit in a GameState
+ */
+bool Game::save(GameState& state) {
+	if (cooperative || ghosts.size() > GameState::maxGhosts || map.getPelletWords() > GameState::maxTiles / 64)
+		return false;
+
+	state.tick		  = ticks;
+	state.width		  = map.getWidth();
+	state.height	  = map.getHeight();
+	state.done		  = done;
+	state.modes		  = modes;
+	state.ghostCount  = (int32_t)ghosts.size();
+	state.pelletCount = map.getp_count();
+	pacman.saveState(state.pacman);
+	for (size_t i = 0; i < ghosts.size(); i++) ghosts[i]->saveState(state.ghosts[i]);
+	memcpy(state.pellets, map.getPelletBits(), map.getPelletWords() * sizeof(uint64_t));
+	return true;
+}
+
+/**
+ *	Puts the game back to a snapshot taken by save()
+ *	@return false if the snapshot is from another level or ghost count
+ */
+bool Game::restore(const GameState& state) {
+	if (cooperative || state.width != (uint32_t)map.getWidth() || state.height != (uint32_t)map.getHeight()
+		|| state.ghostCount != (int32_t)ghosts.size())
+		return false;
+
+	ticks = state.tick;
+	done  = state.done;
+	modes = state.modes;
+	pacman.loadState(state.pacman);
+	for (size_t i = 0; i < ghosts.size(); i++) ghosts[i]->loadState(state.ghosts[i]);
+	map.loadPellets(state.pellets, state.pelletCount);
+	return true;
+}
+
+/**
+ *	Starts the game over with the ghosts spawned from another seed
+ *	@return false for games that can't be saved (see save())
+ */
+bool Game::reset(uint32_t seed) {
+	if (!restore(start)) return false;
+
+	this->seed = seed;
+	for (size_t i = 0; i < ghosts.size(); i++) ghosts[i]->spawn(seed + i);
+	return true;
+}
+
+/**
+ *	Switches pacman and the ghosts between float and fixed point movement.
+ *	The cooperative ghosts follow their plan in floats, so they stay as they are.
+ *	@return false for cooperative games
+ */
+bool Game::setFixedPoint(bool fixedPoint) {
+	if (cooperative) return false;
+
+	this->fixedPoint = fixedPoint;
+	pacman.setFixedPoint(fixedPoint);
+	for (auto ghost : ghosts) ghost->setFixedPoint(fixedPoint);
+	return true;
+}
@@ -0,0 +1,52 @@
+#include <cstring>
+
+#include "headers/gamestate.h"
+
+
+/**
+ *	Constructor
+ *	@param capacity - How many snapshots are kept, 10 seconds of ticks by default
+ */
+SnapshotRing::SnapshotRing(int capacity) {
+	slots.resize(capacity > 0 ? capacity : 1);
+}
+
+/**
+ *	Makes room for a new snapshot
+ *	@return The slot to write it into, valid until the ring wraps around
+ */
+GameState& SnapshotRing::push() {
+	GameState& slot = slots[head];
+	head = (head + 1) % (int)slots.size();
+	if (size < (int)slots.size()) size++;
+	return slot;
+}
+
+/**
+ *	Copies a snapshot in
+ */
+void SnapshotRing::push(const GameState& state) {
+	memcpy(&push(), &state, sizeof(GameState));
+}
+
+/**
+ *	Takes the newest snapshot out
+ *	@return false if the ring is empty
+ */
+bool SnapshotRing::pop(GameState& state) {
+	if (size == 0) return false;
+
+	head = (head + (int)slots.size() - 1) % (int)slots.size();
+	size--;
+	memcpy(&state, &slots[head], sizeof(GameState));
+	return true;
+}
+
+/**
+ *	@param age - 0 for the newest snapshot, 1 for the one before it...
+ *	@return nullptr if there are not that many
+ */
+const GameState* SnapshotRing::peek(int age) {
+	if (age < 0 || age >= size) return nullptr;
+	return &slots[(head + (int)slots.size() - 1 - age) % (int)slots.size()];
+}
@@ -0,0 +1,74 @@
+#include <cstdlib>
+
+#include "headers/ghostai.h"
+#include "headers/distances.h"
+
+const int GhostModes::schedule[8] = { 7, 20, 7, 20, 5, 20, 5, -1 };
+
+
+/**
+ *	Constructor
+ */
+GhostModes::GhostModes() {
+	phaseTicks = schedule[0] * ticksPerSecond;
+}
+
+/**
+ *	Advances the schedule one tick
+ */
+void GhostModes::update() {
+	tick++;
+
+	if (schedule[phase] < 0 || --phaseTicks > 0) return;
+	phase++;
+	phaseTicks = schedule[phase] * ticksPerSecond;
+	reversals++;
+}
+
+GhostMode GhostModes::getMode() {
+	return phase % 2 == 0 ? SCATTER : CHASE;
+}
+
+
+/**
+ *	The tile a ghost is heading for. Targets can be walls or even outside the
+ *	map, the caller snaps them to the closest walkable tile.
+ *	@param self - The tile the ghost stands on
+ */
+std::pair<int, int> ghostTarget(Personality personality, GhostMode mode, const GhostTargets& targets,
+								std::pair<int, int> self, int width, int height, DistanceTable* distances) {
+	// Each ghost has its own corner to scatter to
+	std::pair<int, int> corner;
+	switch (personality) {
+	case CHASER:	corner = { width - 1, 0 };			break;
+	case AMBUSHER:	corner = { 0, 0 };					break;
+	case FLANKER:	corner = { width - 1, height - 1 };	break;
+	default:		corner = { 0, height - 1 };			break;
+	}
+	if (mode == SCATTER) return corner;
+
+	int aheadX = 0, aheadY = 0;
+	switch (targets.pacDir) {
+	case 'U': aheadY = -1; break;
+	case 'D': aheadY = 1;  break;
+	case 'L': aheadX = -1; break;
+	case 'R': aheadX = 1;  break;
+	}
+	std::pair<int, int> pac = targets.pacTile;
+
+	switch (personality) {
+	case AMBUSHER:
+		return { pac.first + 4 * aheadX, pac.second + 4 * aheadY };
+	case FLANKER: {
+		int pivotX = pac.first + 2 * aheadX, pivotY = pac.second + 2 * aheadY;
+		return { 2 * pivotX - targets.chaserTile.first, 2 * pivotY - targets.chaserTile.second };
+	}
+	case SHY: {
+		int d = distances ? distances->estimate(self.first, self.second, pac.first, pac.second)
+						  : std::abs(self.first - pac.first) + std::abs(self.second - pac.second);
+		return d > 8 ? pac : corner;
+	}
+	default:
+		return pac;
+	}
+}
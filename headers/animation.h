@@ -0,0 +1,58 @@
+#ifndef ANIMATION_H // include guard
+#define ANIMATION_H
+#include <cstdint>
+
+
+/**
+ *	A cell of a sprite sheet cut into an even grid, counted from the top left
+ */
+struct SpriteFrame {
+	uint8_t								column,
+										row;
+};
+
+/**
+ *	Frames played one after another, frameTime seconds each, then from the
+ *	start again. Picking the frame is all there is to animating a sprite:
+ *	SpriteBatch::sprite() turns it into the quad's texture coordinates as
+ *	the quad is written, the sprite shader only samples.
+ */
+struct SpriteAnimation {
+	const SpriteFrame*					frames;
+	int									count;
+	float								frameTime;
+
+	constexpr SpriteFrame frameAt(double time) const {
+		return frames[time <= 0.0 ? 0 : (int64_t)(time / frameTime) % count];
+	}
+};
+
+
+/**
+ *	pacman.png: 6 columns by 4 rows, a row per heading. The mouth opens
+ *	over the first 4 columns and closes again.
+ */
+namespace PacmanSheet {
+	constexpr int						columns		= 6,
+										rows		= 4;
+	constexpr float						frameTime	= 0.5f;
+
+	constexpr SpriteFrame				up[]		= { { 0, 1 }, { 1, 1 }, { 2, 1 }, { 3, 1 }, { 2, 1 }, { 1, 1 } },
+										down[]		= { { 0, 0 }, { 1, 0 }, { 2, 0 }, { 3, 0 }, { 2, 0 }, { 1, 0 } },
+										left[]		= { { 0, 2 }, { 1, 2 }, { 2, 2 }, { 3, 2 }, { 2, 2 }, { 1, 2 } },
+										right[]		= { { 0, 3 }, { 1, 3 }, { 2, 3 }, { 3, 3 }, { 2, 3 }, { 1, 3 } };
+
+	constexpr SpriteAnimation			walkUp		= { up,	   6, frameTime },
+										walkDown	= { down,  6, frameTime },
+										walkLeft	= { left,  6, frameTime },
+										walkRight	= { right, 6, frameTime };
+
+	/**
+	 *	@return The walk cycle for a heading ('U', 'D', 'L' or 'R')
+	 */
+	constexpr const SpriteAnimation& walking(char direction) {
+		return direction == 'U' ? walkUp : direction == 'D' ? walkDown : direction == 'L' ? walkLeft : walkRight;
+	}
+}
+
+#endif /* ANIMATION_H */
@@ -0,0 +1,99 @@
+#ifndef ASSETS_H // include guard
+#define ASSETS_H
+#include <glad/glad.h>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "jobs.h"
+#include "texture.h"
+
+
+/**
+ *	Loads textures and models without holding up the GL thread.
+ *
+ *	Decoding runs as jobs on the job system: textures come as the mip
+ *	chains the packer made (or, when there is no pack, PNGs decoded by
+ *	stb_image in a job each and built into a chain by a job waiting on
+ *	them), models as OBJ through tinyobjloader. update(), called once per
+ *	frame on the GL thread, then streams whatever has been decoded to the
+ *	GPU, at most uploadBudget bytes per frame: every mip level goes through
+ *	a pixel buffer object, model vertices are written straight into their
+ *	mapped vertex buffer. Textures are always array textures, so several
+ *	images can share one and be drawn without rebinding.
+ *	The loader owns every GL object it makes, until release().
+ */
+class AssetLoader {
+public:
+	enum State { QUEUED, DECODED, UPLOADING, READY, FAILED };
+
+	/**
+	 *	Where an image ended up in its array texture
+	 */
+	struct Layer {
+		int								layer		= 0;
+		float							scaleU		= 1.f,	// Multiply the image's texture coordinates by these
+										scaleV		= 1.f,
+										offsetU		= 0.f,	// Then add these
+										offsetV		= 0.f;
+	};
+
+	AssetLoader							(JobSystem& jobs, size_t uploadBudget = 4 << 20);
+	~AssetLoader						();
+
+	int  loadTexture					(const std::string& path);
+	int  loadTextures					(const std::string& name, const std::vector<std::string>& images);
+	int  loadModel						(const std::string& path);
+	void update							();
+	void release						();
+
+	bool  isDone						();
+	float getProgress					();
+	State getState						(int asset)				{ return (State)assets[asset]->state.load(); }
+	GLuint getTexture					(int asset)				{ return assets[asset]->texture;	}
+	Layer getLayer						(int asset, int image)	{ return assets[asset]->layers[image]; }
+	GLuint getModel						(int asset)				{ return assets[asset]->vao;		}
+	int	  getModelVertices				(int asset)				{ return (int)(assets[asset]->data.size() / (modelFloats * sizeof(float))); }
+
+	static constexpr int				modelFloats = 8;	// Position, normal, texture coordinates
+
+private:
+	struct Asset {
+		std::string						path;
+		std::vector<std::string>		images;				// What goes in the layers of a texture
+		bool							model		= false;
+		std::atomic<int>				state		{ QUEUED };
+
+		// Filled in by the decode jobs
+		MipChain						mips;				// Texture levels, parsed out of the pack or built
+		bool							packed		= false;	// The pack held the levels, nothing to decode
+		std::vector<MipChain::Image>	decoded;			// Images to build the levels out of otherwise
+		std::vector<Layer>				layers;				// One per image
+		std::vector<unsigned char>		data;				// Model vertex floats
+
+		// GL side
+		GLuint							texture		= 0,
+										vao			= 0,
+										vbo			= 0,
+										staging		= 0;	// Pixel buffer for texture uploads
+		size_t							uploaded	= 0;	// Bytes sent so far
+	};
+
+	bool findLayers						(Asset& asset);
+	void parseTexture					(Asset& asset);
+	void decodeImage					(Asset& asset, size_t index);
+	void buildTexture					(Asset& asset);
+	void decodeModel					(Asset& asset);
+	void beginUpload					(Asset& asset);
+	size_t uploadChunk					(Asset& asset, size_t budget);
+	size_t uploadSize					(Asset& asset);
+
+	JobSystem&							jobs;
+	size_t								uploadBudget;
+	std::vector<std::unique_ptr<Asset>>	assets;
+	std::vector<JobSystem::TaskHandle>	decoding;
+};
+
+#endif /* ASSETS_H */
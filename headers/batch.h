@@ -0,0 +1,90 @@
+#ifndef BATCH_H // include guard
+#define BATCH_H
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "animation.h"
+#include "assets.h"
+#include "stream.h"
+
+
+/**
+ *	font.png: ASCII from ' ' on, 16 glyphs to a row. Glyphs are 5x7 in the
+ *	top left of their 8x8 cell, so cells can be drawn next to each other.
+ */
+namespace FontSheet {
+	constexpr int						columns		= 16,
+										rows		= 6;
+	constexpr char						first		= ' ';
+	constexpr float						advance		= 6.f / 8.f;	// Of a cell, from one character to the next
+}
+
+
+/**
+ *	Draws every 2D quad of a frame (sprites, HUD text, icons) in as few
+ *	calls as there are passes.
+ *
+ *	Quads are written straight into the frame's part of the StreamBuffer,
+ *	which begin() takes. flush() draws everything added since the last
+ *	flush with one glDrawElementsBaseVertex(), so a frame with the world
+ *	sprites and the HUD is 2 draws, whatever is on screen.
+ *
+ *	Texture coordinates are worked out here, from the array texture layer
+ *	and the sheet's frame, so the shader only samples.
+ */
+class SpriteBatch {
+public:
+	SpriteBatch							(int maxQuads = 2048);
+	~SpriteBatch						();
+
+	bool init							(GLuint shader, StreamBuffer& stream);
+	void release						();
+
+	void begin							();
+	void flush							(const glm::mat4& projection, const glm::mat4& view = glm::mat4(1));
+
+	void quad							(float x0, float y0, float x1, float y1, const AssetLoader::Layer& image,
+										 float u0 = 0.f, float v0 = 0.f, float u1 = 1.f, float v1 = 1.f,
+										 uint32_t colour = 0xFFFFFFFF, float z = 0.f);
+	void sprite							(float x0, float y0, float x1, float y1, const AssetLoader::Layer& image,
+										 int columns, int rows, SpriteFrame frame, uint32_t colour = 0xFFFFFFFF, float z = 0.f);
+	float text							(const std::string& text, float x, float y, float size, uint32_t colour = 0xFFFFFFFF);
+	static float textWidth				(const std::string& text, float size);
+
+	void setFont						(const AssetLoader::Layer& font)	{ this->font = font; }
+	int  getQuads						()						{ return count;			}
+	int  getDraws						()						{ return draws;			}
+
+	/**
+	 *	@return An RGBA colour for quad(), sprite() and text()
+	 */
+	static constexpr uint32_t rgba(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) {
+		return (uint32_t)r | (uint32_t)g << 8 | (uint32_t)b << 16 | (uint32_t)a << 24;
+	}
+
+private:
+	struct Vertex {
+		float							x, y, z,
+										u, v;
+		int32_t							layer;
+		uint32_t						colour;				// RGBA, a byte each
+	};
+
+	int									maxQuads;
+	GLuint								shader		= 0,
+										vao			= 0,
+										ebo			= 0;
+	StreamBuffer*						stream		= nullptr;
+	StreamBuffer::Range					range;					// This frame's quads
+	Vertex*								vertices	= nullptr;	// Where they are written
+	int									count		= 0,		// Quads this frame
+										flushed		= 0,		// Quads already drawn this frame
+										draws		= 0;		// Draw calls this frame
+	AssetLoader::Layer					font;
+};
+
+#endif /* BATCH_H */
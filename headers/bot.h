@@ -0,0 +1,65 @@
+#ifndef BOT_H // include guard
+#define BOT_H
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "game.h"
+#include "gamestate.h"
+#include "input.h"
+
+
+/**
+ *	Monte Carlo tree search player for pacman.
+ *
+ *	Every decision picks one of four headings and holds it for a few ticks.
+ *	Searches start from a GameState and play the game forward by restoring
+ *	that state into headless games, one per thread. The threads each grow
+ *	their own tree (root parallelism) and their root visit counts are added
+ *	up to pick the move, so no tree is ever shared between threads.
+ */
+class MctsBot {
+public:
+	static constexpr int				actions			= 4;	// Headings, see headingInput()
+
+	MctsBot								(const std::string& levelPath, uint32_t seed, int ghostAmount, int threads = 0);
+	~MctsBot							();
+
+	int  think							(const GameState& root, int rollouts);
+
+	int		 getThreads					()						{ return (int)workers.size(); }
+	int		 getDecisionTicks			()						{ return decisionTicks;	}
+	uint64_t getRollouts				()						{ return rollouts;		}
+	double	 getRolloutsPerSecond		();
+
+private:
+	struct Node {
+		int								children[actions]	= { -1, -1, -1, -1 },
+										parent		= -1,
+										visits		= 0;
+		float							value		= 0.f;	// Sum of rewards
+	};
+
+	struct Worker {
+		std::unique_ptr<Game>			game;
+		std::vector<Node>				tree;
+		GhostRng						rng;
+		int								rootVisits[actions],
+										completed;			// Playouts the last search() got through
+	};
+
+	void search							(Worker& worker, const GameState& root, int rollouts);
+	bool play							(Worker& worker, int action);
+	float rollout						(Worker& worker, int rootPellets);
+
+	int									decisionTicks	= 6,		// Ticks a heading is held for
+										rolloutDepth	= 30;		// Random decisions after leaving the tree
+	float								exploration		= 0.7f,		// UCT constant
+										pelletScale		= 8.f;		// Pellets eaten for 3/4 of the food reward
+	std::vector<Worker>					workers;
+	uint64_t							rollouts		= 0;
+	double								seconds			= 0.0;		// Time spent thinking
+};
+
+#endif /* BOT_H */
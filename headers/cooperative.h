@@ -0,0 +1,101 @@
+#ifndef COOPERATIVE_H // include guard
+#define COOPERATIVE_H
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class DistanceTable;
+
+
+/**
+ *	Which agent occupies which tile at which step.
+ *	Keys are (x, y, step) packed into 64 bits, every agent remembers its own
+ *	keys so its whole plan can be released in one go before it replans.
+ *	The tile an agent's plan ends on stays parked for it from then on, so
+ *	nobody plans into it while the agent is past the end of its window.
+ */
+class ReservationTable {
+public:
+	void reserve						(int x, int y, int step, int agent);
+	void park							(int x, int y, int step, int agent);
+	void release						(int agent);
+	int  owner							(int x, int y, int step);
+	size_t getSize						()						{ return cells.size(); }
+
+private:
+	static uint64_t key					(int x, int y, int step) {
+		return ((uint64_t)(uint32_t)step << 40) | ((uint64_t)(y & 0xFFFFF) << 20) | (uint64_t)(x & 0xFFFFF);
+	}
+
+	std::unordered_map<uint64_t, int>	cells;
+	std::unordered_map<uint64_t, std::pair<int, int>> parked;	// (x, y) -> (agent, from step)
+	std::vector<std::vector<uint64_t>>	byAgent;
+	std::vector<uint64_t>				parkedBy;
+};
+
+
+/**
+ *	Windowed Hierarchical Cooperative A* (WHCA*) for a group of agents.
+ *
+ *	Every agent plans `window` steps ahead in space-time, avoiding the tiles
+ *	(and head-on swaps) other agents have reserved, and then reserves its own
+ *	path. Beyond the window the true distance to the goal is used as the
+ *	remaining cost. Agents replan when half their window is used up, and the
+ *	replans are staggered so only about agents / (window / 2) searches run
+ *	per step no matter how many agents there are.
+ */
+class CooperativePlanner {
+public:
+	CooperativePlanner					(const std::vector<std::vector<int>>& mapArr,
+										 DistanceTable* distances = nullptr, int window = 8);
+	~CooperativePlanner					();
+
+	int  addAgent						(int x, int y);
+	void setGoal						(int agent, int x, int y);
+	void update							();
+
+	std::pair<int, int> getTile			(int agent, int ahead = 0);
+	int  getStep						()						{ return step;			}
+	int  getWindow						()						{ return window;		}
+	int  getAgentCount					()						{ return (int)agents.size(); }
+	int  getReplans						()						{ return replans;		}
+	ReservationTable& getReservations	()						{ return reservations;	}
+
+private:
+	struct Agent {
+		int								goalX		= 0,
+										goalY		= 0,
+										planStart	= 0,		// Step of plan[0]
+										replanAt	= 0;
+		std::vector<std::pair<int, int>>plan;
+	};
+
+	struct SearchNode {
+		int								x, y, t, g, parent;
+	};
+
+	void replan							(int agent);
+	bool canWait						(int agent, int x, int y, int from);
+	int  heuristic						(int x, int y, int goalX, int goalY);
+	bool isWalkable						(int x, int y);
+
+	int									width		= 0,
+										height		= 0,
+										window		= 8,
+										step		= 0,
+										replans		= 0,
+										maxExpand	= 2048;		// Search budget per replan
+	std::vector<uint8_t>				walls;
+	DistanceTable*						distances;
+	ReservationTable					reservations;
+	std::vector<Agent>					agents;
+
+	// Search memory, reused by every replan
+	std::vector<SearchNode>				pool;
+	std::vector<std::pair<int, int>>	open;					// (f, node) binary heap
+	std::unordered_map<uint64_t, int>	visited;
+};
+
+#endif /* COOPERATIVE_H */
@@ -0,0 +1,72 @@
+#ifndef CULLING_H // include guard
+#define CULLING_H
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include "stream.h"
+
+
+/**
+ *	The 6 planes of a camera's view, taken from the rows of projection * view
+ *	(Gribb & Hartmann). A point is inside where a * x + b * y + c * z + d >= 0
+ *	for every plane; the planes are normalised, so that is a distance and
+ *	spheres can be tested too.
+ */
+struct Frustum {
+	float								planes[6][4];
+
+	Frustum								(const glm::mat4& projection, const glm::mat4& view);
+
+	void apply							(GLuint program) const;
+};
+
+
+/**
+ *	Culls the instances of one model on the GPU.
+ *
+ *	cull() runs a compute shader over the instances' transformations (a
+ *	range of the stream buffer, or a buffer the GPU filled itself like
+ *	GhostSwarm's): every one whose bounding sphere is in the frustum is
+ *	appended to a buffer of visible transformations, and its atomic
+ *	counter is the instance count of an indirect draw command. The model
+ *	is then drawn with glDrawArraysIndirect() from that command and that
+ *	buffer, the CPU never sees which instances were visible.
+ */
+class InstanceCulling {
+public:
+	/**
+	 *	The command glDrawArraysIndirect() reads, this layout exactly
+	 */
+	struct DrawCommand {
+		GLuint							count,
+										instanceCount,
+										first,
+										baseInstance;
+	};
+
+	InstanceCulling						();
+	~InstanceCulling					();
+
+	bool init							(GLuint cullShader);
+	void release						();
+
+	void cull							(StreamBuffer& stream, const StreamBuffer::Range& transforms, int count,
+										 const Frustum& frustum, float radius, GLuint vertices, GLuint first = 0);
+	void cull							(GLuint transforms, int count,
+										 const Frustum& frustum, float radius, GLuint vertices, GLuint first = 0);
+
+	GLuint getVisible					()						{ return visible;	}	// Shader storage, one mat4 per instance drawn
+	GLuint getCommand					()						{ return command;	}	// GL_DRAW_INDIRECT_BUFFER
+
+private:
+	bool begin							(int count, GLuint vertices, GLuint first);
+	void dispatch						(int count, const Frustum& frustum, float radius);
+
+	GLuint								shader		= 0,
+										visible		= 0,
+										command		= 0;
+	int									capacity	= 0;		// Transformations visible can hold
+};
+
+#endif /* CULLING_H */
@@ -0,0 +1,73 @@
+#ifndef DISTANCES_H // include guard
+#define DISTANCES_H
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/**
+ *	Tile-to-tile walking distances on a level grid.
+ *
+ *	Small levels (up to apspLimit walkable tiles) get an exact all-pairs table,
+ *	stored as the upper triangle of the distance matrix in 8 or 16 bit cells.
+ *	Bigger levels get an ALT table instead: distances from a few landmark tiles
+ *	to every tile, which gives an admissible lower bound for any pair.
+ *	Both are baked by the packer into the asset pack, as <level>.dist; a
+ *	level the pack has no table for is baked when it is loaded.
+ */
+class DistanceTable {
+public:
+	static constexpr uint16_t			INF			= 0xFFFF;	// Unreachable / unknown
+	static constexpr int				apspLimit	= 4096;		// Max walkable tiles for the exact table
+	static constexpr int				landmarks	= 8;		// Landmarks used by the ALT table
+
+	DistanceTable						(const std::vector<std::vector<int>>& mapArr);
+	~DistanceTable						();
+
+	void bake							(int threads = 0);
+	bool load							(std::istream& in);
+	bool save							(std::ostream& out);
+	bool loadOrBake						(const std::string& name);
+
+	int  distance						(int x0, int y0, int x1, int y1);
+	int  estimate						(int x0, int y0, int x1, int y1);
+	std::pair<int, int> snap			(int x, int y);
+
+	bool isExact						()						{ return exact;		}
+	bool isBaked						()						{ return baked;		}
+	int  getWalkable					()						{ return walkable;	}
+	int  getWidth						()						{ return width;		}
+	int  getHeight						()						{ return height;	}
+	int  tileIndex						(int x, int y);
+	std::pair<int, int> tileCoords		(int index)				{ return tiles[index]; }
+	size_t getMemoryUsage				();
+
+private:
+	void bfs							(int source, std::vector<uint32_t>& dist,
+										 std::vector<int>& queue);
+	void bakeAPSP						(int threads);
+	void bakeALT						(int threads);
+	int  searchALT						(int from, int to);
+	uint32_t gridHash					();
+
+	int									width		= 0,
+										height		= 0,
+										walkable	= 0,
+										cellBytes	= 1;		// 1 or 2 bytes per APSP cell
+	bool								exact		= false,
+										baked		= false;
+	std::vector<std::vector<int>>		grid;
+	std::vector<int>					index;					// Tile -> walkable index, -1 for walls
+	std::vector<std::pair<int, int>>	tiles;					// Walkable index -> tile
+	std::vector<int>					neighbours;				// 4 per walkable tile, -1 if blocked
+	std::vector<int>					nearest;				// Tile -> closest walkable index
+
+	std::vector<uint8_t>				apsp;					// Upper triangle, row major
+	std::vector<int>					landmarkTiles;
+	std::vector<uint16_t>				alt;					// landmarks x walkable, saturating
+};
+
+#endif /* DISTANCES_H */
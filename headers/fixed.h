@@ -0,0 +1,23 @@
+#ifndef FIXED_H // include guard
+#define FIXED_H
+#include <cmath>
+#include <cstdint>
+
+
+/**
+ *	Fixed point numbers for deterministic movement, in 1/fixedOne tile units.
+ *	Integer adds and compares give the same result on every machine, and
+ *	every value converts to a float and back without loss (for levels
+ *	under 4096 tiles across), so float copies of positions stay exact.
+ */
+typedef int32_t fixed_t;
+
+constexpr int		fixedShift	= 12;
+constexpr fixed_t	fixedOne	= 1 << fixedShift;		// One tile
+
+inline fixed_t toFixed		(float value)			{ return (fixed_t)std::lround(value * fixedOne); }
+inline float   fixedToFloat	(fixed_t value)			{ return value / (float)fixedOne; }
+inline int	   fixedFloor	(fixed_t value)			{ return value >> fixedShift; }
+inline int	   fixedCeil	(fixed_t value)			{ return (value + fixedOne - 1) >> fixedShift; }
+
+#endif /* FIXED_H */
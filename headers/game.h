@@ -0,0 +1,79 @@
+#ifndef GAME_H // include guard
+#define GAME_H
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+#include "map.h"
+#include "sprites.h"
+#include "distances.h"
+#include "cooperative.h"
+#include "gamestate.h"
+#include "ghostai.h"
+#include "input.h"
+
+
+/**
+ *	One game of pacman: the level, pacman, the ghosts and everything that
+ *	steers them, advanced one fixed tick at a time.
+ *
+ *	Nothing in here reads the keyboard or the clock, the same seed and the
+ *	same inputs always give the same game. With headless set no GL objects
+ *	are made, so games can be simulated without a window. save() and
+ *	restore() move the whole changing part of the game in and out of a
+ *	GameState. setFixedPoint() switches pacman and the ghosts to integer
+ *	movement, which gives the same game on any compiler and CPU.
+ */
+class Game {
+public:
+	static constexpr double				step = 1.0 / GhostModes::ticksPerSecond;	// Seconds per tick
+	static constexpr int				parallelGhosts = 64;	// Ghosts it takes before they move on the job system
+
+	Game								(const std::string& levelPath, uint32_t seed, int ghostAmount,
+										 bool headless = false, bool cooperative = false);
+	~Game								();
+
+	void tick							(const InputFrame& input);
+	uint64_t checksum					();
+	bool save							(GameState& state);
+	bool restore						(const GameState& state);
+	bool reset							(uint32_t seed);
+	bool setFixedPoint					(bool fixedPoint);
+
+	Map&				  getMap		()						{ return map;		}
+	Pacman&				  getPacman		()						{ return pacman;	}
+	std::vector<Ghosts*>& getGhosts		()						{ return ghosts;	}
+	DistanceTable&		  getDistances	()						{ return distances;	}
+	GhostModes&			  getModes		()						{ return modes;		}
+	const std::string&	  getLevelPath	()						{ return levelPath;	}
+	uint32_t			  getSeed		()						{ return seed;		}
+	uint32_t			  getTick		()						{ return ticks;		}
+	int					  getPelletTotal()						{ return pelletTotal; }
+	bool				  isDone		()						{ return done;		}
+	bool				  isCleared		()						{ return map.getp_count() <= 0; }	// Pacman stops once every pellet is eaten
+	bool				  isCooperative	()						{ return cooperative; }
+	bool				  isFixedPoint	()						{ return fixedPoint; }
+	double				  getPlanClock	()						{ return planClock;	}
+
+private:
+	std::string							levelPath;
+	uint32_t							seed;
+	bool								cooperative,
+										fixedPoint	= false,
+										done		= false;
+	uint32_t							ticks		= 0;
+	int									pelletTotal	= 0;		// Pellets in the level when it was loaded
+	double								planClock	= 0.0;		// How far into the current planner step we are
+
+	Map									map;
+	DistanceTable						distances;
+	GhostModes							modes;
+	GhostTargets						targets;
+	CooperativePlanner					planner;
+	Pacman								pacman;
+	std::vector<Ghosts*>				ghosts;
+	GameState							start;					// How the game looked before the first tick
+};
+
+#endif /* GAME_H */
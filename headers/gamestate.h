@@ -0,0 +1,86 @@
+#ifndef GAMESTATE_H // include guard
+#define GAMESTATE_H
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "ghostai.h"
+
+
+/**
+ *	Everything about pacman that changes while playing
+ */
+struct PacmanState {
+	float								x, y,
+										velX, velY,
+										speed;
+	int32_t								yaw, pitch;				// Thousandths of a degree, like InputFrame
+	char								direction,
+										viewDir;
+};
+
+/**
+ *	Everything about one ghost that changes while playing
+ */
+struct GhostState {
+	float								x, y,
+										velX, velY,
+										toCentre,
+										speed;
+	GhostRng							rng;
+	int32_t								seenReversals;
+	char								dir;
+};
+
+
+/**
+ *	The whole changing part of a game, as plain data.
+ *
+ *	Saving or restoring one is a memcpy, so it can be taken every tick for
+ *	rewinding or thousands of times a second by a search. The level itself
+ *	(walls, exits, distance table) never changes and is not part of it, a
+ *	state is only ever restored into a Game on the same level.
+ */
+struct GameState {
+	static constexpr int				maxGhosts	= 16;
+	static constexpr int				maxTiles	= 64 * 64;	// Biggest level whose pellets fit
+
+	uint32_t							tick,
+										width,
+										height;
+	uint8_t								done;
+	GhostModes							modes;
+	PacmanState							pacman;
+	int32_t								ghostCount,
+										pelletCount;
+	GhostState							ghosts[maxGhosts];
+	uint64_t							pellets[maxTiles / 64];	// One bit per tile, row major
+};
+
+static_assert(std::is_trivially_copyable<GameState>::value, "GameState must stay plain data");
+
+
+/**
+ *	Fixed number of snapshots, allocated up front. Pushing past the
+ *	capacity overwrites the oldest one.
+ */
+class SnapshotRing {
+public:
+	SnapshotRing						(int capacity = 10 * GhostModes::ticksPerSecond);
+
+	GameState& push						();
+	void push							(const GameState& state);
+	bool pop							(GameState& state);
+	const GameState* peek				(int age = 0);
+	void clear							()						{ size = 0; }
+
+	int  getSize						()						{ return size;		}
+	int  getCapacity					()						{ return (int)slots.size(); }
+
+private:
+	std::vector<GameState>				slots;
+	int									head		= 0,		// Next slot to write
+										size		= 0;
+};
+
+#endif /* GAMESTATE_H */
@@ -0,0 +1,81 @@
+#ifndef GHOSTAI_H // include guard
+#define GHOSTAI_H
+#include <cstdint>
+#include <utility>
+
+class DistanceTable;
+
+
+/**
+ *	The arcade ghosts' targeting rules
+ */
+enum Personality : unsigned char {
+	CHASER,			// Goes straight for pacman (Blinky)
+	AMBUSHER,		// Aims four tiles ahead of pacman (Pinky)
+	FLANKER,		// Mirrors the chaser around a point ahead of pacman (Inky)
+	SHY,			// Chases from afar, backs off to its corner up close (Clyde)
+	WANDERER		// Picks random exits
+};
+
+enum GhostMode : unsigned char {
+	SCATTER, CHASE
+};
+
+/**
+ *	What the ghosts aim by. The game fills this in every tick, before the
+ *	ghosts are updated. Tiles are in map coordinates (row 0 at the top).
+ */
+struct GhostTargets {
+	std::pair<int, int>					pacTile		= { 0, 0 };
+	char								pacDir		= 'U';
+	std::pair<int, int>					chaserTile	= { 0, 0 };
+};
+
+
+/**
+ *	Random numbers for ghosts that wander (xorshift64*).
+ *	A single word of state, so it can be copied along with the rest of the game.
+ */
+struct GhostRng {
+	uint64_t							state		= 0x9E3779B97F4A7C15ull;
+
+	void seed							(uint64_t value)		{ state = (value + 1) * 0x9E3779B97F4A7C15ull | 1; }
+	uint32_t operator()					() {
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return (uint32_t)((state * 0x2545F4914F6CDD1Dull) >> 32);
+	}
+};
+
+
+/**
+ *	The scatter / chase schedule shared by all ghosts.
+ *	Counted in fixed ticks, so it runs the same at any frame rate.
+ */
+class GhostModes {
+public:
+	static constexpr int				ticksPerSecond	= 60;
+
+	GhostModes							();
+
+	void update							();
+
+	GhostMode getMode					();
+	int  getReversals					()						{ return reversals;	}
+	int  getTick						()						{ return tick;		}
+
+private:
+	static const int					schedule[8];		// Seconds per phase, scatter first, -1 is forever
+
+	int									tick			= 0,
+										phase			= 0,
+										phaseTicks		= 0,	// Ticks left of the current phase
+										reversals		= 0;	// Bumped on every mode change
+};
+
+
+std::pair<int, int> ghostTarget			(Personality personality, GhostMode mode, const GhostTargets& targets,
+										 std::pair<int, int> self, int width, int height, DistanceTable* distances);
+
+#endif /* GHOSTAI_H */
@@ -0,0 +1,120 @@
+#ifndef HPA_H // include guard
+#define HPA_H
+#include <cstdint>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+
+/**
+ *	A path found by the hierarchical pathfinder.
+ *	Only the waypoints (cluster entrances) are known up front, the tiles between
+ *	them are filled in one segment at a time by HierarchicalPathfinder::nextTile(),
+ *	which drops the path once setTile() has changed a cluster it crosses.
+ */
+struct HpaPath {
+	std::vector<std::pair<int, int>>	waypoints;
+	std::vector<std::pair<int, int>>	tiles;				// Refined tiles of the current segment
+	size_t								segment	= 0,		// Next waypoint to refine towards
+										cursor	= 0;		// Next tile in tiles
+	uint32_t							version	= 0;		// build() the path was planned on
+	std::vector<std::pair<int, uint32_t>>clusters;			// (cluster, its version) for every cluster it crosses
+
+	bool empty()						{ return waypoints.empty(); }
+	void clear()						{ waypoints.clear(); tiles.clear(); clusters.clear(); segment = cursor = 0; }
+};
+
+
+/**
+ *	HPA* over a tile grid.
+ *
+ *	The map is cut into square clusters. Every stretch of open tiles along a
+ *	cluster border gets one or two entrances, and the entrances inside a cluster
+ *	are linked with their walking distance. Searches run on that small graph and
+ *	the tile path is only filled in when it is walked. Changing a tile rebuilds
+ *	the cluster it is in and the neighbours sharing a border with it, and
+ *	only the paths crossing one of those have to be planned again.
+ *
+ *	Any number of threads may search at the same time as long as each one passes
+ *	its own Scratch (or uses the overloads that keep one per thread).
+ */
+class HierarchicalPathfinder {
+public:
+	/**
+	 *	Per thread search memory. Arrays are stamped instead of cleared, so a
+	 *	search only touches what it visits.
+	 */
+	struct Scratch {
+		std::vector<int>				localDist,
+										localParent,
+										localQueue;
+		std::vector<uint32_t>			localStamp;
+		uint32_t						localGen	= 0;
+
+		std::vector<int>				g,
+										parent,
+										goalCost;
+		std::vector<uint32_t>			stamp,
+										goalStamp;
+		std::vector<std::pair<int, int>>open;			// (f, node) binary heap
+		uint32_t						gen			= 0;
+	};
+
+	HierarchicalPathfinder				(const std::vector<std::vector<int>>& mapArr, int clusterSize = 16);
+	~HierarchicalPathfinder				();
+
+	void build							(int threads = 0);
+	void setTile						(int x, int y, int value);
+
+	bool findPath						(int startX, int startY, int goalX, int goalY, HpaPath& path, Scratch& scratch);
+	bool findPath						(int startX, int startY, int goalX, int goalY, HpaPath& path);
+	bool nextTile						(HpaPath& path, Scratch& scratch, std::pair<int, int>& tile);
+	bool nextTile						(HpaPath& path, std::pair<int, int>& tile);
+
+	int	 getWidth						()						{ return width;			}
+	int  getHeight						()						{ return height;		}
+	int  getClusterSize					()						{ return clusterSize;	}
+	int  getNodeCount					();
+	uint32_t getVersion					()						{ return version;		}
+	bool isWalkable						(int x, int y);
+
+private:
+	struct Node {
+		int								x		= 0,
+										y		= 0,
+										cluster	= -1,
+										partner	= -1;		// Node on the other side of the border
+		bool							alive	= false;
+		std::vector<std::pair<int, int>>intra;				// (node, cost) inside the cluster
+	};
+
+	int  clusterOf						(int x, int y)			{ return (y / clusterSize) * clustersX + x / clusterSize; }
+	void clusterBounds					(int cluster, int& x0, int& y0, int& x1, int& y1);
+	int  allocNode						(int x, int y);
+	void freeNode						(int node);
+	void scanBorder						(bool vertical, int cx, int cy);
+	void clearBorder					(bool vertical, int cx, int cy);
+	void linkCluster					(int cluster, Scratch& scratch);
+	int  localSearch					(int cluster, int fromX, int fromY, int toX, int toY, Scratch& scratch);
+	bool refineSegment					(HpaPath& path, Scratch& scratch);
+	void recordClusters					(HpaPath& path);
+	bool isCurrent						(const HpaPath& path);
+	void prepare						(Scratch& scratch);
+
+	int									width		= 0,
+										height		= 0,
+										clusterSize	= 16,
+										clustersX	= 0,
+										clustersY	= 0;
+	uint32_t							version		= 0;		// Bumped by build()
+	std::vector<uint32_t>				clusterVersions;		// Bumped when setTile() relinks the cluster
+	std::vector<uint8_t>				walls;
+	std::vector<Node>					nodes;
+	std::vector<int>					freeNodes;
+	std::vector<std::vector<int>>		clusterNodes;
+	std::vector<std::vector<int>>		verticalBorders,		// Between (cx, cy) and (cx + 1, cy)
+										horizontalBorders;		// Between (cx, cy) and (cx, cy + 1)
+	std::shared_mutex					lock;
+};
+
+#endif /* HPA_H */
@@ -0,0 +1,65 @@
+#ifndef INPUT_H // include guard
+#define INPUT_H
+#include <cstdint>
+
+
+/**
+ *	Movement keys, as bits in InputFrame::keys
+ */
+enum InputKey : uint8_t {
+	KEY_W = 1, KEY_A = 2, KEY_S = 4, KEY_D = 8
+};
+
+/**
+ *	Everything the player controls during one simulation tick.
+ *	The camera angles are stored in thousandths of a degree, so a recorded
+ *	session replays with exactly the same numbers the live game used.
+ */
+struct InputFrame {
+	uint8_t								keys	= 0;
+	int32_t								yaw		= 180000;
+	int32_t								pitch	= 0;
+};
+
+/**
+ *	Input that walks pacman one way: look along the heading and hold W.
+ *	Headings 0 -> 3 are a quarter turn apart, for bots and learning agents.
+ */
+inline InputFrame headingInput(int heading) {
+	InputFrame input;
+	input.keys = KEY_W;
+	input.yaw  = heading * 90000;
+	return input;
+}
+
+/**
+ *	First person mouse look, turns cursor movement into the camera angles
+ *	(in degrees) that go into every InputFrame.
+ */
+struct MouseLook {
+	float								yaw			= 180.0f,
+										pitch		= 0.0f;
+	double								lastX		= 0.0,
+										lastY		= 0.0;
+	bool								firstMouse	= true;
+
+	void move(double xpos, double ypos) {
+		if (firstMouse) {
+			lastX	   = xpos;
+			lastY	   = ypos;
+			firstMouse = false;
+		}
+
+		float sensitivity = 0.1f;
+		yaw	  += (float)(xpos - lastX) * sensitivity;
+		pitch += (float)(lastY - ypos) * sensitivity;	// Reversed since y-coordinates go from bottom to top
+		lastX  = xpos;
+		lastY  = ypos;
+
+		// Looking past straight up or down would flip the screen
+		if (pitch > 89.0f)	pitch = 89.0f;
+		if (pitch < -89.0f) pitch = -89.0f;
+	}
+};
+
+#endif /* INPUT_H */
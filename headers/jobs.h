@@ -0,0 +1,105 @@
+#ifndef JOBS_H // include guard
+#define JOBS_H
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ *	Bump allocator for short lived scratch memory. Allocating is a pointer
+ *	bump, rewind() frees everything allocated after a mark() at once and
+ *	keeps the blocks for reuse. Not thread safe, every thread has its own
+ *	(see JobSystem::getScratch()).
+ */
+class ScratchArena {
+public:
+	struct Mark {
+		size_t							block,
+										offset;
+	};
+
+	ScratchArena						(size_t blockSize = 64 * 1024);
+
+	void* allocate						(size_t bytes, size_t align = alignof(std::max_align_t));
+	Mark  mark							()						{ return { block, offset }; }
+	void  rewind						(Mark to)				{ block = to.block; offset = to.offset; }
+	void  reset							()						{ block = 0; offset = 0; }
+	size_t getCapacity					();
+
+	template <typename T>
+	T* allocate							(size_t count)			{ return (T*)allocate(count * sizeof(T), alignof(T)); }
+
+private:
+	size_t								blockSize,
+										block		= 0,	// Block being bumped
+										offset		= 0;	// Bytes used in it
+	std::vector<std::vector<char>>		blocks;
+};
+
+
+/**
+ *	Fixed size thread pool with work stealing.
+ *
+ *	Every worker has its own deque: it pushes and pops jobs at the back, so
+ *	what it just spawned runs next while still in cache, and idle workers
+ *	steal from the front of the others. Jobs can wait on other jobs, they
+ *	are only queued once everything they depend on has finished. Any thread
+ *	that waits runs queued jobs in the meantime, so jobs may wait on jobs.
+ *	A job gets the index of the worker running it, or -1 when a thread
+ *	outside the pool runs it while waiting.
+ */
+class JobSystem {
+public:
+	typedef std::function<void(int worker)> Job;
+	struct Task;
+	typedef std::shared_ptr<Task>		TaskHandle;
+
+	JobSystem							(int workers = 0);
+	~JobSystem							();
+
+	TaskHandle submit					(Job job, const std::vector<TaskHandle>& after = {});
+	void wait							(const TaskHandle& task);
+	void wait							(const std::vector<TaskHandle>& tasks);
+	bool isDone							(const TaskHandle& task);
+	void parallelFor					(int count, int slots, const std::function<void(int, int)>& job);
+
+	int  getWorkers						()						{ return (int)workers.size(); }
+	int  currentWorker					();
+	ScratchArena& getScratch			();
+	uint64_t getSteals					()						{ return steals; }
+
+	static JobSystem& shared			();
+
+private:
+	struct alignas(64) Queue {
+		std::mutex						lock;
+		std::deque<TaskHandle>			tasks;
+		ScratchArena					scratch;
+	};
+
+	void workerLoop						(int worker);
+	void schedule						(const TaskHandle& task);
+	bool takeTask						(int worker, TaskHandle& task);
+	void run							(const TaskHandle& task, int worker);
+
+	std::vector<std::unique_ptr<Queue>>	queues;
+	std::vector<std::thread>			workers;
+	std::atomic<int>					queued		{ 0 },	// Jobs sitting in the deques
+										waiting		{ 0 };	// Outside threads blocked in wait()
+	std::atomic<unsigned>				nextQueue	{ 0 };	// Where outside threads drop their jobs
+	std::atomic<uint64_t>				steals		{ 0 };
+	std::atomic<bool>					stopping	{ false };
+
+	std::mutex							sleepLock;
+	std::condition_variable				wake,				// Workers: there's work
+										finished;			// Outside threads: a job finished
+};
+
+#endif /* JOBS_H */
@@ -0,0 +1,87 @@
+#ifndef LANESIM_H // include guard
+#define LANESIM_H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "game.h"
+#include "gamestate.h"
+
+
+/**
+ *	A batch of games on one level, simulated in lock-step.
+ *
+ *	Every value is kept as an array with one entry per game (lane), and each
+ *	part of a tick is one pass over all the lanes instead of a whole Game
+ *	object per game. All lanes share the level's walls, exits and distance
+ *	table. Pacman's passes don't branch per lane, frozen lanes and walls
+ *	only mask what is written, so their maths vectorizes; the wall and
+ *	pellet lookups stay scalar. The ghosts still branch when one reaches
+ *	a tile centre.
+ *
+ *	The rules and the arithmetic are the same as Game::tick() with heading
+ *	inputs, so a lane saved into a GameState can be carried on by a Game.
+ */
+class LaneSim {
+public:
+	static constexpr int				lanes			= 16;
+
+	LaneSim								(const std::string& levelPath, int ghostAmount);
+	~LaneSim							();
+
+	void reset							(const uint32_t* seeds);
+	void load							(int lane, const GameState& state);
+	void save							(int lane, GameState& state);
+	void step							(const int32_t* headings);
+
+	bool	 isValid					()						{ return valid;				}
+	bool	 isDone						(int lane)				{ return done[lane] != 0;	}
+	int		 getPellets					(int lane)				{ return pelletCount[lane]; }
+	uint32_t getTick					(int lane)				{ return tick[lane];		}
+	int		 getGhostAmount				()						{ return ghostAmount;		}
+
+private:
+	void movePacman						(const int32_t* headings);
+	void updateTargets					();
+	void moveGhost						(int ghost);
+	void reachCentre					(int ghost, int lane);
+	void wallCollision					(const float* posX, const float* posY, const char* dirs, uint8_t* blocked);
+
+	Game								game;					// Level, distances and spawning
+	bool								valid			= true;	// False if the level or ghosts don't fit in a GameState
+	int									ghostAmount,
+										width,
+										height,
+										pelletWords;
+	float								tileSize;
+	std::vector<uint8_t>				walls;					// Row major, 1 for walls
+	std::vector<Personality>			personalities;
+
+	// Per lane
+	alignas(64) float					pacX[lanes],
+										pacY[lanes],
+										pacVelX[lanes],
+										pacVelY[lanes],
+										pacSpeed[lanes];
+	char								pacDir[lanes];
+	uint8_t								done[lanes];
+	int32_t								pelletCount[lanes];
+	uint32_t							tick[lanes];
+	GhostModes							modes[lanes];
+	GhostTargets						targets[lanes];
+
+	// Per ghost and lane, [ghost * lanes + lane]
+	std::vector<float>					ghostX,
+										ghostY,
+										ghostVelX,
+										ghostVelY,
+										ghostToCentre,
+										ghostSpeed;
+	std::vector<char>					ghostDir;
+	std::vector<GhostRng>				ghostRng;
+	std::vector<int32_t>				ghostReversals;
+
+	std::vector<uint64_t>				pellets;				// [word * lanes + lane]
+};
+
+#endif /* LANESIM_H */
@@ -1,40 +1,59 @@
 #ifndef MAP_H // include guard
 #define MAP_H
+#include <cstdint>
 #include <fstream>
 #include <vector>
-#include <map>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
 #include <string>
 
 
+/**
+ *	Bits in the exits table, one per open neighbour of a tile.
+ *	Up is towards row 0 (which is the top of the screen).
+ */
+enum Exit : unsigned char {
+	EXIT_U = 1, EXIT_D = 2, EXIT_L = 4, EXIT_R = 8
+};
+
+
 class Map {
 public:
-	Map						(std::string filePath);
+	static constexpr int	sideFloats	= 4 * 8;		// 4 vertices of 8 floats per side of a wall
+	static constexpr int	sideIndices	= 6;			// 2 triangles per side
+	static constexpr int	wallFloats	= 4 * sideFloats;	// A wall showing all 4 sides
+	static constexpr int	wallIndices	= 4 * sideIndices;
+
+	Map						(std::string filePath, bool headless = false);
 	~Map					();
 
-	void CleanVAO			(GLuint& vao);
 	void deletePellet		(std::pair<int, int> position);
-	void drawPellets		();
-	void drawMap			();
-	void fromFile			(std::ifstream& in);
+	void fromFile			(std::istream& in);
+	void initExits			();
 	void initPellets		();							// Initialiserer pellets
-	void initVerts			();
+	void buildWallMesh		(std::vector<float>& vertices, std::vector<unsigned int>& indices, int threads = 0);
+	unsigned char wallSides	(int x, int y);
+	int  meshWallTile		(int x, int y, float* vertices, unsigned int* indices, unsigned int base);
 
 	int	 getStartX			()							{ return startX;	}
 	int  getStartY			()							{ return startY;	}
 	int	 getWidth			()							{ return width;		}
 	int  getHeight			()							{ return height;	}
 	int  getp_count			()							{ return p_count;	}
+	bool isHeadless			()							{ return headless;	}
 
 	float getTileSize		()							{ return tileSize;	}
 
-	bool getPellet			(int x, int y)				{ return p_active[y][x]; }
+	bool getPellet			(int x, int y)				{ int i = y * width + x; return (p_active[i >> 6] >> (i & 63)) & 1; }
+	int  getPelletWords		()							{ return (int)p_active.size(); }
+	const uint64_t* getPelletBits()						{ return p_active.data(); }
+	void loadPellets		(const uint64_t* bits, int count);
+	unsigned char getExits	(int x, int y)				{ return exits[y * width + x]; }
 
 	std::pair<float,float> getScreenCoords(float tileX, float tileY);
 
-	std::vector<std::vector<int>> getMapArray()			{ return mapArr; }
+	const std::vector<std::vector<int>>& getMapArray()	{ return mapArr; }
 
 	template <typename T>
 	int sizeof_v (std::vector <T> vec) { 
@@ -42,31 +61,19 @@ public:
 	}
 
 private:
-	int									height,
-										width,
-										startX,
-										startY;
+	int									height		= 0,
+										width		= 0,
+										startX		= 0,
+										startY		= 0;
+	bool								headless	= false;	// Not drawn, for simulations
 	float								mapStartX	= 0.f,
 										mapStartY	= 0.f,
 										tileSize	= 1.f;
 	std::vector<std::vector<int>>		mapArr;
+	std::vector<unsigned char>			exits;					// Exit bits for every tile
 
-	GLuint								vbo,
-										vao,
-										ebo;
-	std::vector<float>*					points;
-	std::vector<unsigned int>*			indices;
-
-	int									p_slices	= 10,		// Amount of 'slices' that a pellet's circle contains
-										p_count		= 0;		// Counts total pellets created
-	float								p_radius	= 0.25f;	// The radius of a pellet
-	GLuint								p_vbo,
-										p_vao,
-										p_ebo;
-	std::vector<float>*					p_points;
-	std::vector<unsigned int>*			p_indices;
-	std::vector<std::vector<bool>>		p_active;
-	std::map<std::pair<int, int>, int>	p_positions;
+	int									p_count		= 0;		// Counts total pellets created
+	std::vector<uint64_t>				p_active;				// One bit per tile, row major
 };
 
 #endif /* MAP_H */
\ No newline at end of file
@@ -0,0 +1,98 @@
+#ifndef PACK_H // include guard
+#define PACK_H
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+
+/**
+ *	Read-only archive of every file the game loads, mapped into memory.
+ *
+ *	The file starts with a header, followed by a hash table of contents
+ *	(open addressing, FNV-1a of the name, linear probing) and the names.
+ *	The files themselves follow, each starting on an alignment boundary,
+ *	so views into the mapping can go straight to stb_image, tinyobjloader
+ *	or the GPU. Opening the pack is the only file access the game needs.
+ */
+class AssetPack {
+public:
+	static constexpr uint32_t			alignment	= 64;
+
+	/**
+	 *	Bytes of one file inside the pack, valid until the pack is closed
+	 */
+	struct View {
+		const unsigned char*			data		= nullptr;
+		size_t							size		= 0;
+
+		explicit operator bool			() const				{ return data != nullptr; }
+	};
+
+	AssetPack							();
+	~AssetPack							();
+
+	bool open							(const std::string& filePath);
+	void close							();
+	View find							(const std::string& name);
+
+	bool isOpen							()						{ return base != nullptr; }
+	int  getCount						()						{ return count; }
+	size_t getSize						()						{ return size;	}
+
+	static bool build					(const std::string& filePath, const std::vector<std::string>& names,
+										 const std::vector<std::vector<char>>& contents);
+	static uint64_t hashName			(const std::string& name);
+
+	static AssetPack& mounted			();
+	static std::string loosePath		(const std::string& name);
+
+private:
+	struct Entry {								// One slot of the table of contents
+		uint64_t						hash;				// 0 for empty slots
+		uint64_t						offset,
+										size;
+		uint32_t						nameOffset,
+										nameLength;
+	};
+
+	const unsigned char*				base		= nullptr;
+	size_t								size		= 0;
+	const Entry*						table		= nullptr;
+	const char*							names		= nullptr;
+	uint32_t							slots		= 0;
+	int									count		= 0;
+#ifdef _WIN32
+	void*								file		= nullptr,
+										*mapping	= nullptr;
+#endif
+};
+
+
+/**
+ *	Reads an asset: straight out of the mounted pack when it is in there,
+ *	from the loose file (@see AssetPack::loosePath) otherwise
+ */
+class AssetStream : public std::istream {
+public:
+	AssetStream							(const std::string& name);
+
+	AssetPack::View getView				()						{ return view; }
+
+private:
+	struct ViewBuffer : std::streambuf {
+		void set(const AssetPack::View& view) {
+			char* start = (char*)view.data;
+			setg(start, start, start + view.size);
+		}
+	};
+
+	AssetPack::View						view;
+	ViewBuffer							viewBuffer;
+	std::filebuf						fileBuffer;
+};
+
+#endif /* PACK_H */
@@ -0,0 +1,28 @@
+#ifndef PARALLEL_H // include guard
+#define PARALLEL_H
+#include <functional>
+#include <thread>
+
+#include "jobs.h"
+
+
+/**
+ *	Amount of threads to use, every core if threads is 0 or less
+ */
+inline int threadCount(int threads = 0) {
+	if (threads > 0) return threads;
+	int hw = (int)std::thread::hardware_concurrency();
+	return hw > 0 ? hw : 1;
+}
+
+/**
+ *	Runs job(worker, item) for every item in [0, count) on the given amount of threads.
+ *	Items are handed out one at a time, worker is in [0, threads) so callers can
+ *	keep one scratch buffer per worker. The threads come from the shared job
+ *	system, the calling thread is one of them.
+ */
+inline void parallelFor(int count, int threads, const std::function<void(int, int)>& job) {
+	JobSystem::shared().parallelFor(count, threads, job);
+}
+
+#endif /* PARALLEL_H */
@@ -0,0 +1,82 @@
+#ifndef REPLAY_H // include guard
+#define REPLAY_H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "input.h"
+
+
+/**
+ *	What a replay was recorded with. Playing it back with the same level,
+ *	seed and settings gives the same game tick for tick.
+ */
+struct ReplayHeader {
+	std::string							levelPath;
+	uint32_t							levelHash	= 0;		// FNV-1a of the level file
+	uint32_t							seed		= 0;
+	uint32_t							ghostAmount	= 0;
+	uint32_t							flags		= 0;
+	uint32_t							ticks		= 0;
+	uint64_t							checksum	= 0;		// Game::checksum() after the last tick
+};
+
+enum ReplayFlag : uint32_t {
+	REPLAY_COOPERATIVE					= 1,			// Ghosts used the cooperative planner
+	REPLAY_FIXED						= 2				// Movement used fixed point math
+};
+
+
+/**
+ *	Records one InputFrame per tick.
+ *
+ *	Frames are stored as runs: how many ticks in a row the frame repeats,
+ *	the keys, and the view angles as deltas from the previous frame. The
+ *	numbers are written as varints (deltas zigzagged first), so a held key
+ *	with the mouse still costs a couple of bytes for however long it is held.
+ */
+class ReplayRecorder {
+public:
+	void begin							(const std::string& levelPath, uint32_t seed,
+										 uint32_t ghostAmount, uint32_t flags = 0);
+	void record							(const InputFrame& input);
+	bool save							(const std::string& filePath, uint64_t checksum);
+
+	uint32_t getTicks					()						{ return header.ticks; }
+	size_t	 getSize					()						{ return data.size();  }
+
+private:
+	void flush							();
+
+	ReplayHeader						header;
+	std::vector<uint8_t>				data;
+	InputFrame							last,					// Frame the current run repeats
+										written;				// Frame the deltas are taken from
+	uint32_t							run			= 0;
+};
+
+
+/**
+ *	Reads a replay back one InputFrame per tick.
+ */
+class ReplayPlayer {
+public:
+	bool load							(const std::string& filePath);
+	bool next							(InputFrame& input);
+
+	ReplayHeader&		getHeader		()						{ return header;	}
+	uint32_t			getTick			()						{ return tick;		}
+	bool				isDone			()						{ return tick >= header.ticks; }
+
+private:
+	ReplayHeader						header;
+	std::vector<uint8_t>				data;
+	size_t								cursor		= 0;
+	InputFrame							current;
+	uint32_t							run			= 0,		// Ticks left of the current run
+										tick		= 0;
+};
+
+uint32_t levelHash						(const std::string& filePath);
+
+#endif /* REPLAY_H */
@@ -0,0 +1,119 @@
+#ifndef SCENE_H // include guard
+#define SCENE_H
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "assets.h"
+#include "culling.h"
+#include "map.h"
+#include "stream.h"
+
+
+/**
+ *	Everything of a level that never moves (the walls, the pellets, any
+ *	prop added with addMesh() and addDraw()) in one vertex buffer, one
+ *	index buffer and one instance buffer, drawn with a single
+ *	glMultiDrawElementsIndirect().
+ *
+ *	The level is cut into chunks of chunkTiles x chunkTiles tiles. Every
+ *	chunk's walls are a mesh of their own, the pellets are instances of one
+ *	sphere, so each chunk is a draw for its walls and one for its pellets.
+ *	One call draws them all, however big the level. The walls can be left
+ *	out for WallMesher to mesh on the GPU instead.
+ *
+ *	What is visible is worked out on the GPU. Every frame draw() resets the
+ *	commands to no instances and runs a compute shader over every instance:
+ *	those whose box (their mesh's, where the instance puts it) is in the
+ *	camera's frustum, and that aren't pellets the pellet mask (shader
+ *	storage binding 1) says are eaten, are appended to their command's part
+ *	of a buffer of visible instances, counted by its instance count. The
+ *	draw reads its instances from there.
+ */
+class StaticScene {
+public:
+	static constexpr int				chunkTiles	= 16;
+
+	struct Vertex {
+		float							x, y, z,
+										r, g, b,
+										u, v;					// Already scaled to the image's part of the layer
+		int32_t							layer;					// Image in the array texture, -1 for the colour only
+	};
+
+	/**
+	 *	Where a copy of a mesh goes, and the tile it stands for
+	 */
+	struct Instance {
+		float							x, y, z;
+		int32_t							tile;					// Pellet's tile in the pellet mask, -1 if always drawn
+	};
+
+	/**
+	 *	The command glMultiDrawElementsIndirect() reads, this layout exactly
+	 */
+	struct DrawCommand {
+		GLuint							count,
+										instanceCount,
+										firstIndex;
+		GLint							baseVertex;
+		GLuint							baseInstance;
+	};
+
+	StaticScene							();
+	~StaticScene						();
+
+	void build							(Map& map, const AssetLoader::Layer& wallImage, bool walls = true);
+	int  addMesh						(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+	void addDraw						(int mesh, const std::vector<Instance>& instances);
+	bool upload							(GLuint shader, GLuint cullShader);
+	void release						();
+
+	void draw							(const Frustum& frustum, const glm::mat4& projection, const glm::mat4& view);
+
+	int  getMeshes						()						{ return (int)meshes.size(); }
+	int  getDrawCount					()						{ return drawCount;		}
+	int  getInstanceCount				()						{ return instanceCount;	}
+
+private:
+	/**
+	 *	Where a mesh is in the buffers, and the box around it
+	 */
+	struct Mesh {
+		GLuint							firstIndex,
+										count;
+		GLint							baseVertex;
+		float							min[4],
+										max[4];					// The 4th is padding, the shader reads vec4s
+	};
+
+	static void appendWalls				(Map& map, int x0, int y0, int x1, int y1, const AssetLoader::Layer& image,
+										 std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+	static void pelletMesh				(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+	std::vector<Vertex>					vertices;
+	std::vector<uint32_t>				indices;
+	std::vector<Instance>				instances;
+	std::vector<uint32_t>				instanceDraws;			// Draw of every instance
+	std::vector<Mesh>					meshes;
+	std::vector<DrawCommand>			commands;				// With no instances, draw() starts from these
+	std::vector<int>					drawMeshes;				// Mesh of every draw
+
+	GLuint								shader		= 0,
+										cullShader	= 0,
+										vao			= 0,
+										vbo			= 0,
+										ebo			= 0,
+										ibo			= 0,		// Instances
+										dbo			= 0,		// Draw of every instance
+										bbo			= 0,		// Box of every draw
+										resetBuffer	= 0,		// commands
+										commandBuffer = 0,		// What draw() draws, counted by the shader
+										visibleBuffer = 0;		// Instances that passed culling, in their draw's part
+	int									drawCount	= 0,
+										instanceCount = 0;
+};
+
+#endif /* SCENE_H */
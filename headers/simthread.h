@@ -0,0 +1,184 @@
+#ifndef SIMTHREAD_H // include guard
+#define SIMTHREAD_H
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "input.h"
+
+class Game;
+
+
+/**
+ *	Hands the newest value from one thread to another without locks.
+ *
+ *	The writer fills back() and publishes it, the reader calls update() and
+ *	reads front(). The third slot sits in the middle, so neither side ever
+ *	waits for the other; values the reader never picked up are overwritten.
+ *	The middle index and a "fresh" bit share one atomic byte.
+ */
+template <typename T>
+class TripleBuffer {
+public:
+	T&		 back					()						{ return slots[backIndex].value;  }
+	const T& front					()						{ return slots[frontIndex].value; }
+
+	/**
+	 *	Sets all three slots, before either side uses the buffer. Values that
+	 *	own memory can be sized up front this way.
+	 */
+	void fill(const T& value) {
+		for (Slot& slot : slots) slot.value = value;
+	}
+
+	/**
+	 *	Writer: swaps the filled back slot into the middle
+	 */
+	void publish() {
+		backIndex = middle.exchange(backIndex | fresh, std::memory_order_acq_rel) & indexMask;
+	}
+
+	/**
+	 *	Reader: takes the middle slot if something new was published
+	 *	@return true if front() changed
+	 */
+	bool update() {
+		if (!(middle.load(std::memory_order_relaxed) & fresh)) return false;
+		frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & indexMask;
+		return true;
+	}
+
+private:
+	static constexpr uint8_t			fresh		= 4,
+										indexMask	= 3;
+
+	struct alignas(64) Slot {						// One cache line each, the threads never share one
+		T								value		= {};
+	};
+
+	Slot								slots[3];
+	uint8_t								backIndex	= 0,	// Only touched by the writer
+										frontIndex	= 1;	// Only touched by the reader
+	alignas(64) std::atomic<uint8_t>	middle		{ 2 };
+};
+
+
+/**
+ *	Fixed timestep accumulator. Hands out whole ticks for the time that has
+ *	passed, and if more than maxCatchUp are due at once the rest is dropped:
+ *	the game slows down for a moment instead of spending ever longer frames
+ *	catching up.
+ */
+class TickClock {
+public:
+	static constexpr int				maxCatchUp	= 5;
+
+	TickClock							(double step)			: step(step) {}
+
+	void reset							(double now)			{ next = now + step; }
+	int  advance						(double now);
+	double tick							();
+
+	double getNext						()						{ return next;		}
+	uint64_t getDropped					()						{ return dropped;	}
+
+private:
+	double								step,
+										next		= 0.0;	// When the next tick is due
+	uint64_t							dropped		= 0;	// Ticks skipped after stalls
+};
+
+
+/**
+ *	What the render thread sends the simulation: the player's input and
+ *	whether R (rewind) is held
+ */
+struct SimControls {
+	InputFrame							input;
+	bool								rewind		= false;
+};
+
+/**
+ *	Everything the renderer needs from one tick, copied out of the Game so
+ *	the render thread never reads what the simulation is writing.
+ *	The pellet bits and ghosts are sized for the level when the SimThread
+ *	starts, so copying frames around never allocates after that.
+ */
+struct RenderFrame {
+	double								time		= 0.0;	// SimThread clock when the tick was due
+	uint32_t							tick		= 0;
+	uint64_t							dropped		= 0;	// Ticks the TickClock has skipped so far
+	bool								done		= false;
+
+	float								pacX		= 0.f,
+										pacY		= 0.f,
+										yaw			= 180.f,
+										pitch		= 0.f;
+	char								pacDir		= ' ';
+	double								animationTime = 0.0;	// Seconds pacman's walk cycle has played
+	int32_t								pellets		= 0,	// Left to eat
+										pelletTotal	= 0,
+										pelletWords	= 0;
+	std::vector<uint64_t>				pelletBits;			// Which are left, one bit per tile
+
+	int32_t								ghostCount	= 0;
+	std::vector<float>					ghostX,
+										ghostY;
+	std::vector<char>					ghostDir;
+};
+
+
+/**
+ *	Runs a Game on its own thread at the fixed tick rate.
+ *
+ *	Every tick the thread takes the newest SimControls, calls the tick
+ *	function (which does the actual game.tick() along with replays,
+ *	recording and rewinding) and publishes a RenderFrame. The render thread
+ *	draws between the last two frames, so a slow glfwSwapBuffers() no longer
+ *	holds the game up and a slow tick no longer holds the frame up.
+ *	Nothing but the tick function may touch the Game while the thread runs.
+ *
+ *	Started with threaded = false no thread is made, and the render loop
+ *	calls advance() every frame to run the ticks that are due in between.
+ */
+class SimThread {
+public:
+	typedef std::function<void(const SimControls& controls)> TickFunction;
+
+	SimThread							(Game& game, TickFunction tick);
+	~SimThread							();
+
+	void start							(bool threaded = true);
+	void stop							();
+	void advance						();
+
+	void setControls					(const SimControls& controls);
+	bool poll							();
+	void interpolate					(RenderFrame& frame);
+	double now							();
+
+private:
+	void run							();
+	void runTick						();
+	void capture						(RenderFrame& frame, double time);
+
+	Game&								game;
+	TickFunction						tickFunction;
+	std::thread							thread;
+	std::atomic<bool>					running		{ false };
+	bool								threaded	= false;
+	std::chrono::steady_clock::time_point epoch;
+	TickClock							clock;				// Simulation side
+
+	TripleBuffer<SimControls>			controls;			// Render -> simulation
+	TripleBuffer<RenderFrame>			frames;				// Simulation -> render
+	double								animationTime = 0.0;	// Simulation thread only
+
+	RenderFrame							previous,			// Render thread only
+										current;
+};
+
+#endif /* SIMTHREAD_H */
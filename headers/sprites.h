@@ -5,40 +5,52 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <random>
 #include <string>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "fixed.h"
+#include "gamestate.h"
+#include "ghostai.h"
+#include "input.h"
+
+class CooperativePlanner;
+class DistanceTable;
 
 
 class Sprites {
 private:
 	float								speed = 5.f;
 	Map* map;
-	int									movementAnimation = 20;
 	char								direction = 'U';
 	char								directionView = 'U';
+	bool								fixedPoint = false;	// Integer movement, see fixed.h
 public:
 	Sprites						(Map* map);
-	~Sprites					();
+	virtual ~Sprites			();
 
 	virtual bool checkIfGameIsDone		(bool ghostCollision);
 	bool checkWallCollision		(float posX, float posY);
 
 	Map*  getMap()					{ return map; }
 	float getSpeed()				{ return speed; }
-	int	  getMovAni()				{ return movementAnimation; }
 	char  getDirection()			{ return direction; }
 	char  getViewDir()				{ return directionView; }
 	void  setDirection(char dir)	{ direction = dir; }
 	void  setViewDirection(char dir){ directionView = dir; }
-	void  setMovAni(int newMovAni)	{ movementAnimation = newMovAni; }
+	void  setSpeed(float newSpeed)	{ speed = newSpeed; }
+	bool  isFixedPoint()			{ return fixedPoint; }
+	void  setFixedPoint(bool on)	{ fixedPoint = on; }
+	fixed_t fixedStep();
 	
 
-	void moveAllToShader(float offsetX, float offsetY, const float& radians, GLuint shaderprogram);
+	static glm::mat4 transformation(float offsetX, float offsetY, float radians);
 
 	std::pair<int, int> Sprites::coordsToTile(float x, float y);
+	std::pair<int, int> fixedToTile(fixed_t x, fixed_t y);
+	bool fixedWallCollision		(fixed_t posX, fixed_t posY);
 
 	template <typename T>
 	int sizeof_v(std::vector <T> vec) { 
@@ -50,93 +62,112 @@ public:
 
 class Ghosts : public Sprites {
 private:
-	GLuint								ghost_Shader,
-										ghost_vbo,
-										potVAO;
+	GLuint								ghost_vbo,
+										potVAO		 = 0;	// The model, owned by the AssetLoader
 
-	std::vector<float>*					ghost_points;
+	std::vector<float>*					ghost_points = nullptr;
 
 	std::vector<std::pair<float, float>>sprite_positions;
 	std::vector<float>					sprite_velX;
 	std::vector<float>					sprite_velY;
+	std::vector<char>					sprite_dir;			// 'U', 'D', 'L', 'R' or ' ' before the first decision
+	std::vector<float>					sprite_toCentre;	// Distance left to the next tile centre
+
+	// The same in fixed point, used instead of the floats above when fixedPoint is set
+	std::vector<std::pair<fixed_t, fixed_t>>fixed_positions;
+	std::vector<fixed_t>				fixed_velX;			// Per tick
+	std::vector<fixed_t>				fixed_velY;
+	std::vector<fixed_t>				fixed_toCentre;
+
+	GhostRng							rng;
+
+	Personality							personality	 = WANDERER;
+	DistanceTable*						distances	 = nullptr;
+	GhostModes*							modes		 = nullptr;	// Shared by all ghosts
+	const GhostTargets*					targets		 = nullptr;	// Shared by all ghosts
+	int									seenReversals = 0;
 
 	bool								increaseStep = true;
 	int									Step = 0;
 	int									size = 0;
-	
 
-//------------------------------------------------------------------------------
-// VERTEX STRUCT
-//------------------------------------------------------------------------------
-	struct Vertex
-	{
-		glm::vec3 location;
-		glm::vec3 normals;
-		glm::vec2 texCoords;
-	};
+	CooperativePlanner*					planner		 = nullptr;	// Shared by all ghosts in cooperative mode
+	int									agent		 = -1;
 
 public:
-	Ghosts(Map* map, GLuint shader);
+	Ghosts(Map* map);
 	~Ghosts();
 
 	std::pair<float, float> getGhostPos(int nr) { return sprite_positions[nr]; }
+	std::pair<fixed_t, fixed_t> getFixedPos(int nr) { return fixed_positions[nr]; }
+	char		 getGhostDir(int nr) { return sprite_dir[nr]; }
 
 	int			 getSize() { return size; }
 	void		 setSize(int newSize) { size = newSize; }
-	void		 drawGhosts();
+	void		 drawGhosts(GLuint command);
 	GLuint		 initGhost(time_t seed);
-	GLuint		 LoadModel(const std::string path);
-	GLuint		 setpotVAO(GLuint modelFunction) { potVAO = modelFunction; }
-	virtual void movement(GLFWwindow* window, double dt, bool gameStatus, time_t seed);
+	void		 spawn(uint64_t seed);
+	void		 setModel(GLuint vao, int vertices) { potVAO = vao; size = vertices; }
+	virtual void movement(double dt, bool gameStatus);
 	virtual bool checkIfGameIsDone(bool ghostCollision);
+	void		 reachCentre(int i);
+	void		 reachCentreFixed(int i);
+	unsigned char pickExit(std::pair<int, int> tile, char dir);
+	unsigned char chooseExit(std::pair<int, int> tile, unsigned char exits);
+	void		 setFixedPoint(bool fixedPoint);
+	static glm::mat4 transformation(float x, float y, char dir);
+
+	Personality	 getPersonality() { return personality; }
+	void		 setBrain(Personality personality, DistanceTable* distances, GhostModes* modes, const GhostTargets* targets);
+
+	std::pair<int, int> getTile();
+	void		 setPlanner(CooperativePlanner* planner);
+	void		 followPlan(float stepFraction, bool gameStatus);
+
+	void		 saveState(GhostState& state);
+	void		 loadState(const GhostState& state);
 
 };
 
 
 class Pacman : public Sprites {
 private:
-	GLuint								pac_vbo,
-										pac_vao,
-										pac_ebo,
-										pacman_Shader;
-
-	std::vector<float>*					pac_points;
-	std::vector<unsigned int>*			pac_indices;
 	std::pair<float, float>				pacPos2;
+	std::pair<fixed_t, fixed_t>			fixedPos;						// Used instead of pacPos2 when fixedPoint is set
+	fixed_t								fixedVelX		= 0,			// Per tick
+										fixedVelY		= 0;
 
-	int									Step			= 0;
-	float								widthX			= (1.f / 6.f),	// Each sprite i divided into 6ths on the X axis
-										heightY			= (1.f / 4.f),	// divided into 4ths on the Y axis
-										velX			= 0.f,
+	float								velX			= 0.f,
 										velY			= 0.f;
-	bool								increaseStep	= true;
-	bool								firstMouse		= true;
 
 	float								yaw				= 180.0f;    // yaw is initialized to -90.0 degrees since a yaw of 0.0 results in a direction vector pointing to the right so we initially rotate a bit to the left.
 	float								pitch			= 0.0f;
-	float								lastX			= 0;
-	float								lastY			= 0;
 	float								fov				= 40.0f;
 	glm::vec3							cameraFront		= glm::vec3(0.f, 0.f, 50.f);
 
 public:
-	Pacman(Map* map, GLuint shader);
+	Pacman(Map* map);
 	~Pacman();
 
-	void pacAnimate();
-	virtual bool movement(GLFWwindow* window, double dt, std::vector<Ghosts*> ghosts, bool gameStatus);
+	virtual bool movement(const InputFrame& input, double dt, std::vector<Ghosts*> ghosts, bool gameStatus);
+	bool movementFixed(const InputFrame& input, std::vector<Ghosts*> ghosts);
+	void setFixedPoint(bool fixedPoint);
 
 	bool checkGhostCollision(std::vector<Ghosts*> ghosts, float posX, float posY);
 	virtual bool checkIfGameIsDone(bool ghostCollision);
 	bool checkPelletCollision(std::pair<int, int> currentTile);
 
-	GLuint initPacman();
-
-	void updateCamera(double xpos, double ypos);
+	void setView(int32_t yawMilli, int32_t pitchMilli);
+	static glm::vec3 viewDirection(float yaw, float pitch);
 	void findCameraDirection();
+	float getYaw() { return yaw; }
+	float getPitch() { return pitch; }
 	glm::vec3 getCameraFront() { return cameraFront; }
 	std::pair<float, float> getPacPos() { return pacPos2; }
 
+	void saveState(PacmanState& state);
+	void loadState(const PacmanState& state);
+
 };
 #endif // !sprites_h
 
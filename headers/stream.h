@@ -0,0 +1,70 @@
+#ifndef STREAM_H // include guard
+#define STREAM_H
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/**
+ *	One buffer for everything the CPU sends the GPU anew every frame:
+ *	sprite quads, ghost transforms, the pellet mask.
+ *
+ *	The buffer is made once with glBufferStorage and stays mapped
+ *	(GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT), so writing to it is
+ *	writing to memory: no glBufferData, no glMapBuffer, nothing for the
+ *	driver to synchronise. It is cut in 3 frame regions. beginFrame() moves
+ *	on to the next region and waits on the fence endFrame() put behind the
+ *	draws that read it 3 frames ago, which has almost always passed;
+ *	allocate() then hands out pieces of the region until it is full.
+ *
+ *	Without buffer storage (before GL 4.4) the regions live in memory
+ *	instead and commit() copies them over with glBufferSubData.
+ */
+class StreamBuffer {
+public:
+	static constexpr int				frames		= 3;		// Frames the GPU may still be reading
+
+	/**
+	 *	A piece of this frame's region
+	 */
+	struct Range {
+		unsigned char*					data		= nullptr;	// Write here, only until the frame ends
+		GLintptr						offset		= 0;		// Where that is in the buffer
+		GLsizeiptr						size		= 0;
+
+		explicit operator bool			() const				{ return data != nullptr; }
+	};
+
+	StreamBuffer						(size_t frameSize = 1 << 20);
+	~StreamBuffer						();
+
+	bool init							();
+	void release						();
+
+	void beginFrame						();
+	void endFrame						();
+	Range allocate						(size_t bytes, size_t align = 0);
+	void commit							(const Range& range, size_t from = 0, size_t bytes = SIZE_MAX);
+	void bind							(GLenum target, GLuint index, const Range& range);
+
+	GLuint getBuffer					()						{ return buffer;	}
+	bool isPersistent					()						{ return persistent; }
+	size_t getFrameSize					()						{ return frameSize;	}
+	size_t getUsed						()						{ return used;		}
+	uint64_t getStalls					()						{ return stalls;	}
+
+private:
+	size_t								frameSize,
+										bindAlignment = 256,	// For glBindBufferRange(), asked from GL in init()
+										used		= 0;		// Bytes of this frame's region handed out
+	int									region		= frames - 1;
+	GLuint								buffer		= 0;
+	bool								persistent	= false;
+	unsigned char*						mapped		= nullptr;	// Start of the buffer, or of shadow
+	std::vector<unsigned char>			shadow;					// Only without persistent mapping
+	GLsync								fences[frames] = {};
+	uint64_t							stalls		= 0;		// Times beginFrame() had to wait for the GPU
+};
+
+#endif /* STREAM_H */
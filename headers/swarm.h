@@ -0,0 +1,67 @@
+#ifndef SWARM_H // include guard
+#define SWARM_H
+#include <glad/glad.h>
+#include <cstdint>
+#include <vector>
+
+#include "fixed.h"
+#include "map.h"
+
+
+/**
+ *	A swarm of wandering ghosts simulated by a compute shader, for stress
+ *	modes with far more ghosts than Ghosts::movement() keeps up with.
+ *
+ *	Every ghost lives in a shader storage buffer: the tile it last passed
+ *	the centre of, how far past it is (fixed point, like fixed.h), the exit
+ *	it is heading through and its own random state. The level's exits are
+ *	an integer texture. step() runs the shader over every ghost for some
+ *	ticks; it walks them with the rules of a wandering Ghosts (straight on
+ *	through corridors and corners, a random exit that doesn't turn back at
+ *	junctions, back only out of dead ends) and writes every ghost's
+ *	transformation for drawing into another buffer, which InstanceCulling
+ *	culls and the model shader reads. Nothing comes back to the CPU.
+ *
+ *	Only integers are used, so stepReference() runs the same rules on the
+ *	CPU and has to end up with exactly the same ghosts.
+ */
+class GhostSwarm {
+public:
+	/**
+	 *	One ghost, as the shader has it (std430)
+	 */
+	struct Ghost {
+		int32_t							tileX,
+										tileY;
+		fixed_t							progress;				// Past the tile's centre, towards exit
+		uint32_t						exit;					// Exit bit it walks through, 0 standing at the centre
+		uint32_t						rng;					// xorshift32 state, never 0
+	};
+
+	GhostSwarm							(Map& map, int count, uint32_t seed, float speed = 5.f);
+	~GhostSwarm							();
+
+	bool init							(GLuint simShader);
+	void release						();
+
+	void step							(int ticks);
+	void read							(std::vector<Ghost>& ghosts);
+	void stepReference					(std::vector<Ghost>& ghosts, int ticks);
+
+	int	 getCount						()						{ return count;			}
+	GLuint getTransforms				()						{ return transforms;	}	// One mat4 per ghost
+	const std::vector<Ghost>& getSpawn	()						{ return spawn;			}
+
+private:
+	Map&								map;
+	int									count;
+	fixed_t								speed;					// Per tick
+	std::vector<Ghost>					spawn;
+
+	GLuint								shader		= 0,
+										ghosts		= 0,
+										transforms	= 0,
+										exits		= 0;		// GL_R8UI texture, Exit bits of every tile
+};
+
+#endif /* SWARM_H */
@@ -0,0 +1,91 @@
+#ifndef TEXTURE_H // include guard
+#define TEXTURE_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/**
+ *	An array texture with its full mip chain, laid out the way it is
+ *	cached: a small header, a table of images, then every level from the
+ *	biggest down to 1x1 holding all layers, tightly packed RGBA8 rows. The
+ *	packer builds these offline from the PNGs, so at runtime a chain is
+ *	parsed in place out of the asset pack and goes straight to
+ *	glTexStorage3D()/glTexSubImage3D().
+ *
+ *	Images are shelf packed into the layers, tallest first, instead of each
+ *	getting a layer as big as the biggest one. Every image has a border of
+ *	its edge texels repeated around it, so texture coordinates taken through
+ *	getImageRect() sample it like a texture of its own, clamped at the
+ *	edges, with nothing of its neighbours bleeding in over the first mip
+ *	levels.
+ *
+ *	Levels are box filtered with the colours weighted by alpha, so
+ *	transparent texels don't darken the edges of the sprites.
+ */
+class MipChain {
+public:
+	static constexpr uint32_t			formatRGBA8	= 0;	// Only format so far, block compressed ones would go next to it
+
+	/**
+	 *	RGBA pixels of one image, named so the game can find it again
+	 */
+	struct Image {
+		const unsigned char*			pixels;
+		int								width,
+										height;
+		std::string						name;
+	};
+
+	MipChain							()						= default;
+	MipChain							(const MipChain&)		= delete;	// The levels point into storage
+	MipChain& operator=					(const MipChain&)		= delete;
+
+	bool build							(const std::vector<Image>& images);
+	bool parse							(const unsigned char* data, size_t size);
+	void clear							();
+
+	int  getLevels						()						{ return (int)levels.size(); }
+	int  getLayers						()						{ return layerCount;		  }
+	int  getImages						()						{ return (int)images.size(); }
+	int  getWidth						(int level = 0)			{ return levels[level].width;  }
+	int  getHeight						(int level = 0)			{ return levels[level].height; }
+	const unsigned char* getPixels		(int level, int layer = 0);
+	size_t getOffset					(int level, int layer = 0);
+	size_t getSize						()						{ return size; }
+
+	int  findImage						(const std::string& name);
+	void getImageRect					(int image, int& layer, float& offsetU, float& offsetV,
+										 float& scaleU, float& scaleV);
+
+	const std::vector<unsigned char>& getFile()					{ return storage; }
+
+	static int  levelCount				(int width, int height);
+	static std::string cacheName		(const std::string& name);
+
+private:
+	struct Level {
+		int								width,
+										height;
+		const unsigned char*			pixels;				// Layer 0, the others follow
+	};
+
+	struct Placed {								// An image as stored in the file
+		uint32_t						layer,
+										x,					// Top left corner in the layer
+										y,
+										width,
+										height,
+										reserved;
+		uint64_t						name;				// AssetPack::hashName() of the image's name
+	};
+
+	std::vector<Level>					levels;
+	std::vector<Placed>					images;
+	int									layerCount	= 0;
+	size_t								size		= 0;	// Bytes of pixels over every level
+	std::vector<unsigned char>			storage;			// The whole file if built here, empty if parsed
+};
+
+#endif /* TEXTURE_H */
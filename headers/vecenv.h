@@ -0,0 +1,79 @@
+#ifndef VECENV_H // include guard
+#define VECENV_H
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "game.h"
+
+
+/**
+ *	Bits in the done flags step() hands back
+ */
+enum DoneFlag : uint8_t {
+	DONE_TERMINAL	= 1,			// Pacman was caught or ate every pellet
+	DONE_TRUNCATED	= 2				// Ran out of ticks
+};
+
+
+/**
+ *	Many headless games stepped together, for reinforcement learning.
+ *
+ *	Actions are headings (see headingInput()), each held for frameSkip ticks.
+ *	Observations are tile grids, channels x height x width bytes per game:
+ *	walls, pellets, pacman and ghosts (how many stand on the tile). They are
+ *	written straight into flat arrays, either the environment's own or ones
+ *	the caller passes to bind(), so a training loop can hand in numpy
+ *	buffers and never copy. Games that end are reset on the spot with their
+ *	next seed, and the observation returned is the new game's first one.
+ */
+class VecEnv {
+public:
+	static constexpr int				channels		= 4;
+	static constexpr int				actions			= 4;
+
+	VecEnv								(const std::string& levelPath, int envs, int ghostAmount,
+										 int frameSkip = 4, int threads = 0);
+	~VecEnv								();
+
+	void bind							(uint8_t* observations, float* rewards, uint8_t* dones);
+	void reset							(const uint32_t* seeds);
+	void step							(const int32_t* actions);
+
+	int		 getEnvCount				()						{ return (int)games.size(); }
+	int		 getWidth					()						{ return width;			}
+	int		 getHeight					()						{ return height;		}
+	size_t	 getObservationSize			()						{ return (size_t)channels * width * height; }
+	uint8_t* getObservations			()						{ return observations;	}
+	float*	 getRewards					()						{ return rewards;		}
+	uint8_t* getDones					()						{ return dones;			}
+	uint64_t getSteps					()						{ return steps;			}
+
+private:
+	void observe						(int env);
+	void stepEnv						(int env, int action);
+
+	int									width			= 0,
+										height			= 0,
+										frameSkip		= 4,
+										threads			= 1;
+	uint32_t							maxTicks		= 3 * 60 * GhostModes::ticksPerSecond;
+	float								pelletReward	= 1.f,
+										caughtReward	= -10.f;
+	std::vector<std::unique_ptr<Game>>	games;
+	std::vector<uint32_t>				seeds,					// Seed of each game's first episode
+										episodes;
+	std::vector<uint8_t>				wallPlane;				// Channel 0, the same for every game
+	uint64_t							steps			= 0;
+
+	// Where step() writes, either the buffers below or the caller's
+	uint8_t*							observations	= nullptr;
+	float*								rewards			= nullptr;
+	uint8_t*							dones			= nullptr;
+	std::vector<uint8_t>				ownObservations,
+										ownDones;
+	std::vector<float>					ownRewards;
+};
+
+#endif /* VECENV_H */
@@ -0,0 +1,75 @@
+#ifndef WALLS_H // include guard
+#define WALLS_H
+#include <glad/glad.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "assets.h"
+#include "map.h"
+
+
+/**
+ *	Meshes a level's walls with a compute shader instead of
+ *	Map::buildWallMesh(), so loading a big level leaves the CPU alone.
+ *
+ *	The tiles go up as a shader storage buffer and every pass runs one
+ *	invocation per tile. The first counts the sides of each wall that
+ *	show (none against another wall), a prefix scan in blocks of 256
+ *	turns the counts into where every tile's sides go, and the last pass
+ *	meshes each tile there. The mesh is the one the CPU makes, byte for
+ *	byte (8 floats a vertex, 4 vertices and 6 indices a side), and is drawn
+ *	with glDrawElementsIndirect() from a command the last tile fills in.
+ *	setTile() changes tiles in place, mesh() then meshes them again.
+ */
+class WallMesher {
+public:
+	/**
+	 *	The command glDrawElementsIndirect() reads, this layout exactly
+	 */
+	struct DrawCommand {
+		GLuint							count,
+										instanceCount,
+										firstIndex;
+		GLint							baseVertex;
+		GLuint							baseInstance;
+	};
+
+	WallMesher							();
+	~WallMesher							();
+
+	bool init							(GLuint meshShader);
+	void release						();
+
+	bool build							(Map& map);
+	bool setTile						(int x, int y, int tile);
+	void mesh							();
+	void read							(std::vector<float>& vertices, std::vector<unsigned int>& indices);
+
+	void draw							(GLuint shader, const AssetLoader::Layer& image,
+										 const glm::mat4& projection, const glm::mat4& view);
+
+	int  getWalls						()						{ return walls;		}
+
+private:
+	void reserve						();
+
+	GLuint								shader		= 0,
+										vao			= 0,
+										tiles		= 0,		// One int per tile, row major
+										scan		= 0,		// Sides of every tile, then the levels of the scan
+										vbo			= 0,
+										ebo			= 0,
+										command		= 0;		// GL_DRAW_INDIRECT_BUFFER
+	int									width		= 0,
+										height		= 0,
+										walls		= 0,
+										capacity	= 0;		// Walls the vertex and index buffers have room for
+	std::vector<int>					grid;					// What the tile buffer holds
+	std::vector<GLuint>					levels;					// Where every level of the scan starts, then its end
+	float								startX		= 0.f,		// Screen coordinates of the bottom left tile
+										startY		= 0.f,
+										tileSize	= 1.f;
+};
+
+#endif /* WALLS_H */
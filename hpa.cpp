@@ -0,0 +1,448 @@
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+
+#include "headers/hpa.h"
+#include "headers/parallel.h"
+
+namespace {
+	const int		dirX[4]			= { 0, 0, -1, 1 };
+	const int		dirY[4]			= { -1, 1, 0, 0 };
+	const int		longEntrance	= 6;		// Runs this long get an entrance at each end
+
+	typedef std::pair<int, int> Entry;			// (f, node)
+}
+
+
+/**
+ *	Constructor
+ *	@param mapArr	   - The level grid, 1 is a wall and everything else is walkable
+ *	@param clusterSize - Width and height of a cluster in tiles
+ */
+HierarchicalPathfinder::HierarchicalPathfinder(const std::vector<std::vector<int>>& mapArr, int clusterSize) {
+	this->clusterSize = clusterSize;
+	height	  = (int)mapArr.size();
+	width	  = height > 0 ? (int)mapArr[0].size() : 0;
+	clustersX = (width + clusterSize - 1) / clusterSize;
+	clustersY = (height + clusterSize - 1) / clusterSize;
+
+	walls.resize(width * height);
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++)
+			walls[y * width + x] = mapArr[y][x] == 1;
+}
+
+/**
+ *	Destructor
+ */
+HierarchicalPathfinder::~HierarchicalPathfinder() {
+
+}
+
+bool HierarchicalPathfinder::isWalkable(int x, int y) {
+	return x >= 0 && y >= 0 && x < width && y < height && !walls[y * width + x];
+}
+
+int HierarchicalPathfinder::getNodeCount() {
+	std::shared_lock<std::shared_mutex> guard(lock);
+	return (int)(nodes.size() - freeNodes.size());
+}
+
+/**
+ *	Tile bounds of a cluster, x1 and y1 are exclusive
+ */
+void HierarchicalPathfinder::clusterBounds(int cluster, int& x0, int& y0, int& x1, int& y1) {
+	x0 = (cluster % clustersX) * clusterSize;
+	y0 = (cluster / clustersX) * clusterSize;
+	x1 = std::min(width, x0 + clusterSize);
+	y1 = std::min(height, y0 + clusterSize);
+}
+
+/**
+ *	Builds the whole abstract graph. Entrances are found on one thread, the
+ *	clusters are then linked in parallel since they never share nodes.
+ */
+void HierarchicalPathfinder::build(int threads) {
+	std::unique_lock<std::shared_mutex> guard(lock);
+	threads = threadCount(threads);
+
+	nodes.clear();
+	freeNodes.clear();
+	clusterNodes.assign(clustersX * clustersY, std::vector<int>());
+	clusterVersions.assign(clustersX * clustersY, 0);
+	verticalBorders.assign(std::max(0, clustersX - 1) * clustersY, std::vector<int>());
+	horizontalBorders.assign(clustersX * std::max(0, clustersY - 1), std::vector<int>());
+
+	for (int cy = 0; cy < clustersY; cy++) {
+		for (int cx = 0; cx < clustersX; cx++) {
+			if (cx + 1 < clustersX) scanBorder(true, cx, cy);
+			if (cy + 1 < clustersY) scanBorder(false, cx, cy);
+		}
+	}
+
+	std::vector<Scratch> scratch(threads);
+	parallelFor(clustersX * clustersY, threads, [&](int worker, int cluster) {
+		linkCluster(cluster, scratch[worker]);
+	});
+	version++;
+}
+
+int HierarchicalPathfinder::allocNode(int x, int y) {
+	int id;
+	if (!freeNodes.empty()) { id = freeNodes.back(); freeNodes.pop_back(); }
+	else					{ id = (int)nodes.size(); nodes.emplace_back(); }
+
+	Node& node	 = nodes[id];
+	node.x		 = x;
+	node.y		 = y;
+	node.cluster = clusterOf(x, y);
+	node.partner = -1;
+	node.alive	 = true;
+	node.intra.clear();
+	clusterNodes[node.cluster].push_back(id);
+	return id;
+}
+
+void HierarchicalPathfinder::freeNode(int id) {
+	Node& node = nodes[id];
+	std::vector<int>& list = clusterNodes[node.cluster];
+	list.erase(std::remove(list.begin(), list.end(), id), list.end());
+
+	node.alive = false;
+	node.intra.clear();
+	freeNodes.push_back(id);
+}
+
+/**
+ *	Finds the entrances along one cluster border.
+ *	Every run of tiles open on both sides gets an entrance in the middle, long
+ *	runs get one at each end instead so paths along the border stay short.
+ */
+void HierarchicalPathfinder::scanBorder(bool vertical, int cx, int cy) {
+	std::vector<int>& border = vertical ? verticalBorders[cy * (clustersX - 1) + cx]
+										: horizontalBorders[cy * clustersX + cx];
+
+	int from, to;		// Range along the border
+	if (vertical)	{ from = cy * clusterSize; to = std::min(height, from + clusterSize); }
+	else			{ from = cx * clusterSize; to = std::min(width, from + clusterSize);	}
+	int side = (vertical ? cx : cy) * clusterSize + clusterSize - 1;
+
+	auto open = [&](int t) {
+		return vertical ? isWalkable(side, t) && isWalkable(side + 1, t)
+						: isWalkable(t, side) && isWalkable(t, side + 1);
+	};
+	auto addEntrance = [&](int t) {
+		int a = vertical ? allocNode(side, t) : allocNode(t, side);
+		int b = vertical ? allocNode(side + 1, t) : allocNode(t, side + 1);
+		nodes[a].partner = b;
+		nodes[b].partner = a;
+		border.push_back(a);
+		border.push_back(b);
+	};
+
+	int runStart = -1;
+	for (int t = from; t <= to; t++) {
+		bool isOpen = t < to && open(t);
+		if (isOpen && runStart < 0) runStart = t;
+		if (isOpen || runStart < 0) continue;
+
+		int runEnd = t - 1;
+		if (runEnd - runStart + 1 >= longEntrance) { addEntrance(runStart); addEntrance(runEnd); }
+		else									   addEntrance((runStart + runEnd) / 2);
+		runStart = -1;
+	}
+}
+
+void HierarchicalPathfinder::clearBorder(bool vertical, int cx, int cy) {
+	std::vector<int>& border = vertical ? verticalBorders[cy * (clustersX - 1) + cx]
+										: horizontalBorders[cy * clustersX + cx];
+	for (int id : border) freeNode(id);
+	border.clear();
+}
+
+/**
+ *	Links every pair of entrances inside a cluster with their walking distance
+ */
+void HierarchicalPathfinder::linkCluster(int cluster, Scratch& scratch) {
+	prepare(scratch);
+	int x0, y0, x1, y1;
+	clusterBounds(cluster, x0, y0, x1, y1);
+
+	const std::vector<int>& list = clusterNodes[cluster];
+	for (int id : list) {
+		Node& node = nodes[id];
+		node.intra.clear();
+		localSearch(cluster, node.x, node.y, -1, -1, scratch);
+
+		for (int other : list) {
+			if (other == id) continue;
+			int local = (nodes[other].y - y0) * clusterSize + (nodes[other].x - x0);
+			if (scratch.localStamp[local] == scratch.localGen)
+				node.intra.push_back({ other, scratch.localDist[local] });
+		}
+	}
+}
+
+/**
+ *	Makes sure the scratch arrays are big enough for this graph
+ */
+void HierarchicalPathfinder::prepare(Scratch& scratch) {
+	size_t local = (size_t)clusterSize * clusterSize;
+	if (scratch.localDist.size() < local) {
+		scratch.localDist.resize(local);
+		scratch.localParent.resize(local);
+		scratch.localQueue.resize(local);
+		scratch.localStamp.assign(local, 0);
+		scratch.localGen = 0;
+	}
+
+	size_t abstract = nodes.size() + 1;		// + the goal
+	if (scratch.g.size() < abstract) {
+		scratch.g.resize(abstract);
+		scratch.parent.resize(abstract);
+		scratch.goalCost.resize(abstract);
+		scratch.stamp.assign(abstract, 0);
+		scratch.goalStamp.assign(abstract, 0);
+		scratch.gen = 0;
+	}
+}
+
+/**
+ *	Breadth first search that never leaves the cluster.
+ *	@param toX - Target tile, or -1 to reach every tile of the cluster
+ *	@return The distance to the target, -1 if it was not reached
+ */
+int HierarchicalPathfinder::localSearch(int cluster, int fromX, int fromY, int toX, int toY, Scratch& scratch) {
+	int x0, y0, x1, y1;
+	clusterBounds(cluster, x0, y0, x1, y1);
+
+	uint32_t gen = ++scratch.localGen;
+	int head = 0, tail = 0;
+	int start = (fromY - y0) * clusterSize + (fromX - x0);
+	int target = toX < 0 ? -1 : (toY - y0) * clusterSize + (toX - x0);
+
+	scratch.localStamp[start]  = gen;
+	scratch.localDist[start]   = 0;
+	scratch.localParent[start] = -1;
+	scratch.localQueue[tail++] = start;
+
+	while (head < tail) {
+		int current = scratch.localQueue[head++];
+		if (current == target) return scratch.localDist[current];
+
+		int cx = x0 + current % clusterSize, cy = y0 + current / clusterSize;
+		for (int d = 0; d < 4; d++) {
+			int nx = cx + dirX[d], ny = cy + dirY[d];
+			if (nx < x0 || ny < y0 || nx >= x1 || ny >= y1 || walls[ny * width + nx]) continue;
+
+			int next = (ny - y0) * clusterSize + (nx - x0);
+			if (scratch.localStamp[next] == gen) continue;
+			scratch.localStamp[next]  = gen;
+			scratch.localDist[next]   = scratch.localDist[current] + 1;
+			scratch.localParent[next] = current;
+			scratch.localQueue[tail++] = next;
+		}
+	}
+	return -1;
+}
+
+/**
+ *	Plans a path on the abstract graph. Only waypoints are produced, use
+ *	nextTile() to walk it.
+ *	@return false if either tile is a wall or there is no path
+ */
+bool HierarchicalPathfinder::findPath(int startX, int startY, int goalX, int goalY, HpaPath& path, Scratch& scratch) {
+	std::shared_lock<std::shared_mutex> guard(lock);
+	path.clear();
+	path.version = version;
+	if (!isWalkable(startX, startY) || !isWalkable(goalX, goalY) || clusterNodes.empty()) return false;
+
+	prepare(scratch);
+	int startCluster = clusterOf(startX, startY), goalCluster = clusterOf(goalX, goalY);
+	int gx0, gy0, gx1, gy1, sx0, sy0, sx1, sy1;
+	clusterBounds(goalCluster, gx0, gy0, gx1, gy1);
+	clusterBounds(startCluster, sx0, sy0, sx1, sy1);
+
+	// Same cluster and connected inside it: no need for the abstract graph
+	if (startCluster == goalCluster && localSearch(startCluster, startX, startY, goalX, goalY, scratch) >= 0) {
+		path.waypoints = { { startX, startY }, { goalX, goalY } };
+		recordClusters(path);
+		return true;
+	}
+
+	uint32_t gen = ++scratch.gen;
+	int goal = (int)nodes.size();
+
+	// Entrances the goal can be reached from
+	localSearch(goalCluster, goalX, goalY, -1, -1, scratch);
+	for (int id : clusterNodes[goalCluster]) {
+		int local = (nodes[id].y - gy0) * clusterSize + (nodes[id].x - gx0);
+		if (scratch.localStamp[local] != scratch.localGen) continue;
+		scratch.goalStamp[id] = gen;
+		scratch.goalCost[id]  = scratch.localDist[local];
+	}
+
+	auto h = [&](int id) {
+		return id == goal ? 0 : std::abs(nodes[id].x - goalX) + std::abs(nodes[id].y - goalY);
+	};
+	auto relax = [&](int id, int g, int from) {
+		if (scratch.stamp[id] == gen && scratch.g[id] <= g) return;
+		scratch.stamp[id]  = gen;
+		scratch.g[id]	   = g;
+		scratch.parent[id] = from;
+		scratch.open.push_back({ g + h(id), id });
+		std::push_heap(scratch.open.begin(), scratch.open.end(), std::greater<Entry>());
+	};
+
+	// Entrances reachable from the start seed the search
+	scratch.open.clear();
+	localSearch(startCluster, startX, startY, -1, -1, scratch);
+	for (int id : clusterNodes[startCluster]) {
+		int local = (nodes[id].y - sy0) * clusterSize + (nodes[id].x - sx0);
+		if (scratch.localStamp[local] == scratch.localGen)
+			relax(id, scratch.localDist[local], -1);
+	}
+
+	bool found = false;
+	while (!scratch.open.empty()) {
+		std::pop_heap(scratch.open.begin(), scratch.open.end(), std::greater<Entry>());
+		Entry top = scratch.open.back();
+		scratch.open.pop_back();
+
+		int current = top.second;
+		if (top.first - h(current) > scratch.g[current]) continue;		// Stale entry
+		if (current == goal) { found = true; break; }
+
+		const Node& node = nodes[current];
+		int g = scratch.g[current];
+		if (node.partner >= 0)				 relax(node.partner, g + 1, current);
+		for (const auto& edge : node.intra)	 relax(edge.first, g + edge.second, current);
+		if (scratch.goalStamp[current] == gen) relax(goal, g + scratch.goalCost[current], current);
+	}
+	if (!found) return false;
+
+	path.waypoints.push_back({ goalX, goalY });
+	for (int id = scratch.parent[goal]; id >= 0; id = scratch.parent[id])
+		path.waypoints.push_back({ nodes[id].x, nodes[id].y });
+	path.waypoints.push_back({ startX, startY });
+	std::reverse(path.waypoints.begin(), path.waypoints.end());
+	recordClusters(path);
+	return true;
+}
+
+/**
+ *	Remembers the version of every cluster the path crosses. Tiles between
+ *	two waypoints never leave their cluster, or step over one border.
+ */
+void HierarchicalPathfinder::recordClusters(HpaPath& path) {
+	path.clusters.clear();
+	for (const auto& waypoint : path.waypoints) {
+		int cluster = clusterOf(waypoint.first, waypoint.second);
+		if (path.clusters.empty() || path.clusters.back().first != cluster)
+			path.clusters.push_back({ cluster, clusterVersions[cluster] });
+	}
+}
+
+/**
+ *	@return false if the graph was built again or a cluster on the path changed since it was planned
+ */
+bool HierarchicalPathfinder::isCurrent(const HpaPath& path) {
+	if (path.version != version) return false;
+	for (const auto& cluster : path.clusters)
+		if (clusterVersions[cluster.first] != cluster.second) return false;
+	return true;
+}
+
+/**
+ *	Fills in the tiles between the next two waypoints
+ */
+bool HierarchicalPathfinder::refineSegment(HpaPath& path, Scratch& scratch) {
+	std::pair<int, int> from = path.waypoints[path.segment];
+	std::pair<int, int> to	 = path.waypoints[path.segment + 1];
+	path.segment++;
+	path.tiles.clear();
+	path.cursor = 0;
+
+	if (from == to) return true;
+	if (!isWalkable(to.first, to.second)) return false;
+
+	int cluster = clusterOf(from.first, from.second);
+	if (cluster != clusterOf(to.first, to.second)) {		// Crossing a border
+		if (std::abs(from.first - to.first) + std::abs(from.second - to.second) != 1) return false;
+		path.tiles.push_back(to);
+		return true;
+	}
+
+	prepare(scratch);
+	if (localSearch(cluster, from.first, from.second, to.first, to.second, scratch) < 0) return false;
+
+	int x0, y0, x1, y1;
+	clusterBounds(cluster, x0, y0, x1, y1);
+	for (int local = (to.second - y0) * clusterSize + (to.first - x0); scratch.localParent[local] >= 0;
+		 local = scratch.localParent[local])
+		path.tiles.push_back({ x0 + local % clusterSize, y0 + local / clusterSize });
+	std::reverse(path.tiles.begin(), path.tiles.end());
+	return true;
+}
+
+/**
+ *	Gives the next tile to walk to, refining the path one segment at a time.
+ *	@return false when the path is finished, or a tile changed since it was
+ *			planned (plan again with findPath() then)
+ */
+bool HierarchicalPathfinder::nextTile(HpaPath& path, Scratch& scratch, std::pair<int, int>& tile) {
+	std::shared_lock<std::shared_mutex> guard(lock);
+	if (!isCurrent(path)) { path.clear(); return false; }		// Planned on tiles that have changed
+	while (path.cursor >= path.tiles.size()) {
+		if (path.segment + 1 >= path.waypoints.size()) return false;
+		if (!refineSegment(path, scratch)) { path.clear(); return false; }
+	}
+	tile = path.tiles[path.cursor++];
+	return true;
+}
+
+bool HierarchicalPathfinder::findPath(int startX, int startY, int goalX, int goalY, HpaPath& path) {
+	static thread_local Scratch scratch;
+	return findPath(startX, startY, goalX, goalY, path, scratch);
+}
+
+bool HierarchicalPathfinder::nextTile(HpaPath& path, std::pair<int, int>& tile) {
+	static thread_local Scratch scratch;
+	return nextTile(path, scratch, tile);
+}
+
+/**
+ *	Changes a tile and repairs the graph around it. Only the cluster holding
+ *	the tile is relinked, plus the neighbour on the other side if the tile
+ *	sits on a cluster border (its entrances may have moved). Paths crossing
+ *	any of those are dropped, the others are still good.
+ */
+void HierarchicalPathfinder::setTile(int x, int y, int value) {
+	std::unique_lock<std::shared_mutex> guard(lock);
+	if (x < 0 || y < 0 || x >= width || y >= height) return;
+
+	uint8_t wall = value == 1;
+	if (walls[y * width + x] == wall) return;
+	walls[y * width + x] = wall;
+	if (clusterNodes.empty()) return;		// Not built yet, so there are no paths either
+
+	int cx = x / clusterSize, cy = y / clusterSize;
+	std::vector<int> affected = { cy * clustersX + cx };
+	auto rebuild = [&](bool vertical, int bx, int by, int neighbour) {
+		clearBorder(vertical, bx, by);
+		scanBorder(vertical, bx, by);
+		affected.push_back(neighbour);
+	};
+
+	if (x % clusterSize == 0 && cx > 0)						rebuild(true, cx - 1, cy, cy * clustersX + cx - 1);
+	if (x % clusterSize == clusterSize - 1 && cx + 1 < clustersX)	rebuild(true, cx, cy, cy * clustersX + cx + 1);
+	if (y % clusterSize == 0 && cy > 0)						rebuild(false, cx, cy - 1, (cy - 1) * clustersX + cx);
+	if (y % clusterSize == clusterSize - 1 && cy + 1 < clustersY)	rebuild(false, cx, cy, (cy + 1) * clustersX + cx);
+
+	Scratch scratch;
+	for (int cluster : affected) {
+		linkCluster(cluster, scratch);
+		clusterVersions[cluster]++;
+	}
+}
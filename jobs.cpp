@@ -0,0 +1,274 @@
+#include <algorithm>
+
+#include "headers/jobs.h"
+#include "headers/parallel.h"
+
+namespace {
+	// Which pool (and which worker in it) the calling thread belongs to
+	thread_local JobSystem*		currentSystem	= nullptr;
+	thread_local int			currentIndex	= -1;
+}
+
+
+/**
+ *	A job and what it waits for. pending counts the unfinished jobs it
+ *	depends on, plus one that submit() holds until it is done wiring it up.
+ */
+struct JobSystem::Task {
+	Job									job;
+	std::atomic<int>					pending		{ 1 };
+	std::atomic<bool>					done		{ false };
+	std::mutex							lock;				// Guards successors against finishing
+	std::vector<TaskHandle>				successors;
+};
+
+
+/**
+ *	Constructor
+ *	@param blockSize - Bytes per block, bigger allocations get a block of their own
+ */
+ScratchArena::ScratchArena(size_t blockSize) {
+	this->blockSize = blockSize;
+}
+
+/**
+ *	@return Memory for bytes that stays valid until reset()
+ */
+void* ScratchArena::allocate(size_t bytes, size_t align) {
+	while (true) {
+		if (block == blocks.size()) blocks.emplace_back(std::max(blockSize, bytes + align));
+
+		std::vector<char>& current = blocks[block];
+		uintptr_t start   = (uintptr_t)current.data() + offset;
+		size_t	  padding = (align - start % align) % align;
+		if (offset + padding + bytes <= current.size()) {
+			offset += padding + bytes;
+			return (void*)(start + padding);
+		}
+
+		// Doesn't fit, move on to the next block (or make a big enough one)
+		block++;
+		offset = 0;
+		if (block < blocks.size() && blocks[block].size() < bytes + align)
+			blocks.insert(blocks.begin() + block, std::vector<char>(bytes + align));
+	}
+}
+
+/**
+ *	@return Bytes held by the arena, used or not
+ */
+size_t ScratchArena::getCapacity() {
+	size_t total = 0;
+	for (auto& b : blocks) total += b.size();
+	return total;
+}
+
+
+/**
+ *	Constructor
+ *	@param workers - Threads in the pool, every core if 0 or less
+ */
+JobSystem::JobSystem(int workers) {
+	int count = threadCount(workers);
+	for (int i = 0; i < count; i++) queues.emplace_back(new Queue());
+	for (int i = 0; i < count; i++) this->workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+/**
+ *	Destructor, lets the workers finish what is queued
+ */
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto& worker : workers) worker.join();
+}
+
+/**
+ *	The pool everything in the game shares. One thread per core but one,
+ *	since parallelFor() puts the calling thread to work too.
+ */
+JobSystem& JobSystem::shared() {
+	static JobSystem pool(std::max(1, threadCount() - 1));
+	return pool;
+}
+
+/**
+ *	@return The calling thread's worker index in this pool, -1 if it isn't one of ours
+ */
+int JobSystem::currentWorker() {
+	return currentSystem == this ? currentIndex : -1;
+}
+
+/**
+ *	@return Scratch memory of the calling thread: its worker's, or one of its
+ *	own for threads outside the pool. Rewind it to where it was when done.
+ */
+ScratchArena& JobSystem::getScratch() {
+	thread_local ScratchArena outside;
+	int worker = currentWorker();
+	return worker >= 0 ? queues[worker]->scratch : outside;
+}
+
+/**
+ *	Queues a job to run once every task in after has finished
+ *	@return Handle to wait on, or to pass on as a dependency
+ */
+JobSystem::TaskHandle JobSystem::submit(Job job, const std::vector<TaskHandle>& after) {
+	TaskHandle task = std::make_shared<Task>();
+	task->job = std::move(job);
+
+	for (const TaskHandle& dependency : after) {
+		if (!dependency) continue;
+		std::lock_guard<std::mutex> guard(dependency->lock);
+		if (dependency->done) continue;
+		task->pending++;
+		dependency->successors.push_back(task);
+	}
+
+	if (--task->pending == 0) schedule(task);
+	return task;
+}
+
+/**
+ *	Puts a job whose dependencies are done on a deque: the calling worker's
+ *	own, or a different one every time for outside threads
+ */
+void JobSystem::schedule(const TaskHandle& task) {
+	int worker = currentWorker();
+	if (worker < 0) worker = nextQueue++ % queues.size();
+	{
+		std::lock_guard<std::mutex> guard(queues[worker]->lock);
+		queues[worker]->tasks.push_back(task);
+	}
+	queued++;
+
+	// Taking the lock makes sure a worker going to sleep has seen queued
+	{ std::lock_guard<std::mutex> guard(sleepLock); }
+	wake.notify_one();
+	if (waiting > 0) finished.notify_all();
+}
+
+/**
+ *	Newest job on our own deque, or the oldest one on somebody else's.
+ *	Outside threads (worker -1) only steal.
+ *	@return false if every deque is empty
+ */
+bool JobSystem::takeTask(int worker, TaskHandle& task) {
+	if (queued.load(std::memory_order_relaxed) == 0) return false;
+
+	int count = (int)queues.size(), first = worker >= 0 ? worker : (int)(nextQueue % count);
+	for (int k = 0; k < count; k++) {
+		Queue& queue = *queues[(first + k) % count];
+		std::lock_guard<std::mutex> guard(queue.lock);
+		if (queue.tasks.empty()) continue;
+
+		if (k == 0 && worker >= 0) { task = std::move(queue.tasks.back());  queue.tasks.pop_back();  }
+		else		{ task = std::move(queue.tasks.front()); queue.tasks.pop_front(); steals++; }
+		queued--;
+		return true;
+	}
+	return false;
+}
+
+/**
+ *	Runs a job and queues whatever was only waiting for it
+ */
+void JobSystem::run(const TaskHandle& task, int worker) {
+	task->job(worker);
+	task->job = nullptr;		// Drops whatever the job captured
+
+	std::vector<TaskHandle> ready;
+	{
+		std::lock_guard<std::mutex> guard(task->lock);
+		task->done = true;
+		ready.swap(task->successors);
+	}
+	for (const TaskHandle& successor : ready)
+		if (--successor->pending == 0) schedule(successor);
+
+	if (waiting > 0) {
+		{ std::lock_guard<std::mutex> guard(sleepLock); }
+		finished.notify_all();
+	}
+}
+
+/**
+ *	Runs jobs until the pool is torn down, sleeping while there are none
+ */
+void JobSystem::workerLoop(int worker) {
+	currentSystem = this;
+	currentIndex  = worker;
+
+	TaskHandle task;
+	while (true) {
+		if (takeTask(worker, task)) {
+			run(task, worker);
+			task.reset();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> guard(sleepLock);
+		wake.wait(guard, [&]() { return stopping || queued > 0; });
+		if (stopping && queued == 0) return;
+	}
+}
+
+bool JobSystem::isDone(const TaskHandle& task) {
+	return !task || task->done;
+}
+
+/**
+ *	Returns once the task has finished. Runs queued jobs while it waits (the
+ *	task may well be one of them) and sleeps while there are none, until a
+ *	job finishes or another one is queued.
+ */
+void JobSystem::wait(const TaskHandle& task) {
+	int worker = currentWorker();
+	TaskHandle other;
+	while (!isDone(task)) {
+		if (takeTask(worker, other)) {
+			run(other, worker);
+			other.reset();
+			continue;
+		}
+
+		waiting++;
+		{
+			std::unique_lock<std::mutex> guard(sleepLock);
+			finished.wait(guard, [&]() { return task->done.load() || queued > 0; });
+		}
+		waiting--;
+	}
+}
+
+void JobSystem::wait(const std::vector<TaskHandle>& tasks) {
+	for (const TaskHandle& task : tasks) wait(task);
+}
+
+/**
+ *	Runs job(slot, item) for every item in [0, count), spread over up to
+ *	slots jobs that take items one at a time. The calling thread takes
+ *	slot 0, so slot is in [0, slots) and can index per-slot scratch buffers
+ *	like parallelFor() in parallel.h.
+ */
+void JobSystem::parallelFor(int count, int slots, const std::function<void(int, int)>& job) {
+	slots = std::min(std::max(1, slots), count);
+	if (slots <= 1) {
+		for (int i = 0; i < count; i++) job(0, i);
+		return;
+	}
+
+	std::atomic<int> next(0);
+	auto drain = [&](int slot) {
+		for (int i = next++; i < count; i = next++) job(slot, i);
+	};
+
+	std::vector<TaskHandle> helpers;
+	for (int slot = 1; slot < slots; slot++)
+		helpers.push_back(submit([&drain, slot](int) { drain(slot); }));
+	drain(0);
+	wait(helpers);
+}
@@ -0,0 +1,399 @@
+#include <cfloat>
+#include <cstring>
+#include <iostream>
+
+#include "headers/lanesim.h"
+#include "headers/distances.h"
+
+namespace {
+	int  tileX(float x)				{ return (int)x; }
+	int  tileY(float y, int height)	{ return (int)(height - y - 1); }		// Like Sprites::coordsToTile()
+}
+
+
+/**
+ *	Constructor. Lanes go in and out through GameState, so levels and ghost
+ *	amounts that don't fit in one are turned down (see isValid()).
+ */
+LaneSim::LaneSim(const std::string& levelPath, int ghostAmount)
+	: game(levelPath, 0, ghostAmount, true), ghostAmount(ghostAmount) {
+	Map& map	= game.getMap();
+	width		= map.getWidth();
+	height		= map.getHeight();
+	tileSize	= map.getTileSize();
+	pelletWords = map.getPelletWords();
+
+	if (ghostAmount < 0 || ghostAmount > GameState::maxGhosts || pelletWords > GameState::maxTiles / 64) {
+		std::cout << "Couldnt fit " << width << "x" << height << " tiles and " << ghostAmount << " ghosts in the lanes, they take up to "
+				  << GameState::maxTiles << " tiles and " << GameState::maxGhosts << " ghosts" << std::endl;
+		this->ghostAmount = 0;
+		valid = false;
+		return;
+	}
+
+	const std::vector<std::vector<int>>& mapArr = map.getMapArray();
+	walls.resize(width * height);
+	for (int y = 0; y < height; y++)
+		for (int x = 0; x < width; x++) walls[y * width + x] = mapArr[y][x] == 1;
+
+	for (auto ghost : game.getGhosts()) personalities.push_back(ghost->getPersonality());
+
+	ghostX.resize(ghostAmount * lanes);
+	ghostY.resize(ghostAmount * lanes);
+	ghostVelX.resize(ghostAmount * lanes);
+	ghostVelY.resize(ghostAmount * lanes);
+	ghostToCentre.resize(ghostAmount * lanes);
+	ghostSpeed.resize(ghostAmount * lanes);
+	ghostDir.resize(ghostAmount * lanes);
+	ghostRng.resize(ghostAmount * lanes);
+	ghostReversals.resize(ghostAmount * lanes);
+	pellets.resize(pelletWords * lanes);
+
+	std::vector<uint32_t> seeds(lanes);
+	for (int lane = 0; lane < lanes; lane++) seeds[lane] = lane;
+	reset(seeds.data());
+}
+
+/**
+ *	Destructor
+ */
+LaneSim::~LaneSim() {
+
+}
+
+/**
+ *	Starts every lane over, with the ghosts spawned like Game::reset() does
+ *	@param seeds - One per lane
+ */
+void LaneSim::reset(const uint32_t* seeds) {
+	GameState state;
+	for (int lane = 0; lane < lanes; lane++) {
+		game.reset(seeds[lane]);
+		if (game.save(state)) load(lane, state);
+	}
+}
+
+/**
+ *	Puts a game into a lane
+ */
+void LaneSim::load(int lane, const GameState& state) {
+	if (!valid) return;
+
+	pacX[lane]		  = state.pacman.x;
+	pacY[lane]		  = state.pacman.y;
+	pacVelX[lane]	  = state.pacman.velX;
+	pacVelY[lane]	  = state.pacman.velY;
+	pacSpeed[lane]	  = state.pacman.speed;
+	pacDir[lane]	  = state.pacman.direction;
+	done[lane]		  = state.done;
+	pelletCount[lane] = state.pelletCount;
+	tick[lane]		  = state.tick;
+	modes[lane]		  = state.modes;
+
+	for (int g = 0; g < ghostAmount; g++) {
+		const GhostState& ghost = state.ghosts[g];
+		int i = g * lanes + lane;
+		ghostX[i]		  = ghost.x;
+		ghostY[i]		  = ghost.y;
+		ghostVelX[i]	  = ghost.velX;
+		ghostVelY[i]	  = ghost.velY;
+		ghostToCentre[i]  = ghost.toCentre;
+		ghostSpeed[i]	  = ghost.speed;
+		ghostDir[i]		  = ghost.dir;
+		ghostRng[i]		  = ghost.rng;
+		ghostReversals[i] = ghost.seenReversals;
+	}
+	for (int w = 0; w < pelletWords; w++) pellets[w * lanes + lane] = state.pellets[w];
+}
+
+/**
+ *	Copies a lane out, so a Game can restore() and carry on with it.
+ *	Things the lanes don't simulate (animation, camera) are left as the
+ *	Game had them before its first tick.
+ */
+void LaneSim::save(int lane, GameState& state) {
+	game.reset(0);
+	if (!valid || !game.save(state)) return;
+
+	state.pacman.x			= pacX[lane];
+	state.pacman.y			= pacY[lane];
+	state.pacman.velX		= pacVelX[lane];
+	state.pacman.velY		= pacVelY[lane];
+	state.pacman.speed		= pacSpeed[lane];
+	state.pacman.direction	= pacDir[lane];
+	state.done				= done[lane];
+	state.pelletCount		= pelletCount[lane];
+	state.tick				= tick[lane];
+	state.modes				= modes[lane];
+
+	for (int g = 0; g < ghostAmount; g++) {
+		GhostState& ghost = state.ghosts[g];
+		int i = g * lanes + lane;
+		ghost.x				= ghostX[i];
+		ghost.y				= ghostY[i];
+		ghost.velX			= ghostVelX[i];
+		ghost.velY			= ghostVelY[i];
+		ghost.toCentre		= ghostToCentre[i];
+		ghost.speed			= ghostSpeed[i];
+		ghost.dir			= ghostDir[i];
+		ghost.rng			= ghostRng[i];
+		ghost.seenReversals = ghostReversals[i];
+	}
+	for (int w = 0; w < pelletWords; w++) state.pellets[w] = pellets[w * lanes + lane];
+}
+
+/**
+ *	Advances every lane one tick
+ *	@param headings - One per lane, see headingInput()
+ */
+void LaneSim::step(const int32_t* headings) {
+	if (!valid) return;
+
+	movePacman(headings);
+	updateTargets();
+	for (int lane = 0; lane < lanes; lane++) modes[lane].update();
+	for (int g = 0; g < ghostAmount; g++) moveGhost(g);
+	for (int lane = 0; lane < lanes; lane++) tick[lane]++;
+}
+
+/**
+ *	Sprites::checkWallCollision() for every lane. The two corners ahead are
+ *	worked out for all lanes in one pass, then looked up in the walls.
+ *	@param blocked - Set to 1 for the lanes that would run into a wall
+ */
+void LaneSim::wallCollision(const float* posX, const float* posY, const char* dirs, uint8_t* blocked) {
+	const int	width = this->width, height = this->height;		// Copies, the byte stores below could alias the members
+	const float radius = tileSize / 2.f, inner = radius - 0.1f, right = width - radius - 0.1f;
+
+	// Ahead by radius, to the sides by inner, nowhere for ' '
+	int32_t corner1[lanes], corner2[lanes];
+	uint8_t edge[lanes];
+	for (int lane = 0; lane < lanes; lane++) {
+		int32_t dir	   = dirs[lane];
+		float	aheadX = (float)((dir == 'R') - (dir == 'L')),
+				aheadY = (float)((dir == 'U') - (dir == 'D')),
+				sideX  = (float)((dir == 'U') | (dir == 'D')),
+				sideY  = (float)((dir == 'L') | (dir == 'R'));
+		float x = posX[lane] + aheadX * radius, y = posY[lane] + aheadY * radius;
+		corner1[lane] = tileY(y + sideY * inner, height) * width + tileX(x + sideX * inner);
+		corner2[lane] = tileY(y - sideY * inner, height) * width + tileX(x - sideX * inner);
+		edge[lane]	  = (posX[lane] < radius) | (posX[lane] > right);
+	}
+	for (int lane = 0; lane < lanes; lane++) blocked[lane] = edge[lane] | walls[corner1[lane]] | walls[corner2[lane]];
+}
+
+/**
+ *	Pacman::movement() for every lane, with W held towards the heading.
+ *	Frozen lanes and walls only mask what is written, no pass branches.
+ */
+void LaneSim::movePacman(const int32_t* headings) {
+	const double dt = Game::step;
+
+	// Frozen lanes: caught, or out of pellets
+	int32_t active[lanes];
+	for (int lane = 0; lane < lanes; lane++) {
+		active[lane]   = (pelletCount[lane] > 0) & (done[lane] == 0);
+		pacSpeed[lane] = active[lane] ? pacSpeed[lane] : 0.f;
+	}
+
+	// Turn towards the heading if there is room. Headings 0 -> 3 walk L, U, R, D
+	// (what findCameraDirection() makes of headingInput() when W is held).
+	float	x[lanes], y[lanes];
+	int32_t stepX[lanes], stepY[lanes];
+	char	dir[lanes];
+	uint8_t blocked[lanes];
+	for (int lane = 0; lane < lanes; lane++) {
+		int32_t heading = headings[lane] & 3, vertical = heading & 1;
+		stepX[lane] = (1 - vertical) * (heading - 1);
+		stepY[lane] = vertical * (2 - heading);
+		dir[lane]	= (char)(stepX[lane] < 0 ? 'L' : stepX[lane] > 0 ? 'R' : stepY[lane] > 0 ? 'U' : 'D');
+		x[lane]		= (float)(pacX[lane] + stepX[lane] * (double)pacSpeed[lane] * dt);
+		y[lane]		= (float)((pacY[lane] - 1.f) + stepY[lane] * (double)pacSpeed[lane] * dt);
+	}
+	wallCollision(x, y, dir, blocked);
+
+	// The new values get a loop of their own, so the compiler can't move the
+	// maths under the selects (where it might trap) and keeps them vectorized
+	for (int lane = 0; lane < lanes; lane++) {
+		x[lane] = stepX[lane] * pacSpeed[lane] + 0.f;		// + 0 keeps -0 out, like Pacman
+		y[lane] = stepY[lane] * pacSpeed[lane] + 0.f;
+	}
+	for (int lane = 0; lane < lanes; lane++) {
+		bool turn = active[lane] & (blocked[lane] == 0);
+		pacVelX[lane] = turn ? x[lane] : pacVelX[lane];
+		pacVelY[lane] = turn ? y[lane] : pacVelY[lane];
+		pacDir[lane]  = turn ? dir[lane] : pacDir[lane];
+	}
+
+	// Walk, unless that runs into a wall
+	for (int lane = 0; lane < lanes; lane++) {
+		x[lane] = (float)(pacX[lane] + pacVelX[lane] * dt);
+		y[lane] = (float)((pacY[lane] - 1.f) + pacVelY[lane] * dt);
+	}
+	wallCollision(x, y, pacDir, blocked);
+	for (int lane = 0; lane < lanes; lane++) y[lane] = (float)(pacY[lane] + pacVelY[lane] * dt);
+	for (int lane = 0; lane < lanes; lane++) {
+		bool walk = active[lane] & (blocked[lane] == 0);
+		pacX[lane] = walk ? x[lane] : pacX[lane];
+		pacY[lane] = walk ? y[lane] : pacY[lane];
+	}
+
+	// Eat
+	for (int lane = 0; lane < lanes; lane++) {
+		int		  tile	= tileY(pacY[lane] - 1, height) * width + tileX(pacX[lane]);
+		uint64_t& word	= pellets[(tile >> 6) * lanes + lane];
+		uint64_t  eaten = (word >> (tile & 63)) & (uint64_t)active[lane];
+		word			  &= ~(eaten << (tile & 63));
+		pelletCount[lane] -= (int32_t)eaten;
+	}
+
+	// Get caught by ghosts that stood on the same tile last tick
+	int32_t px[lanes], py[lanes], caught[lanes] = {};
+	for (int lane = 0; lane < lanes; lane++) {
+		px[lane] = tileX(pacX[lane]);
+		py[lane] = tileY(pacY[lane], height);
+	}
+	for (int g = 0; g < ghostAmount; g++) {
+		const float* x = &ghostX[g * lanes];
+		const float* y = &ghostY[g * lanes];
+		for (int lane = 0; lane < lanes; lane++) caught[lane] |= (tileX(x[lane]) == px[lane]) & (tileY(y[lane], height) == py[lane]);
+	}
+	for (int lane = 0; lane < lanes; lane++) done[lane] = active[lane] ? (uint8_t)caught[lane] : done[lane];
+}
+
+/**
+ *	What the ghosts aim by, like Game::tick() fills in
+ */
+void LaneSim::updateTargets() {
+	for (int lane = 0; lane < lanes; lane++) {
+		GhostTargets& t = targets[lane];
+		t.pacTile	 = { tileX(pacX[lane]), tileY(pacY[lane] - 1.f, height) };
+		t.pacDir	 = pacDir[lane];
+		t.chaserTile = ghostAmount > 0 ? std::pair<int, int>(tileX(ghostX[lane]), tileY(ghostY[lane] - 1.f, height)) : t.pacTile;
+	}
+}
+
+/**
+ *	Ghosts::movement() for one ghost in every lane. The walking is done for
+ *	all lanes at once, lanes that reached a tile centre are handled after.
+ */
+void LaneSim::moveGhost(int ghost) {
+	const double dt = Game::step;
+	float*	x		 = &ghostX[ghost * lanes];
+	float*	y		 = &ghostY[ghost * lanes];
+	float*	velX	 = &ghostVelX[ghost * lanes];
+	float*	velY	 = &ghostVelY[ghost * lanes];
+	float*	toCentre = &ghostToCentre[ghost * lanes];
+	float*	speed	 = &ghostSpeed[ghost * lanes];
+	char*	dir		 = &ghostDir[ghost * lanes];
+	int32_t* seen	 = &ghostReversals[ghost * lanes];
+
+	bool active[lanes];
+	for (int lane = 0; lane < lanes; lane++) {
+		active[lane] = !(pelletCount[lane] <= 0 || done[lane]);
+		if (!active[lane]) speed[lane] = 0.f;
+	}
+
+	// Every mode change turns the ghosts around
+	for (int lane = 0; lane < lanes; lane++) {
+		int reversals = modes[lane].getReversals();
+		if (!active[lane] || reversals == seen[lane]) continue;
+		seen[lane] = reversals;
+		if (dir[lane] == ' ') continue;
+
+		dir[lane] = dir[lane] == 'U' ? 'D' : dir[lane] == 'D' ? 'U' : dir[lane] == 'L' ? 'R' : 'L';
+		velX[lane]	   = -velX[lane];
+		velY[lane]	   = -velY[lane];
+		toCentre[lane] = tileSize - toCentre[lane];
+	}
+
+	bool arrived[lanes];
+	for (int lane = 0; lane < lanes; lane++) {
+		float step = active[lane] ? (float)(speed[lane] * dt) : 0.f;
+		float newX = (float)(x[lane] + velX[lane] * dt);
+		float newY = (float)(y[lane] + velY[lane] * dt);
+		x[lane]		   = active[lane] ? newX : x[lane];
+		y[lane]		   = active[lane] ? newY : y[lane];
+		toCentre[lane] = toCentre[lane] - step;
+		arrived[lane]  = active[lane] && toCentre[lane] <= 0.f;
+	}
+
+	for (int lane = 0; lane < lanes; lane++)
+		if (arrived[lane])
+			while (toCentre[lane] <= 0.f) reachCentre(ghost, lane);
+}
+
+/**
+ *	Ghosts::reachCentre() for one lane
+ */
+void LaneSim::reachCentre(int ghost, int lane) {
+	int		i		  = ghost * lanes + lane;
+	float	overshoot = -ghostToCentre[i];
+	float	speed	  = ghostSpeed[i];
+	Map&	map		  = game.getMap();
+
+	float dirX = speed > 0.f ? ghostVelX[i] / speed : 0.f;
+	float dirY = speed > 0.f ? ghostVelY[i] / speed : 0.f;
+	std::pair<int, int> tile = { tileX(ghostX[i] - dirX * overshoot), tileY(ghostY[i] - dirY * overshoot - 1.f, height) };
+	std::pair<float, float> centre = map.getScreenCoords(tile.first + 0.5f, tile.second - 0.5f);
+	ghostX[i] = centre.first;
+	ghostY[i] = centre.second;
+
+	unsigned char exits = map.getExits(tile.first, tile.second);
+	unsigned char back	= 0;
+	switch (ghostDir[i]) {
+	case 'U': back = EXIT_D; break;
+	case 'D': back = EXIT_U; break;
+	case 'L': back = EXIT_R; break;
+	case 'R': back = EXIT_L; break;
+	}
+	if (exits & ~back) exits &= ~back;
+
+	if (exits == 0) {
+		ghostVelX[i] = ghostVelY[i] = 0.f;
+		ghostToCentre[i] = FLT_MAX;
+		return;
+	}
+
+	unsigned char chosen = exits;
+	if (exits & (exits - 1)) {
+		DistanceTable& distances = game.getDistances();
+		bool targeting = distances.isBaked() && personalities[ghost] != WANDERER;
+
+		if (!targeting) {
+			int count = 0;
+			unsigned char options[4];
+			for (unsigned char bit = EXIT_U; bit <= EXIT_R; bit <<= 1)
+				if (exits & bit) options[count++] = bit;
+			chosen = options[ghostRng[i]() % count];
+		}
+		else {
+			std::pair<int, int> target = ghostTarget(personalities[ghost], modes[lane].getMode(), targets[lane],
+													 tile, width, height, &distances);
+			target = distances.snap(target.first, target.second);
+
+			const unsigned char order[4] = { EXIT_U, EXIT_L, EXIT_D, EXIT_R };
+			const int			stepX[4] = { 0, -1, 0, 1 };
+			const int			stepY[4] = { -1, 0, 1, 0 };
+			int bestDist = 0;
+			chosen = 0;
+			for (int k = 0; k < 4; k++) {
+				if (!(exits & order[k])) continue;
+				int d = distances.estimate(tile.first + stepX[k], tile.second + stepY[k], target.first, target.second);
+				if (chosen == 0 || d < bestDist) { chosen = order[k]; bestDist = d; }
+			}
+		}
+	}
+
+	switch (chosen) {
+	case EXIT_U: ghostDir[i] = 'U'; ghostVelX[i] = 0.f;	   ghostVelY[i] = speed;  break;
+	case EXIT_D: ghostDir[i] = 'D'; ghostVelX[i] = 0.f;	   ghostVelY[i] = -speed; break;
+	case EXIT_L: ghostDir[i] = 'L'; ghostVelX[i] = -speed; ghostVelY[i] = 0.f;	  break;
+	case EXIT_R: ghostDir[i] = 'R'; ghostVelX[i] = speed;  ghostVelY[i] = 0.f;	  break;
+	}
+
+	if (overshoot > tileSize) overshoot = tileSize;
+	ghostX[i] += ghostVelX[i] / speed * overshoot;
+	ghostY[i] += ghostVelY[i] / speed * overshoot;
+	ghostToCentre[i] = tileSize - overshoot;
+}
@@ -12,18 +12,43 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
 #include "headers/map.h"
 #include "headers/sprites.h"
-#include <stb_image.h>
+#include "headers/game.h"
+#include "headers/replay.h"
+#include "headers/bot.h"
+#include "headers/vecenv.h"
+#include "headers/lanesim.h"
+#include "headers/parallel.h"
+#include "headers/simthread.h"
+#include "headers/assets.h"
+#include "headers/batch.h"
+#include "headers/pack.h"
+#include "headers/stream.h"
+#include "headers/scene.h"
+#include "headers/culling.h"
+#include "headers/swarm.h"
+#include "headers/walls.h"
+#include "headers/hpa.h"
 
 #include "shaders/spriteShader.h"
 
 int windowWidth, windowHeight, sizePerSquare = 20.f;
 int ghost_amount = 5;
+bool cooperativeGhosts = false;		// Ghosts chase pacman together (WHCA*) instead of walking randomly
+bool fixedPoint = false;			// Integer movement, same game on every machine
 
-std::string filePath = "../../../../levels/level0"; //CHANGE THIS IF YOU WANT TO LOAD A DIFFERENT MAP
+std::string filePath = "levels/level0"; //CHANGE THIS IF YOU WANT TO LOAD A DIFFERENT MAP
 
-void Camera					(const GLuint shaderprogram);
+void Camera					(const GLuint shaderprogram, const glm::vec3& cameraPos, const glm::vec3& cameraFront);
+glm::mat4 cameraProjection	();
+glm::mat4 cameraView		(const glm::vec3& cameraPos, const glm::vec3& cameraFront);
+void drawHud				(SpriteBatch& batch, const RenderFrame& frame, const AssetLoader::Layer& pacmanSheet);
 void setWindowSize			(std::string filePath);
 void error_callback			(int error, const char* description);
 void mouse_callback			(GLFWwindow* window, double xpos, double ypos);
@@ -42,14 +67,111 @@ void Light					(const GLuint shaderprogram,
 static void key_callback	(GLFWwindow* window, int key, int scancode, int action, int mods);
 
 GLuint CompileShader		(const std::string& vertexShader, const std::string& fragmentShader, const std::string& geometryShader = "");
-GLuint load_opengl_texture	(const std::string& filepath, GLuint slot);
-std::vector<Pacman*> gPacman;		//vector onlyincludeing pacman
+GLuint CompileComputeShader	(const std::string& computeShader);
+void useLayer				(const GLuint shaderprogram, const AssetLoader::Layer& layer);
+MouseLook mouseLook;				// Camera angles the player steers with the mouse
+bool replaying = false;				// Mouse is ignored while a replay steers pacman
+
+InputFrame sampleInput		(GLFWwindow* window);
+int  playHeadless			(const std::string& replayPath);
+int  playBot				(const std::string& recordPath, uint32_t seed);
+int  benchBot				(uint32_t seed);
+int  benchEnv				();
+int  benchLanes				();
+int  benchJobs				();
+int  benchHpa				(uint32_t seed);
+int  benchSwarm				(int count, uint32_t seed);
+int  benchWalls				();
+GLFWwindow* hiddenContext	();
 
 
 /**
  *	Main program
+ *	Arguments:	--record <file>	 - Saves the inputs of the game to a replay file
+ *				--replay <file>	 - Plays a replay file back
+ *				--headless		 - Plays the replay without a window, as fast as possible
+ *				--bot			 - Lets the MCTS bot play a game without a window (can be recorded)
+ *				--bench-bot		 - Measures the bot's rollouts per second on 1 thread and up
+ *				--bench-env		 - Measures how many environment steps per second VecEnv manages
+ *				--bench-lanes	 - Compares game ticks per second of Game and LaneSim on one thread
+ *				--bench-jobs	 - Measures how the job system scales from 1 worker to every core
+ *				--bench-hpa		 - Plans paths on a 4096x4096 maze from every core and checks them
+ *				--swarm <count>	 - Adds count wandering ghosts simulated by a compute shader
+ *				--bench-swarm <count> - Compares ghost ticks per second of the swarm shader and the CPU
+ *				--gpu-walls		 - Meshes the walls with a compute shader instead of on the CPU
+ *				--bench-walls	 - Times the wall mesh shader against the CPU and checks they match
+ *				--seed <number>	 - Seed for the ghosts, random if not given
+ *				--fixed			 - Moves pacman and the ghosts with fixed point math
+ *				--cooperative	 - Ghosts chase pacman together (WHCA*), recorded in the replay
+ *				--single-thread	 - Runs the simulation on the render thread, between frames
+ *				--fps <number>	 - Caps the frame rate instead of waiting for vsync, 0 for no cap
+ *	Holding R rewinds the game (up to 10 seconds), unless recording, replaying or
+ *	using cooperative ghosts.
  */
-int main() {
+int main(int argc, char** argv) {
+	std::string recordPath, replayPath;
+	bool headless = false, bot = false, benchmark = false, envBenchmark = false, laneBenchmark = false, jobBenchmark = false;
+	bool singleThread = false, gpuWalls = false, wallBenchmark = false, hpaBenchmark = false;
+	int  frameCap	  = -1;		// Frames per second, -1 for vsync
+	int  swarmCount	  = 0, swarmBenchmark = 0;		// Ghosts of the GPU swarm
+	uint32_t seed = (uint32_t)time(nullptr);
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if		(arg == "--record" && i + 1 < argc) recordPath = argv[++i];
+		else if (arg == "--replay" && i + 1 < argc) replayPath = argv[++i];
+		else if (arg == "--seed"   && i + 1 < argc) seed	   = (uint32_t)std::stoul(argv[++i]);
+		else if (arg == "--headless")				headless   = true;
+		else if (arg == "--fixed")					fixedPoint = true;
+		else if (arg == "--cooperative")			cooperativeGhosts = true;
+		else if (arg == "--single-thread")			singleThread = true;
+		else if (arg == "--fps"	   && i + 1 < argc) frameCap   = std::max(0, std::stoi(argv[++i]));
+		else if (arg == "--bot")					bot		   = true;
+		else if (arg == "--bench-bot")				benchmark  = true;
+		else if (arg == "--bench-env")				envBenchmark = true;
+		else if (arg == "--bench-lanes")			laneBenchmark = true;
+		else if (arg == "--bench-jobs")				jobBenchmark = true;
+		else if (arg == "--bench-hpa")				hpaBenchmark = true;
+		else if (arg == "--swarm" && i + 1 < argc)	swarmCount = std::max(0, std::stoi(argv[++i]));
+		else if (arg == "--bench-swarm" && i + 1 < argc) swarmBenchmark = std::max(1, std::stoi(argv[++i]));
+		else if (arg == "--gpu-walls")				gpuWalls   = true;
+		else if (arg == "--bench-walls")			wallBenchmark = true;
+		else std::cout << "Unknown argument " << arg << std::endl;
+	}
+
+	// Every asset comes out of the pack next to the executable, if it was built
+	std::string exePath = argv[0];
+	std::string exeDir	= exePath.substr(0, exePath.find_last_of("/\\") + 1);
+	if (!AssetPack::mounted().open(exeDir + "pacman.pack") && !AssetPack::mounted().open("pacman.pack"))
+		std::cout << "No asset pack found, reading loose files" << std::endl;
+
+	if (benchmark)	  return benchBot(seed);
+	if (envBenchmark) return benchEnv();
+	if (laneBenchmark) return benchLanes();
+	if (jobBenchmark) return benchJobs();
+	if (hpaBenchmark) return benchHpa(seed);
+	if (swarmBenchmark) return benchSwarm(swarmBenchmark, seed);
+	if (wallBenchmark) return benchWalls();
+	if (bot)	   return playBot(recordPath, seed);
+	if (headless) {
+		if (replayPath.empty()) {
+			std::cout << "--headless needs a replay to play" << std::endl;
+			return -1;
+		}
+		return playHeadless(replayPath);
+	}
+
+	// A replay brings its own level, seed and settings
+	ReplayPlayer player;
+	if (!replayPath.empty()) {
+		if (!player.load(replayPath)) return -1;
+		replaying		  = true;
+		filePath		  = player.getHeader().levelPath;
+		seed			  = player.getHeader().seed;
+		ghost_amount	  = player.getHeader().ghostAmount;
+		cooperativeGhosts = player.getHeader().flags & REPLAY_COOPERATIVE;
+		fixedPoint		  = player.getHeader().flags & REPLAY_FIXED;
+	}
+
 	//loader map size
 	setWindowSize(filePath); //made this a function to allow for other levels to be loaded
 
@@ -79,6 +201,7 @@ int main() {
 	// Tells it to draw stuff on 'window'
 	glfwMakeContextCurrent(window);
 	gladLoadGL();
+	glfwSwapInterval(frameCap < 0 ? 1 : 0);
 
 	// Tells openGL which callback functions we use
 	glfwSetKeyCallback(window, key_callback);
@@ -88,56 +211,137 @@ int main() {
 
 
 	// Combines shaders to a single shader program
-	GLuint shader_program = CompileShader(mapVertexShaderSrc,
-		mapFragmentShaderSrc);
-
-	GLuint pellet_shaderprogram = CompileShader(pelletVertexShaderSrc,
-		pelletFragmentShaderSrc, pelletGeometryShaderSrc);
+	GLuint scene_shaderprogram = CompileShader(sceneVertexShaderSrc,
+		sceneFragmentShaderSrc);
 
 	GLuint sprite_shaderprogram = CompileShader(spriteVertexShaderSrc,
 		spriteFragmentShaderSrc);
-	
-	double currentTime = 0.0;	// Sets a current time variable
-	glfwSetTime(0.0);			// Resets time
 
+	GLuint ghost_shaderprogram = CompileShader(modelVertexShaderSrc, modelFragmentShaderSrc);
+
+	// What is visible is worked out on the GPU, by these
+	GLuint scene_cullprogram	= CompileComputeShader(sceneCullComputeShaderSrc);
+	GLuint instance_cullprogram = CompileComputeShader(instanceCullComputeShaderSrc);
+	
+	// Textures and the ghost model are decoded on the job system while the
+	// level loads, and streamed to the GPU behind a loading screen
+	AssetLoader assets(JobSystem::shared());
+	int textureAsset = assets.loadTextures("assets/textures.tex", { "assets/walls.png", "assets/pacman.png", "assets/model/minecraft.png",
+																		 "assets/font.png" });
+	int modelAsset	 = assets.loadModel("assets/model/monster.obj");
 
 	// Creates new objects
-	Map map(filePath);
-	//Sprites pacman(&map, sprite_shaderprogram, ghost_shaderprogram);
-	Pacman pacman(&map, sprite_shaderprogram);
-	gPacman.push_back(&pacman);
+	Game game(filePath, seed, ghost_amount, false, cooperativeGhosts);
+	if (fixedPoint && !game.setFixedPoint(true))
+		std::cout << "Cooperative ghosts can't use fixed point, using floats" << std::endl;
+	Map&	pacMap = game.getMap();
+
+	ReplayRecorder recorder;
+	if (!recordPath.empty())
+		recorder.begin(filePath, seed, ghost_amount, (game.isCooperative() ? (uint32_t)REPLAY_COOPERATIVE : 0u)
+												   | (game.isFixedPoint()  ? (uint32_t)REPLAY_FIXED		  : 0u));
 	
 
-	auto spriteSheet = load_opengl_texture("assets/pacman.png", 0);
-	auto wallTexture = load_opengl_texture("assets/walls.png", 0);
-	auto ghostSheet  = load_opengl_texture("assets/model/minecraft.png", 0);
+	// Loading screen, a bar filling up while the assets arrive
+	bool firstFrame = true;
+	while (!assets.isDone() && !glfwWindowShouldClose(window)) {
+		assets.update();
 
-	// Create a texture coordinate as an aditional attribute for the square vertices
-	auto pacmanVAO = pacman.initPacman();
-	
-	
-	std::vector<GLuint> ghost_shaderprograms;
-	std::vector<Ghosts*> ghosts;
-	std::vector<GLuint> ghostVAOs; 
-
-	for (int i = 0; i < ghost_amount; i++) {
-		GLuint	shader	 = CompileShader(modelVertexShaderSrc, modelFragmentShaderSrc);
-		Ghosts* ghost	 = new Ghosts(&map, shader);
-		GLuint	ghostVao = ghost->initGhost(time(nullptr) + i);
-
-		ghost_shaderprograms.push_back(shader);
-		ghosts.push_back(ghost);
-		ghostVAOs.push_back(ghostVao);
+		glfwGetFramebufferSize(window, &windowWidth, &windowHeight);
+		glViewport(0, 0, windowWidth, windowHeight);
+		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		glEnable(GL_SCISSOR_TEST);
+		glScissor(windowWidth / 8, windowHeight / 2 - 8, (GLsizei)(windowWidth * 3 / 4 * assets.getProgress()), 16);
+		glClearColor(1.0f, 1.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		glDisable(GL_SCISSOR_TEST);
+
+		glfwPollEvents();
+		glfwSwapBuffers(window);
+		if (firstFrame) std::cout << "First frame after " << glfwGetTime() * 1000.0 << " ms" << std::endl;
+		firstFrame = false;
+	}
+	std::cout << "Assets ready after " << glfwGetTime() * 1000.0 << " ms" << std::endl;
+	for (int asset : { textureAsset, modelAsset })
+		if (assets.getState(asset) == AssetLoader::FAILED) {
+			std::cout << "The game can't run without its assets" << std::endl;
+			assets.release();
+			glfwTerminate();
+			return -1;
+		}
+
+	// Every texture is packed into one array texture, each shader samples its own part
+	auto textures = assets.getTexture(textureAsset);
+	useLayer(ghost_shaderprogram, assets.getLayer(textureAsset, 2));
+	for (auto ghost : game.getGhosts())
+		ghost->setModel(assets.getModel(modelAsset), assets.getModelVertices(modelAsset));
+
+	// Pacman and the HUD are quads of one batch, the batch works out their layers itself
+	AssetLoader::Layer pacmanSheet = assets.getLayer(textureAsset, 1);
+	// Everything that changes every frame goes through one persistently mapped buffer
+	StreamBuffer stream;
+	stream.init();
+	SpriteBatch batch;
+	batch.init(sprite_shaderprogram, stream);
+	batch.setFont(assets.getLayer(textureAsset, 3));
+
+	// The GPU mesher only takes the walls over from the scene once it is up and running
+	WallMesher walls;
+	bool meshedWalls = gpuWalls && walls.init(CompileComputeShader(wallMeshComputeShaderSrc)) && walls.build(pacMap);
+	if (gpuWalls && !meshedWalls) std::cout << "Couldnt mesh the walls on the GPU, the scene draws them" << std::endl;
+
+	// The walls and pellets never move, they are drawn with one call whatever the level's size
+	StaticScene scene;
+	scene.build(pacMap, assets.getLayer(textureAsset, 0), !meshedWalls);
+	scene.upload(scene_shaderprogram, scene_cullprogram);
+	InstanceCulling ghostCulling;
+	ghostCulling.init(instance_cullprogram);
+	const float ghostRadius = 1.5f;		// Holds the ghost model (assets/model/monster.obj)
+
+	// Stress mode: far more ghosts, walked by a compute shader and culled like the others
+	GhostSwarm		swarm(pacMap, swarmCount, seed);
+	InstanceCulling swarmCulling;
+	uint32_t		swarmTick = 0;
+	if (swarmCount) {
+		swarm.init(CompileComputeShader(swarmComputeShaderSrc));
+		swarmCulling.init(instance_cullprogram);
 	}
 
-	bool gameDone = false;		// true if game is done 
+	SnapshotRing history;		// One snapshot per tick, for rewinding
+	GameState	 rewound,
+				 snapshot;		// Only goes into the history if the game could be saved
+	bool		 canRewind = recordPath.empty() && replayPath.empty() && !cooperativeGhosts;
+
+	// Every tick gets one input, from the keyboard or from the replay.
+	// This runs on the simulation thread (or between frames with
+	// --single-thread), the loop below only draws.
+	SimThread sim(game, [&](const SimControls& controls) {
+		if (controls.rewind) {
+			if (history.pop(rewound)) game.restore(rewound);
+			return;
+		}
+
+		InputFrame input = controls.input;
+		if (replaying && !player.next(input)) return;		// Replay is over, the game stays where it ended
+
+		if (!recordPath.empty()) recorder.record(input);
+		if (canRewind && game.save(snapshot)) history.push(snapshot);
+		game.tick(input);
+
+		if (replaying && player.isDone())
+			std::cout << "Replay finished after " << player.getTick() << " ticks, "
+					  << (game.checksum() == player.getHeader().checksum ? "game matches the recording" : "game DIFFERS from the recording")
+					  << std::endl;
+	});
+	sim.start(!singleThread);
+	double	 nextFrame		 = sim.now();
+	RenderFrame frame;		// Kept between frames so interpolate() reuses its memory
+
 	bool fullscreen = false;
 	// 'Gameloopen' 
 	while (!glfwWindowShouldClose(window)) {
-		
-		double pastTime = currentTime;
-		currentTime = glfwGetTime();		// Time management
-		double dt = currentTime - pastTime;
 
 		glfwGetFramebufferSize(window, &windowWidth, &windowHeight);
 		glViewport(0, 0, windowWidth, windowHeight);
@@ -153,6 +357,19 @@ int main() {
 			}
 		}
 
+		SimControls controls;
+		controls.input	= sampleInput(window);
+		controls.rewind = canRewind && glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS;
+		sim.setControls(controls);
+		sim.advance();
+
+		// Draws from the simulation's snapshots, never from the game itself
+		sim.poll();
+		sim.interpolate(frame);
+		glm::vec3 cameraPos	  = glm::vec3(frame.pacX, frame.pacY, 1.f);
+		glm::vec3 cameraFront = replaying ? Pacman::viewDirection(frame.yaw, frame.pitch)
+										  : Pacman::viewDirection(mouseLook.yaw, mouseLook.pitch);
+
 		// Clear screen with white
 		glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
 		
@@ -162,77 +379,626 @@ int main() {
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 		glEnable(GL_DEPTH_TEST);
 
-		// Draws items on the screen
-		glUseProgram(shader_program);		// Tells our code which shader program we use
+		stream.beginFrame();
 
-		// Enables textures for the walls
+		// One texture for everything drawn this frame
 		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, wallTexture); 
-		map.drawMap();
+		glBindTexture(GL_TEXTURE_2D_ARRAY, textures);
 
-		glUseProgram(pellet_shaderprogram);
-		map.drawPellets();
+		glm::mat4 projection = cameraProjection(), view = cameraView(cameraPos, cameraFront);
+		Frustum	  frustum(projection, view);
 
-		glUseProgram(sprite_shaderprogram);
-		glBindVertexArray(pacmanVAO);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, spriteSheet);
+		// The level's walls and pellets in view, the culling also drops the pellets that are eaten
+		StreamBuffer::Range pelletMask = stream.allocate(frame.pelletWords * sizeof(uint64_t));
+		if (pelletMask) {
+			std::memcpy(pelletMask.data, frame.pelletBits.data(), pelletMask.size);
+			stream.bind(GL_SHADER_STORAGE_BUFFER, 1, pelletMask);
+		}
+		scene.draw(frustum, projection, view);
+		walls.draw(scene_shaderprogram, assets.getLayer(textureAsset, 0), projection, view);
+
+		// Every ghost shares the model, one instanced draw of those in view
+		StreamBuffer::Range ghostTransforms = stream.allocate(frame.ghostCount * sizeof(glm::mat4));
+		if (ghostTransforms && frame.ghostCount > 0 && !game.getGhosts().empty()) {
+			glm::mat4* transforms = (glm::mat4*)ghostTransforms.data;
+			for (int i = 0; i < frame.ghostCount; i++)
+				transforms[i] = Ghosts::transformation(frame.ghostX[i], frame.ghostY[i], frame.ghostDir[i]);
+			ghostCulling.cull(stream, ghostTransforms, frame.ghostCount, frustum, ghostRadius,
+							  game.getGhosts()[0]->getSize(), 6);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ghostCulling.getVisible());
+
+			Camera(ghost_shaderprogram, cameraPos, cameraFront);
+			Light(ghost_shaderprogram);
+			game.getGhosts()[0]->drawGhosts(ghostCulling.getCommand());
+		}
 
-		gameDone = pacman.movement(window, dt, ghosts, gameDone);
-		
-		for (int i = 0; i < ghost_amount; i++) {
-			
-			auto samplerSlotLocation1 = glGetUniformLocation(ghost_shaderprograms[i], "uTextureA");
-			glUseProgram(ghost_shaderprograms[i]);
-			glBindVertexArray(ghostVAOs[i]);
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, ghostSheet);
-
-			ghosts[i]->drawGhosts();
-			ghosts[i]->movement(window, dt, gameDone, time(nullptr) + i);
-			Camera(ghost_shaderprograms[i]);
-			Light(ghost_shaderprograms[i]);
+		// The swarm catches up with the game's ticks, and never leaves the GPU. It borrows the game's ghost model.
+		if (swarm.getCount() && !game.getGhosts().empty()) {
+			if (frame.tick > swarmTick) swarm.step(std::min<uint32_t>(frame.tick - swarmTick, GhostModes::ticksPerSecond));
+			swarmTick = frame.tick;
+			swarmCulling.cull(swarm.getTransforms(), swarm.getCount(), frustum, ghostRadius,
+							  game.getGhosts()[0]->getSize(), 6);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, swarmCulling.getVisible());
+
+			Camera(ghost_shaderprogram, cameraPos, cameraFront);
+			Light(ghost_shaderprogram);
+			game.getGhosts()[0]->drawGhosts(swarmCulling.getCommand());
 		}
 
-		Camera(shader_program);
-		Camera(pellet_shaderprogram);
-		Camera(sprite_shaderprogram);
+		// Every 2D quad of the frame: pacman in the world, then the HUD over everything
+		batch.begin();
+		float tile = pacMap.getTileSize();
+		batch.sprite(frame.pacX - 0.5f, frame.pacY - 0.5f + tile, frame.pacX - 0.5f + tile, frame.pacY - 0.5f, pacmanSheet,
+					 PacmanSheet::columns, PacmanSheet::rows, PacmanSheet::walking(frame.pacDir).frameAt(frame.animationTime));
+		batch.flush(projection, view);
+
+		glDisable(GL_DEPTH_TEST);
+		drawHud(batch, frame, pacmanSheet);
+		batch.flush(glm::ortho(0.f, (float)windowWidth, (float)windowHeight, 0.f));
+		stream.endFrame();
 
 		// Updates
 		glfwPollEvents();
 
 		// Display
 		glfwSwapBuffers(window);
+
+		// Holds the frame rate down without touching the game speed
+		if (frameCap > 0) {
+			nextFrame = std::max(nextFrame + 1.0 / frameCap, sim.now() - 1.0 / frameCap);
+			std::this_thread::sleep_for(std::chrono::duration<double>(nextFrame - sim.now()));
+		}
 	}
+	sim.stop();
+
+	if (!recordPath.empty() && recorder.save(recordPath, game.checksum()))
+		std::cout << "Recorded " << recorder.getTicks() << " ticks to " << recordPath
+				  << " (" << recorder.getSize() << " bytes of input)" << std::endl;
 
 	// Lag en funksjon som sletter shaderprograms
 
-	glDeleteTextures(1, &spriteSheet);
+	batch.release();
+	ghostCulling.release();
+	swarmCulling.release();
+	swarm.release();
+	walls.release();
+	scene.release();
+	stream.release();
+	assets.release();
 	// Terminate
 	glfwDestroyWindow(window);
 	glfwTerminate();
 	return 0;
 }
 
+/**
+ *	Plays a replay without a window, as fast as the simulation runs,
+ *	and checks that it ends the way the recording did
+ *	@return 0 if the game matched the recording
+ */
+int playHeadless(const std::string& replayPath) {
+	ReplayPlayer player;
+	if (!player.load(replayPath)) return -1;
+
+	ReplayHeader& header = player.getHeader();
+	Game game(header.levelPath, header.seed, header.ghostAmount, true, header.flags & REPLAY_COOPERATIVE);
+	game.setFixedPoint(header.flags & REPLAY_FIXED);
+
+	auto start = std::chrono::steady_clock::now();
+	InputFrame input;
+	while (player.next(input)) game.tick(input);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	bool matches = player.isDone() && game.checksum() == header.checksum;
+	std::cout << "Played " << player.getTick() << " ticks in " << seconds * 1000.0 << " ms ("
+			  << (seconds > 0.0 ? player.getTick() / seconds : 0.0) << " ticks/sec), "
+			  << (matches ? "game matches the recording" : "game DIFFERS from the recording") << std::endl;
+	return matches ? 0 : 1;
+}
+
+/**
+ *	Lets the bot play one game, as fast as it can think, until pacman is
+ *	caught or three minutes of game time have passed
+ *	@param recordPath - Saves the game as a replay if not empty
+ */
+int playBot(const std::string& recordPath, uint32_t seed) {
+	const int rollouts = 400;					// Per decision
+	const uint32_t maxTicks = 3 * 60 * GhostModes::ticksPerSecond;
+
+	Game	  game(filePath, seed, ghost_amount, true);
+	MctsBot	  bot(filePath, seed, ghost_amount);
+	GameState state;
+	ReplayRecorder recorder;
+	recorder.begin(filePath, seed, ghost_amount);
+
+	int pellets = game.getMap().getp_count();
+	while (!game.isDone() && game.getTick() < maxTicks) {
+		game.save(state);
+		InputFrame input = headingInput(bot.think(state, rollouts));
+		for (int t = 0; t < bot.getDecisionTicks(); t++) {
+			recorder.record(input);
+			game.tick(input);
+		}
+	}
+
+	std::cout << "Bot " << (game.isDone() ? "was caught" : "survived") << " after " << game.getTick() << " ticks, ate "
+			  << pellets - game.getMap().getp_count() << " of " << pellets << " pellets ("
+			  << bot.getRolloutsPerSecond() << " rollouts/sec on " << bot.getThreads() << " threads)" << std::endl;
+
+	if (!recordPath.empty()) recorder.save(recordPath, game.checksum());
+	return 0;
+}
+
+/**
+ *	Measures how many rollouts per second the bot gets through from the
+ *	start of a game, on 1, 2, 4... threads up to every core
+ */
+int benchBot(uint32_t seed) {
+	const int decisions = 20, rollouts = 2000;
+
+	Game	  game(filePath, seed, ghost_amount, true);
+	GameState state;
+	game.save(state);
+
+	for (int threads = 1; ; threads *= 2) {
+		threads = std::min(threads, threadCount());
+		MctsBot bot(filePath, seed, ghost_amount, threads);
+		for (int i = 0; i < decisions; i++) bot.think(state, rollouts);
+
+		std::cout << threads << " threads: " << (uint64_t)bot.getRolloutsPerSecond() << " rollouts/sec" << std::endl;
+		if (threads == threadCount()) break;
+	}
+	return 0;
+}
+
+/**
+ *	Steps 64 games with random actions for a few seconds and prints how many
+ *	environment steps per second that was
+ */
+int benchEnv() {
+	const int envs = 64, steps = 2000;
+
+	VecEnv env(filePath, envs, ghost_amount);
+	env.reset(nullptr);
+
+	std::vector<int32_t> actions(envs);
+	GhostRng rng;
+	auto start = std::chrono::steady_clock::now();
+	for (int s = 0; s < steps; s++) {
+		for (auto& action : actions) action = rng() % VecEnv::actions;
+		env.step(actions.data());
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << envs << " games, " << threadCount() << " threads: " << (uint64_t)(env.getSteps() / seconds)
+			  << " environment steps/sec" << std::endl;
+	return 0;
+}
+
+/**
+ *	Runs the jobs that use the job system with 1 worker and up, and prints
+ *	how much faster each gets: baking the distance table, building the
+ *	wall mesh row by row and stepping 64 environments
+ */
+int benchJobs() {
+	Map map(filePath, true);
+	DistanceTable table(map.getMapArray());
+	std::vector<float>		  vertices;
+	std::vector<unsigned int> indices;
+
+	auto timed = [](int repeats, const std::function<void()>& job) {
+		auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < repeats; r++) job();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repeats;
+	};
+
+	double bake1 = 0.0, mesh1 = 0.0, env1 = 0.0;
+	std::cout << "workers   distance bake        wall mesh            env steps/sec" << std::endl;
+	for (int workers = 1; workers <= threadCount(); workers++) {
+		double bake = timed(5,	  [&]() { table.bake(workers); });
+		double mesh = timed(2000, [&]() { map.buildWallMesh(vertices, indices, workers); });
+
+		VecEnv env(filePath, 64, ghost_amount, 4, workers);
+		env.reset(nullptr);
+		std::vector<int32_t> actions(64);
+		GhostRng rng;
+		double step = timed(200, [&]() {
+			for (auto& action : actions) action = rng() % VecEnv::actions;
+			env.step(actions.data());
+		});
+
+		if (workers == 1) { bake1 = bake; mesh1 = mesh; env1 = step; }
+		printf("%7d %9.2f ms (%4.1fx) %9.1f us (%4.1fx) %12.0f (%4.1fx)\n", workers,
+			   bake * 1000.0, bake1 / bake, mesh * 1e6, mesh1 / mesh, 64 / step, env1 / step);
+	}
+	std::cout << JobSystem::shared().getSteals() << " jobs stolen" << std::endl;
+	return 0;
+}
+
+/**
+ *	Carves a size x size maze with some loops knocked into it, plans paths
+ *	between random tiles with HierarchicalPathfinder from 1 worker and from
+ *	every core, and checks them: every path is walked with nextTile() and has
+ *	to step between open neighbours up to its goal, and a few are measured
+ *	against a breadth first search. Then walls are moved with setTile(), the
+ *	paths planned before have to be dropped if a wall went up on them and
+ *	still walk to their goal if not, and the new ones have to be valid again.
+ *	@return 0 if every path checked out, 1 if not
+ */
+int benchHpa(uint32_t seed) {
+	const int size = 4096, queries = 128, exact = 8, edits = 64;
+	const int dx[4] = { 1, -1, 0, 0 }, dy[4] = { 0, 0, 1, -1 };
+	GhostRng rng;
+	rng.seed(seed);
+
+	// Depth first carving between the odd tiles, then a few walls between them opened again
+	std::vector<std::vector<int>> grid(size, std::vector<int>(size, 1));
+	const int cells = (size - 1) / 2;
+	std::vector<int> stack = { 0 };
+	grid[1][1] = 0;
+	while (!stack.empty()) {
+		int cx = stack.back() % cells, cy = stack.back() / cells;
+		int options[4], count = 0;
+		for (int d = 0; d < 4; d++) {
+			int nx = cx + dx[d], ny = cy + dy[d];
+			if (nx >= 0 && ny >= 0 && nx < cells && ny < cells && grid[ny * 2 + 1][nx * 2 + 1] == 1) options[count++] = d;
+		}
+		if (count == 0) { stack.pop_back(); continue; }
+		int d = options[rng() % count];
+		grid[cy * 2 + 1 + dy[d]][cx * 2 + 1 + dx[d]] = 0;
+		grid[(cy + dy[d]) * 2 + 1][(cx + dx[d]) * 2 + 1] = 0;
+		stack.push_back((cy + dy[d]) * cells + cx + dx[d]);
+	}
+	auto door = [&]() {		// A tile between two cells, never a cell itself
+		int x = 1 + rng() % (size - 2), y = 1 + rng() % (size - 2);
+		return std::make_pair(x, ((x + y) % 2 == 1) ? y : (y == size - 2 ? y - 1 : y + 1));
+	};
+	for (int i = 0; i < size * size / 32; i++) {
+		auto tile = door();
+		grid[tile.second][tile.first] = 0;
+	}
+
+	HierarchicalPathfinder hpa(grid);
+	auto timed = [](const std::function<void()>& job) {
+		auto start = std::chrono::steady_clock::now();
+		job();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	};
+	double build = timed([&]() { hpa.build(); });
+	std::cout << size << "x" << size << " maze, " << hpa.getNodeCount() << " entrances, built in "
+			  << build * 1000.0 << " ms" << std::endl;
+
+	// Starts and goals are cells, so moving the walls between them never closes one
+	std::vector<std::pair<int, int>> starts(queries), goals(queries);
+	for (int q = 0; q < queries; q++) {
+		starts[q] = { 1 + 2 * (int)(rng() % cells), 1 + 2 * (int)(rng() % cells) };
+		goals[q]  = { 1 + 2 * (int)(rng() % cells), 1 + 2 * (int)(rng() % cells) };
+	}
+
+	std::vector<HpaPath> paths(queries);
+	std::vector<HierarchicalPathfinder::Scratch> scratch(threadCount());
+	std::vector<char> found(queries);
+	auto plan = [&](int threads) {
+		return timed([&]() {
+			parallelFor(queries, threads, [&](int worker, int q) {
+				found[q] = hpa.findPath(starts[q].first, starts[q].second, goals[q].first, goals[q].second, paths[q], scratch[worker]);
+			});
+		});
+	};
+
+	// Tiles walked to the goal, -1 if a step isn't to an open neighbour or it stops short
+	std::vector<int> lengths(queries);
+	auto walk = [&](int worker, int q, HpaPath& path, std::vector<std::pair<int, int>>* tiles) {
+		std::pair<int, int> at = starts[q], next;
+		int length = 0;
+		while (hpa.nextTile(path, scratch[worker], next)) {
+			if (std::abs(next.first - at.first) + std::abs(next.second - at.second) != 1 || !hpa.isWalkable(next.first, next.second))
+				return -1;
+			if (tiles) tiles->push_back(next);
+			at = next;
+			length++;
+		}
+		return at == goals[q] ? length : -1;
+	};
+
+	// Breadth first over the tiles the pathfinder has now, -1 if the goal can't be reached
+	std::vector<int> dist((size_t)size * size), queue((size_t)size * size);
+	auto shortest = [&](int q) {
+		std::fill(dist.begin(), dist.end(), -1);
+		size_t head = 0, tail = 0;
+		int from = starts[q].second * size + starts[q].first, to = goals[q].second * size + goals[q].first;
+		dist[from] = 0;
+		queue[tail++] = from;
+		while (head < tail && dist[to] < 0) {
+			int tile = queue[head++], x = tile % size, y = tile / size;
+			for (int d = 0; d < 4; d++) {
+				int nx = x + dx[d], ny = y + dy[d], next = ny * size + nx;
+				if (nx < 0 || ny < 0 || nx >= size || ny >= size || dist[next] >= 0 || !hpa.isWalkable(nx, ny)) continue;
+				dist[next] = dist[tile] + 1;
+				queue[tail++] = next;
+			}
+		}
+		return dist[to];
+	};
+
+	int invalid = 0;
+	auto check = [&](const char* label) {
+		std::vector<int> bad(queries, 0);
+		parallelFor(queries, 0, [&](int worker, int q) {
+			lengths[q] = found[q] ? walk(worker, q, paths[q], nullptr) : -1;
+			bad[q] = found[q] && lengths[q] < 0;
+		});
+		int broken = (int)std::count(bad.begin(), bad.end(), 1), missing = 0;
+		double longer = 0.0;
+		for (int q = 0; q < exact; q++) {
+			int best = shortest(q);
+			if ((best >= 0) != (bool)found[q] || (found[q] && lengths[q] < best)) missing++;
+			else if (best > 0) longer += (double)lengths[q] / best;
+		}
+		std::cout << label << ": " << std::count(found.begin(), found.end(), 1) << "/" << queries << " found, "
+				  << broken << " invalid, " << missing << "/" << exact << " disagree with BFS, "
+				  << (longer / exact - 1.0) * 100.0 << "% longer than the shortest" << std::endl;
+		invalid += broken + missing;
+	};
+
+	double one = plan(1), all = plan(threadCount());
+	std::cout << queries << " paths: " << queries / one << " paths/sec on 1 thread, " << queries / all
+			  << " paths/sec on " << threadCount() << " threads (" << one / all << "x)" << std::endl;
+	check("Planned");
+
+	// Wall off a door on the first paths and open others, the walled off paths have to go
+	plan(0);
+	std::vector<char> walled(queries);
+	for (int q = 0; q < edits; q++) {
+		std::vector<std::pair<int, int>> tiles;
+		HpaPath walked = paths[q];
+		if (!found[q] || walk(0, q, walked, &tiles) < 0) continue;
+		for (size_t t = tiles.size() / 2; t < tiles.size() && !walled[q]; t++) {
+			if ((tiles[t].first + tiles[t].second) % 2 == 1) { hpa.setTile(tiles[t].first, tiles[t].second, 1); walled[q] = true; }
+		}
+		auto opened = door();
+		hpa.setTile(opened.first, opened.second, 0);
+	}
+	int stale = 0, kept = 0, dropped = 0;
+	for (int q = 0; q < queries; q++) {
+		if (!found[q]) continue;
+		int length = walk(0, q, paths[q], nullptr);
+		if (paths[q].empty())				dropped++;
+		else if (length >= 0 && !walled[q]) kept++;
+		else								stale++;
+	}
+	std::cout << 2 * edits << " tiles changed, " << dropped << " paths from before dropped, " << kept
+			  << " still walk to their goal, " << stale << " broken" << std::endl;
+	invalid += stale;
+
+	double replan = plan(0);
+	std::cout << "Replanned in " << replan * 1000.0 << " ms" << std::endl;
+	check("Replanned");
+	return invalid > 0 ? 1 : 0;
+}
+
+/**
+ *	Plays LaneSim::lanes games with random headings, first as separate Games
+ *	and then packed into a LaneSim, and prints game ticks per second of both.
+ *	Both runs are given the same headings, and every lane is saved at the end
+ *	of each episode and compared with the Game that played it.
+ *	@return 0 if every lane matched its Game, 1 if not
+ */
+int benchLanes() {
+	const int lanes = LaneSim::lanes, ticks = 20000, episode = 2000, decisions = (ticks + 5) / 6;
+
+	uint32_t seeds[lanes];
+	for (int i = 0; i < lanes; i++) seeds[i] = i;
+
+	// A new heading every 6 ticks, drawn up front so both runs steer the same
+	std::vector<int32_t> headings(decisions * lanes);
+	GhostRng rng;
+	for (auto& heading : headings) heading = rng() % 4;
+
+	std::vector<std::unique_ptr<Game>> games;
+	for (int i = 0; i < lanes; i++) games.emplace_back(new Game(filePath, seeds[i], ghost_amount, true));
+	LaneSim sim(filePath, ghost_amount);
+	if (!sim.isValid()) return 1;
+
+	// Every lane at the end of every episode, [episode * lanes + lane]
+	std::vector<GameState> gameEnds((ticks / episode + 1) * lanes), laneEnds(gameEnds.size());
+
+	auto start = std::chrono::steady_clock::now();
+	for (int t = 0; t < ticks; t++) {
+		for (int i = 0; i < lanes; i++) {
+			if (t % episode == 0) {
+				if (t > 0) games[i]->save(gameEnds[(t / episode - 1) * lanes + i]);
+				games[i]->reset(seeds[i]);
+			}
+			games[i]->tick(headingInput(headings[t / 6 * lanes + i]));
+		}
+	}
+	double gameSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	for (int i = 0; i < lanes; i++) games[i]->save(gameEnds[(ticks - 1) / episode * lanes + i]);
+
+	start = std::chrono::steady_clock::now();
+	for (int t = 0; t < ticks; t++) {
+		if (t % episode == 0) {
+			if (t > 0)
+				for (int i = 0; i < lanes; i++) sim.save(i, laneEnds[(t / episode - 1) * lanes + i]);
+			sim.reset(seeds);
+		}
+		sim.step(&headings[t / 6 * lanes]);
+	}
+	double laneSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	for (int i = 0; i < lanes; i++) sim.save(i, laneEnds[(ticks - 1) / episode * lanes + i]);
+
+	// Only what LaneSim simulates, the camera and animation are left as they were
+	int mismatches = 0, ends = ((ticks - 1) / episode + 1) * lanes, pelletWords = games[0]->getMap().getPelletWords();
+	for (int e = 0; e < ends; e++) {
+		const GameState& a = gameEnds[e];
+		const GameState& b = laneEnds[e];
+		GhostModes am = a.modes, bm = b.modes;
+		bool same = a.tick == b.tick && a.done == b.done && a.pelletCount == b.pelletCount
+				 && am.getTick() == bm.getTick() && am.getMode() == bm.getMode() && am.getReversals() == bm.getReversals()
+				 && a.pacman.x == b.pacman.x && a.pacman.y == b.pacman.y && a.pacman.velX == b.pacman.velX
+				 && a.pacman.velY == b.pacman.velY && a.pacman.speed == b.pacman.speed && a.pacman.direction == b.pacman.direction
+				 && memcmp(a.pellets, b.pellets, pelletWords * sizeof(uint64_t)) == 0;
+		for (int g = 0; g < ghost_amount && same; g++) {
+			const GhostState& ag = a.ghosts[g];
+			const GhostState& bg = b.ghosts[g];
+			same = ag.x == bg.x && ag.y == bg.y && ag.velX == bg.velX && ag.velY == bg.velY && ag.toCentre == bg.toCentre
+				&& ag.speed == bg.speed && ag.dir == bg.dir && ag.seenReversals == bg.seenReversals
+				&& ag.rng.state == bg.rng.state;
+		}
+		if (!same) mismatches++;
+	}
+
+	std::cout << "Game:    " << (uint64_t)(ticks * lanes / gameSeconds) << " game ticks/sec" << std::endl;
+	std::cout << "LaneSim: " << (uint64_t)(ticks * lanes / laneSeconds) << " game ticks/sec ("
+			  << lanes << " lanes)" << std::endl;
+	std::cout << ends - mismatches << " of " << ends << " lanes match their Game"
+			  << (mismatches ? ", LaneSim DIFFERS" : "") << std::endl;
+	return mismatches ? 1 : 0;
+}
+
+/**
+ *	Walks a swarm of ghosts for 10 seconds of ticks with the compute shader
+ *	and with GhostSwarm::stepReference(), prints ghost ticks per second of
+ *	both and whether they ended up with the same ghosts.
+ *	Needs a GL 4.3 context, the window for it is never shown.
+ */
+int benchSwarm(int count, uint32_t seed) {
+	const int ticks = GhostModes::ticksPerSecond * 10;
+
+	GLFWwindow* window = hiddenContext();
+	if (window == NULL) return -1;
+
+	Map		   map(filePath, true);
+	GhostSwarm swarm(map, count, seed);
+	if (!swarm.init(CompileComputeShader(swarmComputeShaderSrc))) {
+		glfwTerminate();
+		return -1;
+	}
+	glFinish();
+
+	auto start = std::chrono::steady_clock::now();
+	for (int t = 0; t < ticks; t++) swarm.step(1);
+	glFinish();
+	double gpuSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::vector<GhostSwarm::Ghost> cpu = swarm.getSpawn(), gpu;
+	start = std::chrono::steady_clock::now();
+	swarm.stepReference(cpu, ticks);
+	double cpuSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	swarm.read(gpu);
+	bool same = cpu.size() == gpu.size()
+			 && std::memcmp(cpu.data(), gpu.data(), cpu.size() * sizeof(GhostSwarm::Ghost)) == 0;
+
+	std::cout << "GPU: " << (uint64_t)(ticks * (double)swarm.getCount() / gpuSeconds) << " ghost ticks/sec" << std::endl;
+	std::cout << "CPU: " << (uint64_t)(ticks * (double)swarm.getCount() / cpuSeconds) << " ghost ticks/sec ("
+			  << swarm.getCount() << " ghosts, " << ticks << " ticks)" << std::endl;
+	std::cout << (same ? "Swarm matches the CPU" : "Swarm DIFFERS from the CPU") << std::endl;
+
+	swarm.release();
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return same ? 0 : 1;
+}
+
+/**
+ *	Meshes the level's walls with Map::buildWallMesh() and with WallMesher,
+ *	prints how long each took and whether the meshes are the same, byte
+ *	for byte. Needs a GL 4.3 context, the window for it is never shown.
+ */
+int benchWalls() {
+	const int repeats = 200;
+
+	GLFWwindow* window = hiddenContext();
+	if (window == NULL) return -1;
+
+	Map		   map(filePath, true);
+	WallMesher walls;
+	if (!walls.init(CompileComputeShader(wallMeshComputeShaderSrc))) {
+		glfwTerminate();
+		return -1;
+	}
+	walls.build(map);		// Lets the driver compile the shader before the clock starts
+	glFinish();
+
+	auto start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeats; r++) walls.mesh();
+	glFinish();
+	double gpuSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repeats;
+
+	std::vector<float>		  cpuVertices, gpuVertices;
+	std::vector<unsigned int> cpuIndices, gpuIndices;
+	start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeats; r++) map.buildWallMesh(cpuVertices, cpuIndices);
+	double cpuSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repeats;
+
+	walls.read(gpuVertices, gpuIndices);
+	bool same = cpuVertices.size() == gpuVertices.size() && cpuIndices.size() == gpuIndices.size()
+			 && std::memcmp(cpuVertices.data(), gpuVertices.data(), cpuVertices.size() * sizeof(float)) == 0
+			 && std::memcmp(cpuIndices.data(), gpuIndices.data(), cpuIndices.size() * sizeof(unsigned int)) == 0;
+
+	std::cout << "GPU: " << gpuSeconds * 1e6 << " us per mesh" << std::endl;
+	std::cout << "CPU: " << cpuSeconds * 1e6 << " us per mesh (" << walls.getWalls() << " walls, "
+			  << threadCount() << " threads)" << std::endl;
+	std::cout << (same ? "Wall mesh matches the CPU" : "Wall mesh DIFFERS from the CPU") << std::endl;
+
+	walls.release();
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return same ? 0 : 1;
+}
+
+/**
+ *	Makes a GL 4.3 context for the benchmarks, in a window that is never shown
+ *	@return The window, NULL if there is no context
+ */
+GLFWwindow* hiddenContext() {
+	if (!glfwInit()) {
+		std::cout << "OpenGL failed to initialize" << std::endl;
+		return NULL;
+	}
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(64, 64, "Pacman benchmark", NULL, NULL);
+	if (window == NULL) {
+		std::cout << "OpenGL-window could not be created." << std::endl;
+		glfwTerminate();
+		return NULL;
+	}
+	glfwMakeContextCurrent(window);
+	gladLoadGL();
+	return window;
+}
+
+/**
+ *	Reads the keyboard and camera into the input for one tick.
+ *	The view angles are rounded to what a replay stores, so recorded and
+ *	live games see the same numbers.
+ */
+InputFrame sampleInput(GLFWwindow* window) {
+	InputFrame input;
+	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) input.keys |= KEY_W;
+	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) input.keys |= KEY_A;
+	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) input.keys |= KEY_S;
+	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) input.keys |= KEY_D;
+	input.yaw	= (int32_t)std::lround(mouseLook.yaw * 1000.0);
+	input.pitch = (int32_t)std::lround(mouseLook.pitch * 1000.0);
+	return input;
+}
+
 
 // -----------------------------------------------------------------------------
 // Code handling the camera
 // -----------------------------------------------------------------------------
-void Camera(const GLuint shaderprogram) {
-
-	//Mouse implimentation
-// camera
-	glm::vec3 cameraPos = glm::vec3(gPacman[0]->getPacPos().first, gPacman[0]->getPacPos().second, 1.f);
-	glm::vec3 cameraFront = gPacman[0]->getCameraFront();
-	glm::vec3 cameraUp = glm::vec3(0.f, 0.f, 1.f);
+void Camera(const GLuint shaderprogram, const glm::vec3& cameraPos, const glm::vec3& cameraFront) {
 
 	glUseProgram(shaderprogram);
 
-	glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)windowWidth / (float)windowHeight, 0.1f, 100.0f);
-
-	//Matrix which defines where in the scene our camera is
-	//                           Position of camera     Direction camera is looking     Vector pointing upwards
-	glm::mat4 view = glm::lookAt(cameraPos, (cameraPos + cameraFront), cameraUp);
+	glm::mat4 projection = cameraProjection();
+	glm::mat4 view		 = cameraView(cameraPos, cameraFront);
 
 	//Get unforms to place our matrices into
 	GLuint projmat = glGetUniformLocation(shaderprogram, "u_ProjectionMat");
@@ -244,9 +1010,68 @@ void Camera(const GLuint shaderprogram) {
 }
 
 
+/**
+ *	@return The camera's perspective, for the window as it is now
+ */
+glm::mat4 cameraProjection() {
+	return glm::perspective(glm::radians(45.0f), (float)windowWidth / (float)windowHeight, 0.1f, 100.0f);
+}
+
+/**
+ *	@return Matrix which defines where in the scene our camera is
+ */
+glm::mat4 cameraView(const glm::vec3& cameraPos, const glm::vec3& cameraFront) {
+	glm::vec3 cameraUp = glm::vec3(0.f, 0.f, 1.f);
+
+	//                 Position of camera     Direction camera is looking     Vector pointing upwards
+	return glm::lookAt(cameraPos, (cameraPos + cameraFront), cameraUp);
+}
+
+/**
+ *	Adds the HUD to the batch, in pixels from the top left corner: the
+ *	score, pacman's lives and the pellets left, and how the game ended
+ */
+void drawHud(SpriteBatch& batch, const RenderFrame& frame, const AssetLoader::Layer& pacmanSheet) {
+	const uint32_t yellow = SpriteBatch::rgba(255, 255, 0), white = SpriteBatch::rgba(255, 255, 255);
+	float size	 = std::max(16.f, std::round(windowHeight / 36.f));
+	float margin = size / 2.f;
+
+	// 10 points a pellet, like the arcade
+	int	 score	= (frame.pelletTotal - frame.pellets) * 10;
+	bool caught = frame.done && frame.pellets > 0;
+	batch.text("SCORE " + std::to_string(score), margin, margin, size, yellow);
+
+	std::string pellets = std::to_string(frame.pellets) + "/" + std::to_string(frame.pelletTotal);
+	batch.text(pellets, windowWidth - margin - SpriteBatch::textWidth(pellets, size), margin, size, white);
+
+	// The game has a single life, it is gone once a ghost has caught pacman
+	int lives = caught ? 0 : 1;
+	for (int i = 0; i < lives; i++) {
+		float x = margin + i * size * 1.25f, y = windowHeight - margin - size;
+		batch.sprite(x, y, x + size, y + size, pacmanSheet, PacmanSheet::columns, PacmanSheet::rows, PacmanSheet::right[2]);
+	}
+
+	if (frame.done) {
+		std::string message = caught ? "GAME OVER" : "YOU WIN!";
+		float		big		= size * 2.f;
+		batch.text(message, (windowWidth - SpriteBatch::textWidth(message, big)) / 2.f, (windowHeight - big) / 2.f, big, yellow);
+	}
+}
+
+/**
+ *	Points a shader at its image in the array texture
+ */
+void useLayer(const GLuint shaderprogram, const AssetLoader::Layer& layer) {
+	glUseProgram(shaderprogram);
+	glUniform1i(glGetUniformLocation(shaderprogram, "u_Layer"), layer.layer);
+	glUniform2f(glGetUniformLocation(shaderprogram, "u_LayerScale"), layer.scaleU, layer.scaleV);
+	glUniform2f(glGetUniformLocation(shaderprogram, "u_LayerOffset"), layer.offsetU, layer.offsetV);
+}
+
+
 void mouse_callback(GLFWwindow* window, double xpos, double ypos){
 	
-	gPacman[0]->updateCamera(xpos, ypos);
+	if (!replaying) mouseLook.move(xpos, ypos);
 }
 
 // -----------------------------------------------------------------------------
@@ -309,6 +1134,42 @@ GLuint CompileShader(const std::string& vertexShaderSrc,
 	return shaderProgram;
 }
 
+/**
+ *	Compiles a compute shader into a program of its own
+ *	@return the program, 0 if it didn't compile or link
+ */
+GLuint CompileComputeShader(const std::string& computeShaderSrc) {
+	auto computeSrc = computeShaderSrc.c_str();
+	auto shaderProgram = glCreateProgram();
+
+	int  success;
+	char infoLog[512];
+
+	auto computeShader = glCreateShader(GL_COMPUTE_SHADER);
+	glShaderSource(computeShader, 1, &computeSrc, nullptr);
+	glCompileShader(computeShader);
+	glGetShaderiv(computeShader, GL_COMPILE_STATUS, &success);
+	if (!success) {
+		glGetShaderInfoLog(computeShader, 512, NULL, infoLog);
+		std::cout << "ERROR::SHADER::COMPUTE::COMPILATION_FAILED\n" << infoLog << std::endl;
+		glDeleteShader(computeShader);
+		glDeleteProgram(shaderProgram);
+		return 0;
+	}
+	glAttachShader(shaderProgram, computeShader);
+	glDeleteShader(computeShader);
+
+	glLinkProgram(shaderProgram);
+	glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+	if (!success) {
+		glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+		std::cout << "ERROR::SHADER::COMPUTE::LINKING_FAILED\n" << infoLog << std::endl;
+		glDeleteProgram(shaderProgram);
+		return 0;
+	}
+	return shaderProgram;
+}
+
 // -----------------------------------------------------------------------------
 // Code handling the Lighting
 // -----------------------------------------------------------------------------
@@ -366,47 +1227,11 @@ static void key_callback(GLFWwindow* window, int key, int scancode, int action,
 }
 
 
-GLuint load_opengl_texture(const std::string& filepath, GLuint slot) {
-	/**
-	 *  - Use the STB Image library to load a texture in here
-	 *  - Initialize the texture into an OpenGL texture
-	 *    - This means creating a texture with glGenTextures or glCreateTextures (4.5)
-	 *    - And transferring the loaded texture data into this texture
-	 *    - And setting the texture format
-	 *  - Finally return the valid texture
-	 */
-
-	 /** Image width, height, bit depth */
-	int w, h, bpp;
-	auto pixels = stbi_load(filepath.c_str(), &w, &h, &bpp, STBI_rgb_alpha);
-
-	/*Generate a texture object and upload the loaded image to it.*/
-	GLuint tex;
-	glGenTextures(1, &tex);
-	glActiveTexture(GL_TEXTURE0 + slot);//Texture Unit
-	glBindTexture(GL_TEXTURE_2D, tex);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
-
-	/** Set parameters for the texture */
-	//Wrapping
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	//Filtering 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	/** Very important to free the memory returned by STBI, otherwise we leak */
-	if (pixels)
-		stbi_image_free(pixels);
-
-	return tex;
-}
-
 // -----------------------------------------------------------------------------
 // Code handling the map size
 // -----------------------------------------------------------------------------
 void setWindowSize(std::string filePath) {
-	std::ifstream in(filePath);
+	AssetStream in(filePath);
 	if (in) {
 		in >> windowWidth; in.ignore(1); in >> windowHeight;	//Read the first string (amount of tiles in X and Y axis)
 	}															//nothing else
@@ -1,23 +1,29 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <algorithm>
+#include <bitset>
 #include <iomanip>
 #include <string>
 #include <set>
 #include <vector>
 
 #include "headers/map.h"
+#include "headers/pack.h"
+#include "headers/parallel.h"
 
 const double	PI = 2.0*acos(0.0);
 
 
 /**
  *	Constructor
+ *	@param headless - Only simulated, never drawn
+ *	@see StaticScene for the walls and pellets on screen
  */
-Map::Map(std::string filePath) {
-	std::ifstream in(filePath);
+Map::Map(std::string filePath, bool headless) {
+	this->headless = headless;
+	AssetStream in(filePath);
 	fromFile(in);
-	initVerts();
+	initExits();
 	initPellets();
 }
 
@@ -25,82 +31,32 @@ Map::Map(std::string filePath) {
  *	Destructor
  */
 Map::~Map() {
-	delete points;
-	delete indices;
 
-	delete p_points;
-	// Rydd opp i vao ebo etc...
-	CleanVAO(vao);
-	CleanVAO(p_vao);
-}
-
-// -----------------------------------------------------------------------------
-// Clean VAO
-// -----------------------------------------------------------------------------
-void Map::CleanVAO(GLuint& vao)
-{
-	GLint nAttr = 0;
-	std::set<GLuint> vbos;
-
-	GLint eboId;
-	glGetVertexArrayiv(vao, GL_ELEMENT_ARRAY_BUFFER_BINDING, &eboId);
-	glDeleteBuffers(1, (GLuint*)&eboId);
-
-	glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &nAttr);
-	glBindVertexArray(vao);
-
-	for (int iAttr = 0; iAttr < nAttr; ++iAttr)
-	{
-		GLint vboId = 0;
-		glGetVertexAttribiv(iAttr, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &vboId);
-		if (vboId > 0)
-		{
-			vbos.insert(vboId);
-		}
-
-		glDisableVertexAttribArray(iAttr);
-	}
-
-	for (auto vbo : vbos)
-	{
-		glDeleteBuffers(1, &vbo);
-	}
-
-	glDeleteVertexArrays(1, &vao);
-}
-
-/*
-*	Draw the Pellets
-*/
-void Map::drawPellets() {
-	glBindVertexArray(p_vao);			// Tell the code which VAO to use 
-	glDrawArrays(GL_POINTS, 0 , p_points->size() / 6);
 }
 
 /**
- *	Draws the map
+ *	Overwrites which pellets are left, from a snapshot
+ *	@param bits	 - One bit per tile, getPelletWords() words
+ *	@param count - Pellets left
  */
-void Map::drawMap() { 
-	glBindVertexArray(vao);				// Tell the code which VAO to use 
-	glDrawElements(GL_TRIANGLES, indices->size(), GL_UNSIGNED_INT, 0);
+void Map::loadPellets(const uint64_t* bits, int count) {
+	std::copy(bits, bits + p_active.size(), p_active.begin());
+	p_count = count;
 }
 
 /**
- *
+ *	Eats the pellet at a tile
  */
 void Map::deletePellet(std::pair<int, int> position) {
-	p_active[position.second][position.first] = false;
+	int tile = position.second * width + position.first;
+	p_active[tile >> 6] &= ~(1ull << (tile & 63));
 	p_count--;
-
-	int range = 6;
-	int index = p_positions[position];
-
 }
 
 /**
  *	Reads datainput from file
  */
-void Map::fromFile(std::ifstream& in) {
+void Map::fromFile(std::istream& in) {
 	if (in) {
 		in >> width; in.ignore(1); in >> height;
 
@@ -108,14 +64,11 @@ void Map::fromFile(std::ifstream& in) {
 
 		for (int y = 0; y < height; y++) {
 			std::vector<int> arr;
-			std::vector<bool> p_activeArr;
 			for (int x = 0; x < width; x++) {
 				in >> temp;
 				if (temp == 2) { startX = x; startY = y; }
-				p_activeArr.push_back(true);
 				arr.push_back(temp);
 			}
-			p_active.push_back(p_activeArr);
 			mapArr.push_back(arr);
 		}
 	}
@@ -123,6 +76,32 @@ void Map::fromFile(std::ifstream& in) {
 		std::cout << "Couldnt find/ read from the file containing the map!" << std::endl;
 }
 
+/**
+ *	Precomputes which neighbours of every tile are open, so sprites moving
+ *	on the grid only have to look at the map when they reach a tile centre
+ *	@see Exit
+ */
+void Map::initExits() {
+	exits.assign(width * height, 0);
+
+	auto open = [&](int x, int y) {
+		return x >= 0 && y >= 0 && x < width && y < height && mapArr[y][x] != 1;
+	};
+
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			if (!open(x, y)) continue;
+
+			unsigned char bits = 0;
+			if (open(x, y - 1)) bits |= EXIT_U;
+			if (open(x, y + 1)) bits |= EXIT_D;
+			if (open(x - 1, y)) bits |= EXIT_L;
+			if (open(x + 1, y)) bits |= EXIT_R;
+			exits[y * width + x] = bits;
+		}
+	}
+}
+
 /**
  *	Gets the screen-coordinates of a given tile
  *	@param tileX - The tile's X (ex. 0->28)
@@ -135,223 +114,110 @@ std::pair<float, float> Map::getScreenCoords(float tileX, float tileY) {
 }
 
 /**
- *	Initializes pellets
+ *	Initializes pellets: one on every open tile (0), none on the walls or
+ *	the start tile, so the bits and p_count always agree.
+ *	StaticScene draws them, the bits say which are left.
  *	(The map needs to be initialized first)
  *	@see Map::fromFile()
- *	@see Map::InitVerts()
  */
 void Map::initPellets() {
-	// Makes Vertex Array Object
+	p_active.assign((width * height + 63) / 64, 0ull);
 
-	glGenVertexArrays(1, &p_vao);
-	glBindVertexArray(p_vao);
-	float levitationHeight = 0.5f;
-
-	// Makes Vertex Buffer Object
-	p_points = new std::vector<float>;
-
-	for (int y = 0; y < height; y++) {
+	p_count = 0;
+	for (int y = 0; y < height; y++)
 		for (int x = 0; x < width; x++) {
 			if (mapArr[y][x] != 0) continue;
-
+			int tile = y * width + x;
+			p_active[tile >> 6] |= 1ull << (tile & 63);
 			p_count++;
-			p_positions.insert(std::pair<std::pair<int, int>, int>({ x, y }, p_points->size()));
-
-			std::pair<float, float> origo = getScreenCoords(x + (tileSize / 2.f), y - (tileSize / 2.f));
-
-			p_points->push_back(origo.first);
-			p_points->push_back(origo.second);
-			p_points->push_back(levitationHeight);
-			p_points->push_back(1.f); p_points->push_back(1.f); p_points->push_back(0.f);
-
 		}
-	}
-
-	glGenBuffers(1, &p_vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, p_vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof_v(*p_points), &(*p_points)[0], GL_STATIC_DRAW);
-
-	// location=0 -> position
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 6, (void*)(sizeof(float) * 0));
-
-	// location=1 -> Color
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 6, (void*)(sizeof(float) * 3));
-
+}
 
+/**
+ *	Which sides of the wall at a tile can be seen, bit n for side n of
+ *	meshWallTile(). A side against another wall never shows, one on the
+ *	edge of the map does.
+ */
+unsigned char Map::wallSides(int x, int y) {
+	auto wall = [&](int nx, int ny) {
+		return nx >= 0 && ny >= 0 && nx < width && ny < height && mapArr[ny][nx] == 1;
+	};
+	return (wall(x, y + 1) ? 0 : 1) | (wall(x, y - 1) ? 0 : 2) | (wall(x - 1, y) ? 0 : 4) | (wall(x + 1, y) ? 0 : 8);
 }
 
 /**
- *	Initializes the walls in the game
+ *	Writes the sides of the wall at a tile that show (see wallSides()), in
+ *	order: 4 vertices of sideFloats / 4 floats each (position, colour,
+ *	texture coordinates) and sideIndices indices per side
+ *	@param base - Index of the first vertex written
+ *	@return Sides written
  */
-void Map::initVerts() {
-	// Makes the Vertex Array Object
-	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
+int Map::meshWallTile(int x, int y, float* vertices, unsigned int* indices, unsigned int base) {
+	// Corner offsets and texture coordinates of every side: dx, dy, top, u, v
+	static const float corners[16][5] = {
+		{ 0, 0, 0, 1, 1 }, { 1, 0, 0, 0, 1 }, { 0, 0, 1, 1, 0 }, { 1, 0, 1, 0, 0 },		// South
+		{ 1, 1, 0, 1, 1 }, { 0, 1, 0, 0, 1 }, { 1, 1, 1, 1, 0 }, { 0, 1, 1, 0, 0 },		// North
+		{ 0, 0, 0, 1, 1 }, { 0, 1, 0, 0, 1 }, { 0, 0, 1, 1, 0 }, { 0, 1, 1, 0, 0 },		// West
+		{ 1, 0, 0, 1, 1 }, { 1, 1, 0, 0, 1 }, { 1, 0, 1, 1, 0 }, { 1, 1, 1, 0, 0 }		// East
+	};
 	float wallHeight = 2.5f;
-	int i = 0;
-	indices = new std::vector<unsigned int>;
+	std::pair<float, float> botLeft = getScreenCoords(x, y);
+	unsigned char sides = wallSides(x, y);
+
+	int written = 0;
+	for (int side = 0; side < 4; side++) {
+		if (!(sides & (1 << side))) continue;
+
+		for (int k = 0; k < 4; k++) {
+			const float* corner = corners[side * 4 + k];
+			float* v = vertices + written * sideFloats + k * 8;
+			v[0] = corner[0] != 0 ? botLeft.first + tileSize : botLeft.first;		//X, Y and Z Coordinates
+			v[1] = corner[1] != 0 ? botLeft.second + tileSize : botLeft.second;
+			v[2] = corner[2] != 0 ? wallHeight : 0.f;
+			v[3] = 0.f; v[4] = 0.f; v[5] = 1.f;										//RGB, walls are blue
+			v[6] = corner[3]; v[7] = corner[4];										//Tex coords
+		}
 
-	// Makes the Vertex Buffer Objecy
-	points = new std::vector<float>;
+		// Two triangles per side
+		unsigned int* i = indices + written * sideIndices;
+		unsigned int  first = base + written * 4;
+		i[0] = first + 0; i[1] = first + 1; i[2] = first + 2;
+		i[3] = first + 1; i[4] = first + 2; i[5] = first + 3;
+		written++;
+	}
+	return written;
+}
 
-	for (int y = 0; y < height; y++) {
+/**
+ *	Builds the wall mesh, one row of tiles per job. Counting the sides that
+ *	show in every row first tells each row where its vertices go, so the
+ *	rows write straight into the buffers and the result doesn't depend on
+ *	the order they finish in.
+ *	@param threads - Jobs to spread the rows over, every core if 0
+ */
+void Map::buildWallMesh(std::vector<float>& vertices, std::vector<unsigned int>& indices, int threads) {
+	ScratchArena&	   scratch = JobSystem::shared().getScratch();
+	ScratchArena::Mark mark	   = scratch.mark();
+	int* rowStart = scratch.allocate<int>(height + 1);		// Sides before each row
+	rowStart[0] = 0;
+
+	parallelFor(height, threadCount(threads), [&](int, int y) {
+		int sides = 0;
+		for (int x = 0; x < width; x++)
+			if (mapArr[y][x] == 1) sides += (int)std::bitset<4>(wallSides(x, y)).count();
+		rowStart[y + 1] = sides;
+	});
+	for (int y = 0; y < height; y++) rowStart[y + 1] += rowStart[y];
+
+	vertices.resize((size_t)rowStart[height] * sideFloats);
+	indices.resize((size_t)rowStart[height] * sideIndices);
+
+	parallelFor(height, threadCount(threads), [&](int, int y) {
+		int side = rowStart[y];
 		for (int x = 0; x < width; x++) {
-			std::pair<float, float> botLeft = getScreenCoords(x, y);
-
-			// Checks if index is a wall
-			float isBlue = 0.f;
-			if (mapArr[y][x] == 1) isBlue = 1.f;		
-
-			// DRAW WALLS IF IT IS A WALL TILE
-			if (isBlue == 1.0f) {
-
-				// South
-				// South FLOOR R
-				points->push_back(botLeft.first); points->push_back(botLeft.second); points->push_back(0.f);	//X, Y and Z Coordinates
-				points->push_back(0.f); points->push_back(0.f); points->push_back(isBlue);						//RGB
-				points->push_back(1.f);	points->push_back(1.f);													//Tex coords
-
-				// South FLOOR L
-				points->push_back(botLeft.first + tileSize); points->push_back(botLeft.second); points->push_back(0.f);
-				points->push_back(0.f); points->push_back(0.f); points->push_back(isBlue);
-				points->push_back(0.f);	points->push_back(1.f);
-
-				// South ROOF R 
-				points->push_back(botLeft.first); points->push_back(botLeft.second); points->push_back(wallHeight);	//X, Y and Z Coordinates
-				points->push_back(0.f); points->push_back(0.f); points->push_back(isBlue);							//RGB
-				points->push_back(1.f);	points->push_back(0.f);														//Tex coords
-
-				// South ROOF L
-				points->push_back(botLeft.first + tileSize); points->push_back(botLeft.second); points->push_back(wallHeight);
-				points->push_back(0.f); points->push_back(0.f); points->push_back(isBlue);
-				points->push_back(0.f);	points->push_back(0.f);
-
-				// South Indices
-				indices->push_back(i + 0);
-				indices->push_back(i + 1);
-				indices->push_back(i + 2);
-
-				indices->push_back(i + 1);
-				indices->push_back(i + 2);
-				indices->push_back(i + 3);
-				i += 4;
-
-				// North
-				// North Left FLOOR
-				points->push_back(botLeft.first + tileSize); points->push_back(botLeft.second + tileSize); points->push_back(0.f);
-				points->push_back(0.f); points->push_back(0.f); points->push_back(isBlue);
-				points->push_back(1.f);	points->push_back(1.f);
-
-				// North Right FLOOR
-				points->push_back(botLeft.first); points->push_back(botLeft.second + tileSize); points->push_back(0.f);
-				points->push_back(0.f); points->push_back(0.f); points->push_back(isBlue);
-				points->push_back(0.f);	points->push_back(1.f);
-
-				// North Left ROOF
-				points->push_back(botLeft.first + tileSize); points->push_back(botLeft.second + tileSize); points->push_back(wallHeight);
-				points->push_back(0.f); points->push_back(0.f); points->push_back(isBlue);
-				points->push_back(1.f);	points->push_back(0.f);
-
-				// North Right ROOF
-				points->push_back(botLeft.first); points->push_back(botLeft.second + tileSize); points->push_back(wallHeight);
-				points->push_back(0.f); points->push_back(0.f); points->push_back(isBlue);
-				points->push_back(0.f);	points->push_back(0.f);
-
-				// North Indices
-				indices->push_back(i + 0);
-				indices->push_back(i + 1);
-				indices->push_back(i + 2);
-
-				indices->push_back(i + 1);
-				indices->push_back(i + 2);
-				indices->push_back(i + 3);
-				i += 4;
-
-				// East
-				// South FLOOR L
-				points->push_back(botLeft.first); points->push_back(botLeft.second); points->push_back(0.f);	//X, Y and Z Coordinates
-				points->push_back(0.f); points->push_back(0.f); points->push_back(isBlue);						//RGB
-				points->push_back(1.f);	points->push_back(1.f);													//Tex coords
-
-				// North Right FLOOR
-				points->push_back(botLeft.first); points->push_back(botLeft.second + tileSize); points->push_back(0.f);
-				points->push_back(0.f); points->push_back(0.f); points->push_back(isBlue);
-				points->push_back(0.f);	points->push_back(1.f);
-
-				// South ROOF L 
-				points->push_back(botLeft.first); points->push_back(botLeft.second); points->push_back(wallHeight);	//X, Y and Z Coordinates
-				points->push_back(0.f); points->push_back(0.f); points->push_back(isBlue);							//RGB
-				points->push_back(1.f);	points->push_back(0.f);														//Tex coords
-
-				// North Right ROOF
-				points->push_back(botLeft.first); points->push_back(botLeft.second + tileSize); points->push_back(wallHeight);
-				points->push_back(0.f); points->push_back(0.f); points->push_back(isBlue);
-				points->push_back(0.f);	points->push_back(0.f);
-
-				// East Indices
-				indices->push_back(i + 0);
-				indices->push_back(i + 1);
-				indices->push_back(i + 2);
-
-				indices->push_back(i + 1);
-				indices->push_back(i + 2);
-				indices->push_back(i + 3);
-				i += 4;
-
-				// West
-				// South FLOOR L
-				points->push_back(botLeft.first + tileSize); points->push_back(botLeft.second); points->push_back(0.f);
-				points->push_back(0.f); points->push_back(0.f); points->push_back(isBlue);
-				points->push_back(1.f);	points->push_back(1.f);
-
-				// North Left FLOOR
-				points->push_back(botLeft.first + tileSize); points->push_back(botLeft.second + tileSize); points->push_back(0.f);
-				points->push_back(0.f); points->push_back(0.f); points->push_back(isBlue);
-				points->push_back(0.f);	points->push_back(1.f);
-
-				// South ROOF L
-				points->push_back(botLeft.first + tileSize); points->push_back(botLeft.second); points->push_back(wallHeight);
-				points->push_back(0.f); points->push_back(0.f); points->push_back(isBlue);
-				points->push_back(1.f);	points->push_back(0.f);
-
-				// North Left ROOF
-				points->push_back(botLeft.first + tileSize); points->push_back(botLeft.second + tileSize); points->push_back(wallHeight);
-				points->push_back(0.f); points->push_back(0.f); points->push_back(isBlue);
-				points->push_back(0.f);	points->push_back(0.f);
-
-				// West Indices
-				indices->push_back(i + 0);
-				indices->push_back(i + 1);
-				indices->push_back(i + 2);
-
-				indices->push_back(i + 1);
-				indices->push_back(i + 2);
-				indices->push_back(i + 3);
-				i += 4;
-			}
+			if (mapArr[y][x] != 1) continue;
+			side += meshWallTile(x, y, &vertices[(size_t)side * sideFloats], &indices[(size_t)side * sideIndices], side * 4);
 		}
-	}
-
-	glGenBuffers(1, &vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof_v(*points), &(*points)[0], GL_STATIC_DRAW);
-
-	// location=0 -> position
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 0) );
-
-	// location=1 -> Color
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 3) );
-
-	// location = 2 -> textures
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 6) );
-
-	// Element buffer object
-	glGenBuffers(1, &ebo); 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof_v(*indices), &(*indices)[0], GL_STATIC_DRAW);
+	});
+	scratch.rewind(mark);
 }
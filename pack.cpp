@@ -0,0 +1,262 @@
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "headers/pack.h"
+
+// Where loose files are looked for when there is no pack, set by CMake
+#ifndef PACMAN_ASSET_DIR
+#define PACMAN_ASSET_DIR ""
+#endif
+
+namespace {
+	const char		packMagic[4]	= { 'P', 'A', 'C', 'K' };
+	const uint32_t	packVersion		= 1;
+
+	struct PackHeader {
+		char		magic[4];
+		uint32_t	version,
+					count,
+					slots;				// Table of contents size, a power of two
+		uint64_t	namesOffset,
+					namesSize;
+	};
+
+	uint64_t alignUp(uint64_t value) {
+		return (value + AssetPack::alignment - 1) / AssetPack::alignment * AssetPack::alignment;
+	}
+}
+
+
+/**
+ *	Constructor
+ */
+AssetPack::AssetPack() {
+
+}
+
+/**
+ *	Destructor
+ */
+AssetPack::~AssetPack() {
+	close();
+}
+
+/**
+ *	The pack the game reads its assets from, see AssetStream
+ */
+AssetPack& AssetPack::mounted() {
+	static AssetPack pack;
+	return pack;
+}
+
+/**
+ *	@return FNV-1a hash of a name, never 0 since that marks empty slots
+ */
+uint64_t AssetPack::hashName(const std::string& name) {
+	uint64_t hash = 14695981039346656037ull;
+	for (unsigned char c : name) {
+		hash ^= c;
+		hash *= 1099511628211ull;
+	}
+	return hash ? hash : 1;
+}
+
+/**
+ *	Where a file that isn't in the pack is read from: the name itself if
+ *	that exists, otherwise the name inside the source tree's asset folder
+ */
+std::string AssetPack::loosePath(const std::string& name) {
+	if (std::ifstream(name)) return name;
+	return std::string(PACMAN_ASSET_DIR) + name;
+}
+
+/**
+ *	Maps a pack into memory
+ *	@return false if it is missing or broken
+ */
+bool AssetPack::open(const std::string& filePath) {
+	close();
+
+#ifdef _WIN32
+	file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) { file = nullptr; return false; }
+
+	LARGE_INTEGER length;
+	GetFileSizeEx(file, &length);
+	size = (size_t)length.QuadPart;
+	if (size >= sizeof(PackHeader)) {
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping) base = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	}
+#else
+	int fd = ::open(filePath.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat info;
+	if (fstat(fd, &info) == 0 && (size_t)info.st_size >= sizeof(PackHeader)) {
+		size = (size_t)info.st_size;
+		void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped != MAP_FAILED) base = (const unsigned char*)mapped;
+	}
+	::close(fd);		// The mapping stays valid without it
+#endif
+
+	if (!base) {
+		std::cout << "Couldnt map the asset pack " << filePath << std::endl;
+		close();
+		return false;
+	}
+
+	const PackHeader* header = (const PackHeader*)base;
+	uint64_t tableEnd = sizeof(PackHeader) + (uint64_t)header->slots * sizeof(Entry);
+	if (std::memcmp(header->magic, packMagic, sizeof(packMagic)) != 0 || header->version != packVersion
+		|| header->slots == 0 || (header->slots & (header->slots - 1)) != 0 || header->count > header->slots
+		|| tableEnd > size || header->namesOffset < tableEnd || header->namesOffset + header->namesSize > size) {
+		std::cout << filePath << " is not an asset pack this version can read" << std::endl;
+		close();
+		return false;
+	}
+
+	table = (const Entry*)(base + sizeof(PackHeader));
+	names = (const char*)(base + header->namesOffset);
+	slots = header->slots;
+	count = (int)header->count;
+	return true;
+}
+
+/**
+ *	Unmaps the pack, every view handed out is invalid afterwards
+ */
+void AssetPack::close() {
+#ifdef _WIN32
+	if (base)	 UnmapViewOfFile(base);
+	if (mapping) CloseHandle(mapping);
+	if (file)	 CloseHandle(file);
+	mapping = file = nullptr;
+#else
+	if (base) munmap((void*)base, size);
+#endif
+	base  = nullptr;
+	table = nullptr;
+	names = nullptr;
+	size  = 0;
+	slots = 0;
+	count = 0;
+}
+
+/**
+ *	@return The file stored under name, an empty view if there is none
+ */
+AssetPack::View AssetPack::find(const std::string& name) {
+	View view;
+	if (!base) return view;
+
+	uint64_t hash = hashName(name);
+	for (uint32_t i = 0; i < slots; i++) {
+		const Entry& entry = table[(hash + i) & (slots - 1)];
+		if (entry.hash == 0) break;
+		if (entry.hash != hash || entry.nameLength != name.size()
+			|| std::memcmp(names + entry.nameOffset, name.data(), name.size()) != 0) continue;
+
+		if (entry.offset + entry.size > size) break;		// Cut short
+		view.data = base + entry.offset;
+		view.size = (size_t)entry.size;
+		break;
+	}
+	return view;
+}
+
+/**
+ *	Writes a pack
+ *	@param names	- Name of every file in the pack
+ *	@param contents - What goes in the pack under each name
+ *	@return true if the pack was written
+ */
+bool AssetPack::build(const std::string& filePath, const std::vector<std::string>& names,
+					  const std::vector<std::vector<char>>& contents) {
+	PackHeader header = {};
+	std::memcpy(header.magic, packMagic, sizeof(packMagic));
+	header.version = packVersion;
+	header.count   = (uint32_t)names.size();
+	header.slots   = 1;
+	while (header.slots < 2 * header.count) header.slots *= 2;		// At most half full
+
+	std::vector<Entry>				 entries(header.slots, Entry());
+	std::vector<uint32_t>			 slotOf;				// Where every file's entry went
+	std::string						 allNames;
+	for (size_t i = 0; i < names.size(); i++) {
+		uint64_t hash = hashName(names[i]);
+		uint32_t slot = (uint32_t)hash & (header.slots - 1);
+		while (entries[slot].hash != 0) {
+			if (entries[slot].hash == hash && allNames.compare(entries[slot].nameOffset, entries[slot].nameLength, names[i]) == 0) {
+				std::cout << names[i] << " is in the pack twice" << std::endl;
+				return false;
+			}
+			slot = (slot + 1) & (header.slots - 1);
+		}
+
+		Entry& entry	 = entries[slot];
+		entry.hash		 = hash;
+		entry.size		 = contents[i].size();
+		entry.nameOffset = (uint32_t)allNames.size();
+		entry.nameLength = (uint32_t)names[i].size();
+		allNames += names[i];
+		slotOf.push_back(slot);
+	}
+
+	header.namesOffset = sizeof(PackHeader) + entries.size() * sizeof(Entry);
+	header.namesSize   = allNames.size();
+
+	// Files follow the names in the order they were given, each one aligned
+	uint64_t offset = alignUp(header.namesOffset + header.namesSize);
+	for (size_t i = 0; i < contents.size(); i++) {
+		entries[slotOf[i]].offset = offset;
+		offset = alignUp(offset + contents[i].size());
+	}
+
+	std::ofstream out(filePath, std::ios::binary);
+	if (!out) {
+		std::cout << "Couldnt write the asset pack " << filePath << std::endl;
+		return false;
+	}
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)entries.data(), entries.size() * sizeof(Entry));
+	out.write(allNames.data(), allNames.size());
+
+	const char padding[alignment] = {};
+	uint64_t   written = header.namesOffset + header.namesSize;
+	for (size_t i = 0; i < contents.size(); i++) {
+		const Entry& entry = entries[slotOf[i]];
+		out.write(padding, entry.offset - written);
+		out.write(contents[i].data(), contents[i].size());
+		written = entry.offset + entry.size;
+	}
+	return (bool)out;
+}
+
+
+/**
+ *	Constructor, fails (like an ifstream) if the asset is nowhere to be found
+ */
+AssetStream::AssetStream(const std::string& name) : std::istream(nullptr) {
+	view = AssetPack::mounted().find(name);
+	if (view) {
+		viewBuffer.set(view);
+		rdbuf(&viewBuffer);
+	}
+	else if (fileBuffer.open(AssetPack::loosePath(name), std::ios::in | std::ios::binary))
+		rdbuf(&fileBuffer);
+	else
+		setstate(std::ios::failbit);
+}
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stb_image.h>
+#include "headers/distances.h"
+#include "headers/pack.h"
+#include "headers/texture.h"
+
+
+namespace {
+	std::vector<std::string>		names;
+	std::vector<std::vector<char>>	contents;
+
+	/**
+	 *	Decodes images and adds their mip chain to the pack, packed into shared layers
+	 */
+	bool addTextures(const std::string& name, const std::string& folder, const std::vector<std::string>& images) {
+		std::vector<MipChain::Image> decoded;
+		for (const std::string& image : images) {
+			int w = 0, h = 0, bpp;
+			unsigned char* pixels = stbi_load((folder + image).c_str(), &w, &h, &bpp, STBI_rgb_alpha);
+			if (!pixels) std::cout << "Couldnt load the texture " << folder + image << std::endl;
+			decoded.push_back({ pixels, w, h, image });
+		}
+
+		MipChain chain;
+		bool built = chain.build(decoded);
+		for (const MipChain::Image& image : decoded)
+			if (image.pixels) stbi_image_free((void*)image.pixels);
+		if (!built) return false;
+
+		names.push_back(name);
+		contents.emplace_back(chain.getFile().begin(), chain.getFile().end());
+		return true;
+	}
+
+	/**
+	 *	Adds a level and bakes its distance table (@see DistanceTable) into
+	 *	the pack as <name>.dist, so the game never bakes one
+	 */
+	bool addLevel(const std::string& name, const std::string& folder) {
+		std::ifstream in(folder + name, std::ios::binary);
+		if (!in) {
+			std::cout << "Couldnt read " << folder + name << std::endl;
+			return false;
+		}
+		std::vector<char> level((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+		// Same layout Map::fromFile() reads: <width>x<height>, then a tile per number
+		std::istringstream text(std::string(level.begin(), level.end()));
+		int width = 0, height = 0;
+		text >> width; text.ignore(1); text >> height;
+		std::vector<std::vector<int>> grid(std::max(height, 0), std::vector<int>(std::max(width, 0)));
+		for (auto& row : grid)
+			for (int& tile : row) text >> tile;
+		if (!text || grid.empty()) {
+			std::cout << "Couldnt read the level " << folder + name << std::endl;
+			return false;
+		}
+
+		DistanceTable table(grid);
+		table.bake();
+		std::ostringstream out;
+		if (!table.save(out)) return false;
+
+		names.push_back(name);
+		contents.push_back(std::move(level));
+		std::string baked = out.str();
+		names.push_back(name + ".dist");
+		contents.emplace_back(baked.begin(), baked.end());
+		return true;
+	}
+}
+
+
+/**
+ *	Bundles the game's assets into one pack (@see AssetPack). PNGs are
+ *	decoded and stored as their full mip chain (@see MipChain): on their
+ *	own under the same name ending in .tex, or as the layers of an array
+ *	texture. Either way the game never decodes an image.
+ *
+ *	Arguments:	<pack>			 - The pack to write
+ *				<folder>		 - What the names are relative to
+ *				<name>..		 - Every file to put in the pack, read from <folder>/<name>
+ *				--array <name>	 - The PNGs after it go into one array texture of that name
+ *				--level <name>	 - A level, packed along with its baked distance table
+ */
+int main(int argc, char** argv) {
+	if (argc < 4) {
+		std::cout << "Usage: " << argv[0] << " <pack> <folder> [--array <name>] [--level <name>] <name>..." << std::endl;
+		return 1;
+	}
+
+	std::string folder = argv[2];
+	if (folder.back() != '/' && folder.back() != '\\') folder += '/';
+
+	std::string				 arrayName;
+	std::vector<std::string> layers;
+	for (int i = 3; i < argc; i++) {
+		std::string name = argv[i];
+		if (name == "--array" && i + 1 < argc) {
+			if (!layers.empty() && !addTextures(arrayName, folder, layers)) return 1;
+			arrayName = argv[++i];
+			layers.clear();
+			continue;
+		}
+		if (name == "--level" && i + 1 < argc) {
+			if (!addLevel(argv[++i], folder)) return 1;
+			continue;
+		}
+
+		if (name.size() > 4 && name.compare(name.size() - 4, 4, ".png") == 0) {
+			if (!arrayName.empty()) layers.push_back(name);
+			else if (!addTextures(MipChain::cacheName(name), folder, { name })) return 1;
+			continue;
+		}
+
+		std::ifstream in(folder + name, std::ios::binary);
+		if (!in) {
+			std::cout << "Couldnt read " << folder + name << std::endl;
+			return 1;
+		}
+		names.push_back(name);
+		contents.emplace_back(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	}
+	if (!layers.empty() && !addTextures(arrayName, folder, layers)) return 1;
+
+	if (!AssetPack::build(argv[1], names, contents)) return 1;
+
+	AssetPack pack;
+	if (!pack.open(argv[1])) return 1;
+	std::cout << "Packed " << pack.getCount() << " files into " << argv[1] << " (" << pack.getSize() << " bytes)" << std::endl;
+	return 0;
+}
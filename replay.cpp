@@ -0,0 +1,224 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include "headers/gamestate.h"
+#include "headers/pack.h"
+#include "headers/replay.h"
+
+namespace {
+	const char		magic[4]	= { 'P', 'R', 'P', 'L' };
+	const uint32_t	version		= 2;						// 2: ghosts use GhostRng
+	const uint32_t	maxPath		= 4096;						// PATH_MAX on Linux, longer level paths are a broken file
+
+	const uint8_t	yawChanged	 = 0x10;						// Flags next to the 4 key bits
+	const uint8_t	pitchChanged = 0x20;
+
+	void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+		while (value >= 0x80) {
+			out.push_back((uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back((uint8_t)value);
+	}
+
+	bool getVarint(const std::vector<uint8_t>& in, size_t& cursor, uint64_t& value) {
+		value = 0;
+		for (int shift = 0; shift < 64 && cursor < in.size(); shift += 7) {
+			uint8_t byte = in[cursor++];
+			value |= (uint64_t)(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) return true;
+		}
+		return false;
+	}
+
+	uint64_t zigzag(int64_t value)		{ return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+	int64_t  unzigzag(uint64_t value)	{ return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); }
+}
+
+
+/**
+ *	@return FNV-1a hash of a level file, 0 if it can't be read
+ */
+uint32_t levelHash(const std::string& filePath) {
+	AssetStream in(filePath);
+	if (!in) return 0;
+
+	uint32_t hash = 2166136261u;
+	for (std::istreambuf_iterator<char> it(in), end; it != end; ++it) {
+		hash ^= (uint8_t)*it;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+
+/**
+ *	Starts a new recording, dropping anything recorded before
+ */
+void ReplayRecorder::begin(const std::string& levelPath, uint32_t seed, uint32_t ghostAmount, uint32_t flags) {
+	header				= ReplayHeader();
+	header.levelPath	= levelPath;
+	header.levelHash	= levelHash(levelPath);
+	header.seed			= seed;
+	header.ghostAmount	= ghostAmount;
+	header.flags		= flags;
+
+	data.clear();
+	last	= written = InputFrame();
+	run		= 0;
+}
+
+/**
+ *	Adds the input of one tick
+ */
+void ReplayRecorder::record(const InputFrame& input) {
+	if (run > 0 && input.keys == last.keys && input.yaw == last.yaw && input.pitch == last.pitch)
+		run++;
+	else {
+		flush();
+		last = input;
+		run	 = 1;
+	}
+	header.ticks++;
+}
+
+/**
+ *	Writes out the current run: length, keys and flags, then the angle deltas
+ */
+void ReplayRecorder::flush() {
+	if (run == 0) return;
+
+	uint8_t bits = last.keys & 0x0F;
+	if (last.yaw   != written.yaw)	 bits |= yawChanged;
+	if (last.pitch != written.pitch) bits |= pitchChanged;
+
+	putVarint(data, run);
+	data.push_back(bits);
+	if (bits & yawChanged)	 putVarint(data, zigzag((int64_t)last.yaw   - written.yaw));
+	if (bits & pitchChanged) putVarint(data, zigzag((int64_t)last.pitch - written.pitch));
+
+	written = last;
+	run		= 0;
+}
+
+/**
+ *	Saves the recording
+ *	@param checksum - Game::checksum() after the last recorded tick
+ */
+bool ReplayRecorder::save(const std::string& filePath, uint64_t checksum) {
+	flush();
+	header.checksum = checksum;
+
+	std::ofstream out(filePath, std::ios::binary);
+	if (!out) {
+		std::cout << "Could not write replay " << filePath << std::endl;
+		return false;
+	}
+
+	uint32_t pathLength = (uint32_t)header.levelPath.size();
+	uint32_t dataSize	= (uint32_t)data.size();
+	out.write(magic, sizeof(magic));
+	out.write((const char*)&version,			sizeof(version));
+	out.write((const char*)&header.seed,		sizeof(header.seed));
+	out.write((const char*)&header.ghostAmount,	sizeof(header.ghostAmount));
+	out.write((const char*)&header.flags,		sizeof(header.flags));
+	out.write((const char*)&header.levelHash,	sizeof(header.levelHash));
+	out.write((const char*)&header.ticks,		sizeof(header.ticks));
+	out.write((const char*)&header.checksum,	sizeof(header.checksum));
+	out.write((const char*)&pathLength,			sizeof(pathLength));
+	out.write(header.levelPath.data(),			pathLength);
+	out.write((const char*)&dataSize,			sizeof(dataSize));
+	out.write((const char*)data.data(),			dataSize);
+	return (bool)out;
+}
+
+
+/**
+ *	Loads a replay, and warns if its level has changed since it was recorded.
+ *	Sizes in the file are checked before anything is allocated for them.
+ */
+bool ReplayPlayer::load(const std::string& filePath) {
+	std::ifstream in(filePath, std::ios::binary | std::ios::ate);
+	if (!in) {
+		std::cout << "Could not open replay " << filePath << std::endl;
+		return false;
+	}
+	std::streamoff fileSize = in.tellg();
+	in.seekg(0);
+
+	char	 fileMagic[4];
+	uint32_t fileVersion = 0, pathLength = 0, dataSize = 0;
+	in.read(fileMagic, sizeof(fileMagic));
+	in.read((char*)&fileVersion, sizeof(fileVersion));
+	if (!in || memcmp(fileMagic, magic, sizeof(magic)) != 0 || fileVersion != version) {
+		std::cout << filePath << " is not a replay this version can play" << std::endl;
+		return false;
+	}
+
+	header = ReplayHeader();
+	in.read((char*)&header.seed,		sizeof(header.seed));
+	in.read((char*)&header.ghostAmount,	sizeof(header.ghostAmount));
+	in.read((char*)&header.flags,		sizeof(header.flags));
+	in.read((char*)&header.levelHash,	sizeof(header.levelHash));
+	in.read((char*)&header.ticks,		sizeof(header.ticks));
+	in.read((char*)&header.checksum,	sizeof(header.checksum));
+	in.read((char*)&pathLength,			sizeof(pathLength));
+	if (!in || header.ghostAmount > GameState::maxGhosts || pathLength > maxPath) {
+		std::cout << "Replay " << filePath << " is broken" << std::endl;
+		return false;
+	}
+	header.levelPath.resize(pathLength);
+	in.read(&header.levelPath[0],		pathLength);
+	in.read((char*)&dataSize,			sizeof(dataSize));
+	if (!in || dataSize > fileSize - in.tellg()) {
+		std::cout << "Replay " << filePath << " is cut short" << std::endl;
+		return false;
+	}
+	data.resize(dataSize);
+	in.read((char*)data.data(),			dataSize);
+	if (!in) {
+		std::cout << "Replay " << filePath << " is cut short" << std::endl;
+		return false;
+	}
+
+	if (levelHash(header.levelPath) != header.levelHash)
+		std::cout << "Warning: " << header.levelPath << " has changed since the replay was recorded" << std::endl;
+
+	cursor	= 0;
+	current = InputFrame();
+	run		= 0;
+	tick	= 0;
+	return true;
+}
+
+/**
+ *	Gets the input of the next tick
+ *	@return false when the replay is over (or broken)
+ */
+bool ReplayPlayer::next(InputFrame& input) {
+	if (tick >= header.ticks) return false;
+
+	if (run == 0) {
+		uint64_t length, delta;
+		if (!getVarint(data, cursor, length) || length == 0 || cursor >= data.size()) return false;
+
+		uint8_t bits  = data[cursor++];
+		current.keys  = bits & 0x0F;
+		if (bits & yawChanged) {
+			if (!getVarint(data, cursor, delta)) return false;
+			current.yaw += (int32_t)unzigzag(delta);
+		}
+		if (bits & pitchChanged) {
+			if (!getVarint(data, cursor, delta)) return false;
+			current.pitch += (int32_t)unzigzag(delta);
+		}
+		run = (uint32_t)length;
+	}
+
+	input = current;
+	run--;
+	tick++;
+	return true;
+}
@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "headers/scene.h"
+
+const double	PI = 2.0*acos(0.0);
+
+
+/**
+ *	Constructor
+ */
+StaticScene::StaticScene() {
+
+}
+
+/**
+ *	Destructor
+ */
+StaticScene::~StaticScene() {
+
+}
+
+/**
+ *	Adds a level's walls and pellets, chunk by chunk
+ *	@param wallImage - Layer of the array texture the walls show
+ *	@param walls	 - false to leave the walls out, when WallMesher meshes them
+ */
+void StaticScene::build(Map& map, const AssetLoader::Layer& wallImage, bool walls) {
+	const auto& mapArr = map.getMapArray();
+	const float levitationHeight = 0.5f;
+
+	std::vector<Vertex>	  meshVertices;
+	std::vector<uint32_t> meshIndices;
+	pelletMesh(meshVertices, meshIndices);
+	int pellet = addMesh(meshVertices, meshIndices);
+
+	const std::vector<Instance> once = { { 0.f, 0.f, 0.f, -1 } };	// Walls are meshed where they stand
+	std::vector<Instance> pellets;
+
+	for (int y0 = 0; y0 < map.getHeight(); y0 += chunkTiles) {
+		for (int x0 = 0; x0 < map.getWidth(); x0 += chunkTiles) {
+			int x1 = std::min(x0 + chunkTiles, map.getWidth()),
+				y1 = std::min(y0 + chunkTiles, map.getHeight());
+
+			meshVertices.clear();
+			meshIndices.clear();
+			if (walls) appendWalls(map, x0, y0, x1, y1, wallImage, meshVertices, meshIndices);
+			if (!meshVertices.empty()) addDraw(addMesh(meshVertices, meshIndices), once);
+
+			pellets.clear();
+			for (int y = y0; y < y1; y++)
+				for (int x = x0; x < x1; x++) {
+					if (mapArr[y][x] != 0) continue;
+					std::pair<float, float> origo = map.getScreenCoords(x + (map.getTileSize() / 2.f), y - (map.getTileSize() / 2.f));
+					pellets.push_back({ origo.first, origo.second, levitationHeight, y * map.getWidth() + x });
+				}
+			if (!pellets.empty()) addDraw(pellet, pellets);
+		}
+	}
+}
+
+/**
+ *	Meshes the walls of the tiles from (x0, y0) up to (x1, y1), not
+ *	including x1 and y1, with the map's own mesher
+ *	@see Map::meshWallTile()
+ */
+void StaticScene::appendWalls(Map& map, int x0, int y0, int x1, int y1, const AssetLoader::Layer& image,
+							  std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+	const auto& mapArr = map.getMapArray();
+	float		wall[Map::wallFloats];
+	unsigned int wallIndices[Map::wallIndices];
+
+	for (int y = y0; y < y1; y++)
+		for (int x = x0; x < x1; x++) {
+			if (mapArr[y][x] != 1) continue;
+
+			int sides = map.meshWallTile(x, y, wall, wallIndices, (unsigned int)vertices.size());
+			for (int c = 0; c < sides * 4; c++) {
+				const float* v = wall + c * 8;
+				vertices.push_back({ v[0], v[1], v[2], v[3], v[4], v[5], v[6] * image.scaleU + image.offsetU,
+									 v[7] * image.scaleV + image.offsetV, image.layer });
+			}
+			indices.insert(indices.end(), wallIndices, wallIndices + sides * Map::sideIndices);
+		}
+}
+
+/**
+ *	Makes the pellet, a small yellow sphere around the origin
+ */
+void StaticScene::pelletMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+	const int	stacks = 8, sectors = 8;
+	const float radius = 0.05f;
+
+	for (int i = 0; i <= stacks; i++) {
+		float stackAngle = (float)(PI / 2 - i * PI / stacks);		// From pi/2 down to -pi/2
+		for (int j = 0; j <= sectors; j++) {
+			float sectorAngle = (float)(j * 2 * PI / sectors);
+			vertices.push_back({ radius * std::cos(stackAngle) * std::cos(sectorAngle),
+								 radius * std::cos(stackAngle) * std::sin(sectorAngle),
+								 radius * std::sin(stackAngle),
+								 1.f, 1.f, 0.f, 0.f, 0.f, -1 });
+		}
+	}
+
+	// Two triangles between every pair of neighbouring stacks and sectors
+	for (int i = 0; i < stacks; i++)
+		for (int j = 0; j < sectors; j++) {
+			uint32_t v0 = i * (sectors + 1) + j, v1 = v0 + 1,
+					 v3 = v0 + sectors + 1,		 v2 = v3 + 1;
+			for (uint32_t index : { v0, v1, v2, v0, v2, v3 }) indices.push_back(index);
+		}
+}
+
+/**
+ *	Adds a mesh, for addDraw() to place
+ *	@param indices - Counted from the mesh's own first vertex
+ *	@return The mesh's number
+ */
+int StaticScene::addMesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
+	Mesh mesh = { (GLuint)this->indices.size(), (GLuint)indices.size(), (GLint)this->vertices.size(),
+				  { FLT_MAX, FLT_MAX, FLT_MAX, 0.f }, { -FLT_MAX, -FLT_MAX, -FLT_MAX, 0.f } };
+	for (const Vertex& v : vertices) {
+		const float position[3] = { v.x, v.y, v.z };
+		for (int c = 0; c < 3; c++) {
+			mesh.min[c] = std::min(mesh.min[c], position[c]);
+			mesh.max[c] = std::max(mesh.max[c], position[c]);
+		}
+	}
+	meshes.push_back(mesh);
+
+	this->vertices.insert(this->vertices.end(), vertices.begin(), vertices.end());
+	this->indices.insert(this->indices.end(), indices.begin(), indices.end());
+	return (int)meshes.size() - 1;
+}
+
+/**
+ *	Adds a draw of a mesh: one copy at every instance, culled one by one
+ */
+void StaticScene::addDraw(int mesh, const std::vector<Instance>& instances) {
+	commands.push_back({ meshes[mesh].count, 0, meshes[mesh].firstIndex, meshes[mesh].baseVertex, (GLuint)this->instances.size() });
+	drawMeshes.push_back(mesh);
+	this->instances.insert(this->instances.end(), instances.begin(), instances.end());
+	this->instanceDraws.insert(this->instanceDraws.end(), instances.size(), (uint32_t)commands.size() - 1);
+}
+
+/**
+ *	Sends everything to the GPU, on the GL thread. Only the mesh table stays
+ *	in memory, the GPU culls and draws on its own from here.
+ *	@param shader	  - Program with the scene shaders
+ *	@param cullShader - Compute program with the scene culling shader
+ */
+bool StaticScene::upload(GLuint shader, GLuint cullShader) {
+	this->shader	 = shader;
+	this->cullShader = cullShader;
+	drawCount	  = (int)commands.size();
+	instanceCount = (int)instances.size();
+
+	// Every draw's box, in the order of the commands
+	std::vector<float> bounds;
+	for (int mesh : drawMeshes) {
+		bounds.insert(bounds.end(), meshes[mesh].min, meshes[mesh].min + 4);
+		bounds.insert(bounds.end(), meshes[mesh].max, meshes[mesh].max + 4);
+	}
+
+	// What the culling shader reads, and the commands and instances it writes
+	auto storage = [](GLuint& buffer, GLenum target, size_t bytes, const void* data, GLenum usage) {
+		glGenBuffers(1, &buffer);
+		glBindBuffer(target, buffer);
+		glBufferData(target, std::max<size_t>(bytes, 4), data, usage);
+		glBindBuffer(target, 0);
+	};
+	storage(ibo,		   GL_SHADER_STORAGE_BUFFER, instances.size() * sizeof(Instance),	 instances.data(),	   GL_STATIC_DRAW);
+	storage(dbo,		   GL_SHADER_STORAGE_BUFFER, instanceDraws.size() * sizeof(uint32_t), instanceDraws.data(), GL_STATIC_DRAW);
+	storage(bbo,		   GL_SHADER_STORAGE_BUFFER, bounds.size() * sizeof(float),			 bounds.data(),		   GL_STATIC_DRAW);
+	storage(resetBuffer,   GL_COPY_READ_BUFFER,		 commands.size() * sizeof(DrawCommand),	 commands.data(),	   GL_STATIC_DRAW);
+	storage(commandBuffer, GL_DRAW_INDIRECT_BUFFER,	 commands.size() * sizeof(DrawCommand),	 nullptr,			   GL_DYNAMIC_COPY);
+	storage(visibleBuffer, GL_ARRAY_BUFFER,			 instances.size() * sizeof(Instance),	 nullptr,			   GL_DYNAMIC_COPY);
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+
+	// location=0 -> position
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, x));
+
+	// location=1 -> Color
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, r));
+
+	// location=2 -> Texture coordinates, location=3 -> layer
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, u));
+	glEnableVertexAttribArray(3);
+	glVertexAttribIPointer(3, 1, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, layer));
+
+	// location=4 -> Offset, once per visible instance (a command's baseInstance picks its first)
+	glBindBuffer(GL_ARRAY_BUFFER, visibleBuffer);
+	glEnableVertexAttribArray(4);
+	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, x));
+	glVertexAttribDivisor(4, 1);
+
+	glGenBuffers(1, &ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+	glBindVertexArray(0);
+
+	if (!vbo || !ebo || !ibo || !dbo || !bbo || !resetBuffer || !commandBuffer || !visibleBuffer) {
+		std::cout << "Couldnt make the buffers of the level" << std::endl;
+		return false;
+	}
+
+	std::vector<Vertex>().swap(vertices);
+	std::vector<uint32_t>().swap(indices);
+	std::vector<Instance>().swap(instances);
+	std::vector<uint32_t>().swap(instanceDraws);
+	std::vector<DrawCommand>().swap(commands);
+	std::vector<int>().swap(drawMeshes);
+	return true;
+}
+
+/**
+ *	Deletes the buffers, while the context is still there
+ */
+void StaticScene::release() {
+	for (GLuint* buffer : { &vbo, &ebo, &ibo, &dbo, &bbo, &resetBuffer, &commandBuffer, &visibleBuffer }) {
+		if (*buffer) glDeleteBuffers(1, buffer);
+		*buffer = 0;
+	}
+	if (vao) glDeleteVertexArrays(1, &vao);
+	vao = 0;
+}
+
+/**
+ *	Culls every instance against the camera's frustum on the GPU, then
+ *	draws what is left with one call. Bind the pellet mask first.
+ */
+void StaticScene::draw(const Frustum& frustum, const glm::mat4& projection, const glm::mat4& view) {
+	if (!vao || drawCount == 0) return;
+
+	// Every command starts with no instances, the shader counts the visible ones in
+	GLsizeiptr commandBytes = drawCount * sizeof(DrawCommand);
+	glBindBuffer(GL_COPY_READ_BUFFER, resetBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, commandBuffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, commandBytes);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	glUseProgram(cullShader);
+	frustum.apply(cullShader);
+	glUniform1ui(glGetUniformLocation(cullShader, "u_Instances"), (GLuint)instanceCount);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, bbo);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, ibo);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, dbo);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, visibleBuffer);
+	glDispatchCompute((instanceCount + 63) / 64, 1, 1);
+
+	// The draw reads the commands and the instances the shader wrote
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+	glBindVertexArray(vao);
+	glUseProgram(shader);
+	glUniformMatrix4fv(glGetUniformLocation(shader, "u_ProjectionMat"), 1, false, glm::value_ptr(projection));
+	glUniformMatrix4fv(glGetUniformLocation(shader, "u_ViewMat"), 1, false, glm::value_ptr(view));
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, drawCount, sizeof(DrawCommand));
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
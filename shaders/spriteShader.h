@@ -6,23 +6,22 @@
 static const std::string spriteVertexShaderSrc = R"(
 #version 430 core
 
-layout (location = 0) in vec2 aPos;
-layout (location = 1) in vec3 aColor;
-layout (location = 2) in vec2 inTexCoords;
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec4 aColor;
+layout (location = 2) in vec2 inTexCoords;				// Already scaled to the image's part of the layer
+layout (location = 3) in int  aLayer;					// Image in the array texture
 
 /**Matixer trengt til kamera og transformasjoner*/
-uniform mat4 u_TransformationMat = mat4(1);
 uniform mat4 u_ViewMat           = mat4(1);
 uniform mat4 u_ProjectionMat     = mat4(1);
 
 out vec4 vColor;
-out vec2 TexCoords;
+out vec3 TexCoords;
 
 void main() {
-	/**Posisjon basert p transforamtions of kamera*/
-	gl_Position = u_ProjectionMat * u_ViewMat * u_TransformationMat * vec4(aPos, 0.0f, 1.0f);
-	vColor		= vec4(aColor, 1.0f);
-	TexCoords	= inTexCoords;
+	gl_Position = u_ProjectionMat * u_ViewMat * vec4(aPos, 1.0f);
+	vColor		= aColor;
+	TexCoords	= vec3(inTexCoords, aLayer);
 }
 )";
 
@@ -43,195 +42,381 @@ static const std::string spriteFragmentShaderSrc = R"(
 #version 430 core
 
 in vec4		vColor;
-in vec2		TexCoords;
+in vec3		TexCoords;
 out vec4	FragColor;
 
-uniform		sampler2D image;
+uniform		sampler2DArray image;
 
 void main() {
 		
-		vec4 colorTest = texture(image, TexCoords);
+		vec4 colorTest = texture(image, TexCoords) * vColor;
 		if(colorTest.a < 0.1) discard;
 		else{FragColor = colorTest;}
 		
 	}
 	)";
 
-static const std::string mapVertexShaderSrc = R"(
+static const std::string sceneVertexShaderSrc = R"(
 #version 430 core
 
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
-layout (location = 2) in vec2 inTexCoords;
+layout (location = 2) in vec2 inTexCoords;				// Scaled to the image's part of the layer, or by u_TexScale
+layout (location = 3) in int  aLayer;					// Image in the array texture, -1 for the colour only
+layout (location = 4) in vec3 aOffset;					// Per visible instance, where this copy of the mesh goes
 
 /**Matixer trengt til kamera og transformasjoner*/
-uniform mat4 u_TransformationMat = mat4(1);
 uniform mat4 u_ViewMat           = mat4(1);
 uniform mat4 u_ProjectionMat     = mat4(1);
+uniform vec2 u_TexScale          = vec2(1);				// For vertices that aren't scaled, like WallMesher's
+uniform vec2 u_TexOffset         = vec2(0);
 
 out vec4 vColor;
 out vec2 TexCoords;
+flat out int vLayer;
 
 void main() {
-	/**Posisjon basert p transformations av kamera*/
-	gl_Position = u_ProjectionMat * u_ViewMat * u_TransformationMat * vec4(aPos, 1.0f);
+	gl_Position = u_ProjectionMat * u_ViewMat * vec4(aPos + aOffset, 1.0f);
 	vColor		= vec4(aColor, 1.0f);
-	TexCoords	= inTexCoords;
-	
-}
-)";
-
-static const std::string mapGeometryShaderSrc = R"(
-#version 430 core
-
-layout (points) in;
-layout (points, max_verticies = 1) out;
-
-void main(){
-	gl_Position = gl_in[0].gl_Position;
-	EmitVertex();
-	EndPrimitive();
+	TexCoords	= inTexCoords * u_TexScale + u_TexOffset;
+	vLayer		= aLayer;
 }
 )";
 
-static const std::string mapFragmentShaderSrc = R"(
+static const std::string sceneFragmentShaderSrc = R"(
 #version 430 core
 
 in vec4		vColor;
 in vec2		TexCoords;
+flat in int	vLayer;
 
 out vec4	FragColor;
 
-uniform		sampler2D image;
+uniform		sampler2DArray image;
 
-void main() {		
-		vec4 ColorTest = texture(image, TexCoords);
-		FragColor = ColorTest;
-		
+void main() {
+		FragColor = vLayer < 0 ? vColor : texture(image, vec3(TexCoords, vLayer));
 }
 )";
 
-static const std::string pelletVertexShaderSrc = R"(
+static const std::string wallMeshComputeShaderSrc = R"(
 #version 430 core
 
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aColor;
-
-/**Matixer trengt til kamera og transformasjoner*/
-uniform mat4 u_TransformationMat = mat4(1);
-uniform mat4 u_ViewMat           = mat4(1);
-uniform mat4 u_ProjectionMat     = mat4(1);
+layout (local_size_x = 256) in;							// One tile, or one value being scanned, per invocation
+
+struct DrawCommand {
+	uint count, instanceCount, firstIndex;
+	int  baseVertex;
+	uint baseInstance;
+};
+
+layout (std430, binding = 2) readonly buffer Tiles {
+	int tiles[];										// Row major, 1 is a wall
+};
+
+layout (std430, binding = 3) buffer Scan {
+	uint scan[];										// Sides of every tile, then a sum per 256 of them, per 256 of those...
+};
+
+layout (std430, binding = 4) writeonly buffer Vertices {
+	float vertices[];									// 8 floats each, as Map::meshWallTile() writes them
+};
+
+layout (std430, binding = 5) writeonly buffer Indices {
+	uint indices[];
+};
+
+layout (std430, binding = 6) buffer Command {
+	DrawCommand command;								// The last tile fills in the index count
+};
+
+uniform int   u_Pass;									// 0 counts sides, 1 scans a level, 2 adds the level above back, 3 meshes
+uniform uint  u_Level;									// Where the level being scanned or added to starts in scan[]
+uniform uint  u_Next;									// Where the level above it starts, one value per 256
+uniform uint  u_Length;									// Values in the level
+uniform int   u_Width;
+uniform int   u_Height;
+uniform vec2  u_Start;									// Screen coordinates of the bottom left tile
+uniform float u_TileSize;
+
+/**Corners of the 4 sides (dx, dy, top) and their texture coordinates*/
+const vec3 corners[16] = vec3[16](
+	vec3(0, 0, 0), vec3(1, 0, 0), vec3(0, 0, 1), vec3(1, 0, 1),		// South
+	vec3(1, 1, 0), vec3(0, 1, 0), vec3(1, 1, 1), vec3(0, 1, 1),		// North
+	vec3(0, 0, 0), vec3(0, 1, 0), vec3(0, 0, 1), vec3(0, 1, 1),		// West
+	vec3(1, 0, 0), vec3(1, 1, 0), vec3(1, 0, 1), vec3(1, 1, 1)		// East
+);
+const vec2 texCoords[4] = vec2[4](vec2(1, 1), vec2(0, 1), vec2(1, 0), vec2(0, 0));
+const float wallHeight = 2.5;
+
+shared uint partial[256];
+
+bool wall(int x, int y) {
+	return x >= 0 && y >= 0 && x < u_Width && y < u_Height && tiles[y * u_Width + x] == 1;
+}
 
-out vec4 vColor;
-out mat4 vTransformation;
+/**Sides of a wall that show, bit n for side n, like Map::wallSides()*/
+uint wallSides(int x, int y) {
+	return (wall(x, y + 1) ? 0u : 1u) | (wall(x, y - 1) ? 0u : 2u) | (wall(x - 1, y) ? 0u : 4u) | (wall(x + 1, y) ? 0u : 8u);
+}
 
 void main() {
-	/**Posisjon basert p transformations av kamera*/
-	gl_Position = vec4(aPos, 1.0f);
-	vColor		= vec4(aColor, 1.0f);
-	
-	vTransformation = u_ProjectionMat * u_ViewMat * u_TransformationMat;
+	uint block = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;		// Big levels dispatch in 2D
+	uint local = gl_LocalInvocationID.x;
+	uint i	   = block * 256u + local;
+
+	if (u_Pass == 1) {
+		// Scans 256 values in shared memory, leaves them exclusive and hands the total up a level
+		uint value = i < u_Length ? scan[u_Level + i] : 0u;
+		partial[local] = value;
+		barrier();
+		for (uint stride = 1u; stride < 256u; stride <<= 1) {
+			uint add = local >= stride ? partial[local - stride] : 0u;
+			barrier();
+			partial[local] += add;
+			barrier();
+		}
+		if (i < u_Length) scan[u_Level + i] = partial[local] - value;
+		if (local == 255u) scan[u_Next + block] = partial[255];
+		return;
+	}
+
+	if (u_Pass == 2) {
+		// Everything before this value's block of 256
+		if (i < u_Length) scan[u_Level + i] += scan[u_Next + i / 256u];
+		return;
+	}
+
+	uint tileCount = uint(u_Width * u_Height);
+	if (i >= tileCount) return;
+	int  x	  = int(i % uint(u_Width)), y = int(i / uint(u_Width));
+	uint show = tiles[i] == 1 ? wallSides(x, y) : 0u;
+	if (u_Pass == 0) {
+		scan[i] = uint(bitCount(show));
+		return;
+	}
+
+	// Sides before this tile, so every side lands where Map::buildWallMesh() puts it
+	uint side = scan[i];
+	if (i == tileCount - 1u) command.count = (side + uint(bitCount(show))) * 6u;
+	if (show == 0u) return;
+
+	// The same additions as Map::getScreenCoords(), for the same floats
+	precise float left	 = u_Start.x + float(x);
+	precise float bottom = u_Start.y + (float(u_Height - 1) - float(y));
+	precise float right	 = left + u_TileSize;
+	precise float top	 = bottom + u_TileSize;
+
+	for (int s = 0; s < 4; s++) {
+		if ((show & (1u << s)) == 0u) continue;
+
+		for (int k = 0; k < 4; k++) {
+			vec3 corner = corners[s * 4 + k];
+			uint v = (side * 4u + uint(k)) * 8u;
+			vertices[v + 0u] = corner.x != 0.0 ? right : left;
+			vertices[v + 1u] = corner.y != 0.0 ? top : bottom;
+			vertices[v + 2u] = corner.z != 0.0 ? wallHeight : 0.0;
+			vertices[v + 3u] = 0.0; vertices[v + 4u] = 0.0; vertices[v + 5u] = 1.0;		// Walls are blue
+			vertices[v + 6u] = texCoords[k].x;
+			vertices[v + 7u] = texCoords[k].y;
+		}
+
+		// Two triangles per side
+		uint n = side * 6u, first = side * 4u;
+		indices[n + 0u] = first + 0u; indices[n + 1u] = first + 1u; indices[n + 2u] = first + 2u;
+		indices[n + 3u] = first + 1u; indices[n + 4u] = first + 2u; indices[n + 5u] = first + 3u;
+		side++;
+	}
 }
 )";
 
-static const std::string pelletGeometryShaderSrc = R"(
+static const std::string sceneCullComputeShaderSrc = R"(
 #version 430 core
 
-layout (points) in;
-layout (triangle_strip, max_vertices=384) out;
+layout (local_size_x = 64) in;
 
-in vec4 vColor[];
-in mat4 vTransformation[];
+struct DrawCommand {
+	uint count, instanceCount, firstIndex;
+	int  baseVertex;
+	uint baseInstance;
+};
 
-out vec3 gNormals;
-out vec4 gColor;
+struct Instance {
+	float x, y, z;
+	int	  tile;											// Pellet's row major tile, -1 if always drawn
+};
 
-void main(){
-	gColor = vColor[0];
-	mat4 gTransform = vTransformation[0];
+/**Pellets left, one bit per tile, streamed every frame*/
+layout (std430, binding = 1) readonly buffer PelletMask {
+	uint pelletBits[];
+};
 
-	float PI = 3.14159265358979323846264;  
+layout (std430, binding = 2) buffer Commands {
+	DrawCommand commands[];								// Instance counts start at 0, visible ones are counted in
+};
 
-    vec4 pos = gl_in[0].gl_Position;  //introduce a single vertex at the origin
+layout (std430, binding = 3) readonly buffer Bounds {
+	vec4 bounds[];										// Min and max corner of every draw's mesh
+};
 
-	float x, y, z, xy; 
-	float radius = 0.05f;
-	float nx, ny, nz, lengthInv = 1.0f / radius;   
+layout (std430, binding = 4) readonly buffer Instances {
+	Instance instances[];
+};
 
-	int sectorCount = 8;
-	int stackCount = 8;
+layout (std430, binding = 5) readonly buffer InstanceDraws {
+	uint instanceDraws[];
+};
 
-	float sectorStep = 2 * PI / sectorCount;
-	float stackStep = PI / stackCount;
-	float sectorAngle, stackAngle;
+layout (std430, binding = 6) writeonly buffer Visible {
+	Instance visible[];
+};
 
-	vec3 spherePos[8][8];
-	vec3 sphereNormals[8][8];
+uniform vec4 u_Planes[6];								// Of the camera's frustum, normalised
+uniform uint u_Instances;
 
-	for(int i = 0; i < stackCount; ++i)
-	{
-		stackAngle = PI / 2 - i * stackStep;        // starting from pi/2 to -pi/2
-		xy = radius * cos(stackAngle);             // r * cos(u)
-		z = radius * sin(stackAngle);              // r * sin(u)
+void main() {
+	uint i = gl_GlobalInvocationID.x;
+	if (i >= u_Instances) return;
+
+	Instance instance = instances[i];
+	int		 tile	  = instance.tile;
+	if (tile >= 0 && tile >> 5 < pelletBits.length() && (pelletBits[tile >> 5] & (1u << (tile & 31))) == 0u) return;
+
+	/**The mesh's box where the instance puts it, out if its furthest corner along a plane's normal is behind it*/
+	uint draw	= instanceDraws[i];
+	vec3 offset = vec3(instance.x, instance.y, instance.z);
+	vec3 lo		= bounds[draw * 2].xyz + offset,
+		 hi		= bounds[draw * 2 + 1].xyz + offset;
+	for (int p = 0; p < 6; p++) {
+		vec3 corner = mix(lo, hi, greaterThan(u_Planes[p].xyz, vec3(0.0)));
+		if (dot(u_Planes[p].xyz, corner) + u_Planes[p].w < 0.0) return;
+	}
 
-		// add (sectorCount+1) vertices per stack
-		// the first and last vertices have same position and normal, but different tex coords
-		for(int j = 0; j <= sectorCount; ++j)
-		{
-			sectorAngle = j * sectorStep;           // starting from 0 to 2pi
+	uint slot = atomicAdd(commands[draw].instanceCount, 1u);
+	visible[commands[draw].baseInstance + slot] = instance;
+}
+)";
 
-			// vertex position (x, y, z)
-			x = xy * cos(sectorAngle);             // r * cos(u) * cos(v)
-			y = xy * sin(sectorAngle);             // r * cos(u) * sin(v)
-			spherePos[j][i] = vec3(x, y, z);
+static const std::string instanceCullComputeShaderSrc = R"(
+#version 430 core
 
-			// normalized vertex normal (nx, ny, nz)
-			nx = x * lengthInv;
-			ny = y * lengthInv;
-			nz = z * lengthInv;
-			sphereNormals[j][i] = vec3(nx, ny, nz);
-		}
-	}
-	for(int i = 0; i < stackCount; i++){
-		for(int j = 0; j <= sectorCount; j++){
-			vec3 v0 = spherePos[j][i], 
-				 v1 = spherePos[j+1][i], 
-				 v2 = spherePos[j+1][i+1], 
-				 v3 = spherePos[j][i+1];
-
-			gl_Position = gTransform * vec4(v0.x+pos.x, v0.y+pos.y, v0.z+pos.z, pos.w);
-			EmitVertex();
-			gl_Position = gTransform * vec4(v1.x+pos.x, v1.y+pos.y, v1.z+pos.z, pos.w);
-			EmitVertex();
-			gl_Position = gTransform * vec4(v2.x+pos.x, v2.y+pos.y, v2.z+pos.z, pos.w);
-			EmitVertex();
-
-			gl_Position = gTransform * vec4(v0.x+pos.x, v0.y+pos.y, v0.z+pos.z, pos.w);
-			EmitVertex();
-			gl_Position = gTransform * vec4(v2.x+pos.x, v2.y+pos.y, v2.z+pos.z, pos.w);
-			EmitVertex();
-			gl_Position = gTransform * vec4(v3.x+pos.x, v3.y+pos.y, v3.z+pos.z, pos.w);
-			EmitVertex();
-		
-			
-		}
-	} 
+layout (local_size_x = 64) in;
 
-	EndPrimitive();
+layout (std430, binding = 2) readonly buffer Transforms {
+	mat4 transforms[];
+};
+
+layout (std430, binding = 3) writeonly buffer Visible {
+	mat4 visible[];
+};
+
+layout (std430, binding = 4) buffer Command {
+	uint count, instanceCount, first, baseInstance;		// Instance count starts at 0, visible ones are counted in
+};
+
+uniform vec4  u_Planes[6];								// Of the camera's frustum, normalised
+uniform uint  u_Count;
+uniform float u_Radius;									// Around the model's origin
+
+void main() {
+	uint i = gl_GlobalInvocationID.x;
+	if (i >= u_Count) return;
+
+	vec3 centre = transforms[i][3].xyz;
+	for (int p = 0; p < 6; p++)
+		if (dot(u_Planes[p].xyz, centre) + u_Planes[p].w < -u_Radius) return;
+
+	visible[atomicAdd(instanceCount, 1u)] = transforms[i];
 }
 )";
 
-static const std::string pelletFragmentShaderSrc = R"(
+static const std::string swarmComputeShaderSrc = R"(
 #version 430 core
 
-in vec4		gColor;
-in vec3		gNormals;
+layout (local_size_x = 64) in;
+
+struct Ghost {
+	int	 tileX, tileY;
+	int	 progress;										// Past the tile's centre in 1/4096 tiles, towards exit
+	uint exit;											// Exit bit it walks through, 0 standing at the centre
+	uint rng;											// xorshift32 state
+};
+
+layout (std430, binding = 2) buffer Ghosts {
+	Ghost ghosts[];
+};
+
+layout (std430, binding = 3) writeonly buffer Transforms {
+	mat4 transforms[];
+};
+
+uniform usampler2D u_Exits;								// Exit bits of every tile
+uniform uint u_Count;
+uniform int	 u_Ticks;
+uniform int	 u_Speed;									// 1/4096 tiles per tick
+uniform vec2 u_Origin;									// Where the centre of tile (0, 0) is drawn
+
+const int  fixedOne = 4096;
+const uint EXIT_U = 1u, EXIT_D = 2u, EXIT_L = 4u, EXIT_R = 8u;
+
+uint nextRandom(inout uint state) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+/**Straight on through corridors and corners, a random way at junctions, back only out of dead ends*/
+uint pickExit(ivec2 tile, uint exit, inout uint rng) {
+	uint exits = texelFetch(u_Exits, tile, 0).r;
+	uint back  = exit == EXIT_U ? EXIT_D : exit == EXIT_D ? EXIT_U : exit == EXIT_L ? EXIT_R : exit == EXIT_R ? EXIT_L : 0u;
+	if ((exits & ~back) != 0u) exits &= ~back;
+	if (exits == 0u || (exits & (exits - 1u)) == 0u) return exits;
+
+	uint options[4];
+	uint count = 0u;
+	for (uint bit = EXIT_U; bit <= EXIT_R; bit <<= 1)
+		if ((exits & bit) != 0u) options[count++] = bit;
+	return options[nextRandom(rng) % count];
+}
 
-out vec4	FragColor;
+/**A tile's step towards an exit, rows counting down the screen*/
+ivec2 towards(uint exit) {
+	return exit == EXIT_U ? ivec2(0, -1) : exit == EXIT_D ? ivec2(0, 1) : exit == EXIT_L ? ivec2(-1, 0) : exit == EXIT_R ? ivec2(1, 0) : ivec2(0);
+}
 
 void main() {
-	
-		FragColor = gColor;	
+	uint i = gl_GlobalInvocationID.x;
+	if (i >= u_Count) return;
+
+	Ghost ghost = ghosts[i];
+	ivec2 tile	= ivec2(ghost.tileX, ghost.tileY);
+	for (int t = 0; t < u_Ticks; t++) {
+		if (ghost.exit == 0u) {
+			ghost.exit = pickExit(tile, 0u, ghost.rng);
+			if (ghost.exit == 0u) continue;
+		}
+
+		ghost.progress += u_Speed;
+		while (ghost.progress >= fixedOne) {
+			tile		  += towards(ghost.exit);
+			ghost.progress -= fixedOne;
+			ghost.exit	   = pickExit(tile, ghost.exit, ghost.rng);
+			if (ghost.exit == 0u) { ghost.progress = 0; break; }
+		}
+	}
+	ghost.tileX = tile.x;
+	ghost.tileY = tile.y;
+	ghosts[i]	= ghost;
+
+	/**Turned to face its exit, like Ghosts::transformation(): up is not turned at all*/
+	ivec2 step	  = towards(ghost.exit);
+	vec2  heading = ghost.exit == 0u ? vec2(0.0, 1.0) : vec2(step.x, -step.y);
+	vec2  centre  = u_Origin + vec2(tile.x, -tile.y) + heading * (float(ghost.progress) / float(fixedOne));
+	transforms[i] = mat4(vec4(heading.y, -heading.x, 0.0, 0.0),
+						 vec4(heading, 0.0, 0.0),
+						 vec4(0.0, 0.0, 1.0, 0.0),
+						 vec4(centre, 0.0, 1.0));
 }
 )";
 
@@ -243,25 +428,32 @@ layout (location = 1) in vec3 aNormals;
 layout (location = 2) in vec2 inTexCoords;
 
 /**Matixer trengt til kamera og transformasjoner*/
-uniform mat4 u_TransformationMat = mat4(1);
 uniform mat4 u_ViewMat           = mat4(1);
 uniform mat4 u_ProjectionMat     = mat4(1);
 uniform mat4 u_LightSpaceMat     = mat4(1);
 
+/**One transformation per visible instance (ghost), written by the culling shader*/
+layout (std430, binding = 0) readonly buffer GhostTransforms {
+	mat4 transforms[];
+};
+
 out vec4 vPos;
+out vec4 vWorldPos;
 out vec3 vnormals;
 out vec4 LightSpacePos;
 out vec2 TexCoords;
 
 void main() {
-	vPos = vec4(aPos, 1.0);
+	mat4 transformation = transforms[gl_InstanceID];
+	vPos	  = vec4(aPos, 1.0);
+	vWorldPos = transformation * vPos;
 
-	LightSpacePos = u_LightSpaceMat *  u_TransformationMat * vPos;
+	LightSpacePos = u_LightSpaceMat * vWorldPos;
 
-	mat3 normalmatrix = transpose(inverse(mat3(u_ViewMat * u_TransformationMat)));
+	mat3 normalmatrix = transpose(inverse(mat3(u_ViewMat * transformation)));
 	vnormals = normalize(normalmatrix * normalize(aNormals));
 
-	gl_Position = u_ProjectionMat * u_ViewMat * u_TransformationMat * vPos;
+	gl_Position = u_ProjectionMat * u_ViewMat * vWorldPos;
 	TexCoords	= inTexCoords;
 }
 )";
@@ -271,17 +463,20 @@ static const std::string modelFragmentShaderSrc = R"(
 #version 430 core
 
 in vec4 vPos;
+in vec4 vWorldPos;
 in vec3 vnormals;
 in vec4 LightSpacePos;
 in vec2	TexCoords;
 
-uniform mat4 u_TransformationMat = mat4(1);
 uniform mat4 u_ViewMat = mat4(1);
 
 uniform vec3  u_LightColor;
 uniform vec3  u_LightDirection;
 uniform float u_Specularity;
-uniform		sampler2D image;
+uniform		sampler2DArray image;
+uniform int	 u_Layer		   = 0;			// Which image of the array texture
+uniform vec2 u_LayerScale  = vec2(1);		// How much of the layer it covers
+uniform vec2 u_LayerOffset = vec2(0);		// And where it starts
 
 out vec4	FragColor;
 
@@ -296,7 +491,7 @@ vec3 DirectionalLight(
     vec3 dir_to_light = normalize(-direction);                                         
     vec3 diffuse = color * max(0.0, dot(vnormals, dir_to_light));                         
     
-    vec3 viewDirection = normalize(vec3(inverse(u_ViewMat) * vec4(0,0,0,1) - u_TransformationMat *  vPos));
+    vec3 viewDirection = normalize(vec3(inverse(u_ViewMat) * vec4(0,0,0,1) - vWorldPos));
     
     vec3 reflectionDirection = reflect(dir_to_light, vnormals);             
     
@@ -310,7 +505,7 @@ void main() {
 		
 		vec3 light = DirectionalLight(u_LightColor,u_LightDirection);
 
-		vec4 colorTest = texture(image, TexCoords);
+		vec4 colorTest = texture(image, vec3(clamp(TexCoords, 0.0, 1.0) * u_LayerScale + u_LayerOffset, u_Layer));
 		if(colorTest.a < 0.1) discard;
 		else{FragColor = colorTest * vec4(light, 1.0);}
 		
@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "headers/simthread.h"
+#include "headers/game.h"
+
+/**
+ *	@return How many ticks to run now, never more than maxCatchUp
+ */
+int TickClock::advance(double now) {
+	int ticks = now < next ? 0 : (int)((now - next) / step) + 1;
+	if (ticks > maxCatchUp) {
+		dropped += ticks - maxCatchUp;
+		next	+= (ticks - maxCatchUp) * step;
+		ticks	 = maxCatchUp;
+	}
+	return ticks;
+}
+
+/**
+ *	Counts off one tick
+ *	@return When it was due
+ */
+double TickClock::tick() {
+	double due = next;
+	next += step;
+	return due;
+}
+
+
+/**
+ *	Constructor
+ *	@param game - The game to run, nothing else may touch it between start() and stop()
+ *	@param tick - Called once per tick on the simulation thread with the newest controls
+ */
+SimThread::SimThread(Game& game, TickFunction tick) : game(game), tickFunction(tick), clock(Game::step) {
+	epoch = std::chrono::steady_clock::now();
+}
+
+/**
+ *	Destructor
+ */
+SimThread::~SimThread() {
+	stop();
+}
+
+/**
+ *	Publishes the game as it is and starts ticking it
+ *	@param threaded - Tick on a thread of our own, or in advance() if false
+ */
+void SimThread::start(bool threaded) {
+	if (running) return;
+
+	// Sized once for the level, whatever its size and ghost amount
+	RenderFrame sized;
+	sized.pelletBits.resize(game.getMap().getPelletWords());
+	sized.ghostX.resize(game.getGhosts().size());
+	sized.ghostY.resize(game.getGhosts().size());
+	sized.ghostDir.resize(game.getGhosts().size());
+	frames.fill(sized);
+	previous = current = sized;
+
+	capture(frames.back(), now());
+	frames.publish();
+	poll();
+	previous = current;
+	clock.reset(now());
+
+	this->threaded = threaded;
+	running		   = true;
+	if (threaded) thread = std::thread(&SimThread::run, this);
+}
+
+/**
+ *	Stops ticking after the current tick, the game can be used again afterwards
+ */
+void SimThread::stop() {
+	running = false;
+	if (thread.joinable()) thread.join();
+}
+
+/**
+ *	Unthreaded: runs the ticks that are due, and takes every frame in turn
+ *	so the last two are always one tick apart
+ */
+void SimThread::advance() {
+	if (threaded || !running) return;
+
+	for (int ticks = clock.advance(now()); ticks > 0; ticks--) {
+		runTick();
+		poll();
+	}
+}
+
+/**
+ *	Seconds since the SimThread was made, the clock RenderFrame::time uses
+ */
+double SimThread::now() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+/**
+ *	Render thread: the input the next tick should use
+ */
+void SimThread::setControls(const SimControls& controls) {
+	this->controls.back() = controls;
+	this->controls.publish();
+}
+
+/**
+ *	Render thread: picks up the newest frame, if there is one
+ *	@return true if a new frame came in
+ */
+bool SimThread::poll() {
+	if (!frames.update()) return false;
+	previous = current;
+	current	 = frames.front();
+	return true;
+}
+
+/**
+ *	Render thread: the last two frames blended by how far we are into the
+ *	next tick. Drawing runs one tick behind the simulation, which is what
+ *	keeps motion smooth when frames and ticks don't line up. Anything that
+ *	jumps more than a tile (rewinding, respawning) is not blended.
+ *	@param frame - Written over, keep it between calls so it isn't sized again
+ */
+void SimThread::interpolate(RenderFrame& frame) {
+	float alpha = (float)std::min(1.0, std::max(0.0, (now() - current.time) / Game::step));
+	auto blend	= [alpha](float from, float to) {
+		return std::fabs(to - from) > 1.f ? to : from + (to - from) * alpha;
+	};
+
+	frame		= current;
+	frame.pacX	= blend(previous.pacX, current.pacX);
+	frame.pacY	= blend(previous.pacY, current.pacY);
+	frame.yaw	= previous.yaw + (current.yaw - previous.yaw) * alpha;
+	frame.pitch = previous.pitch + (current.pitch - previous.pitch) * alpha;
+	frame.animationTime = previous.animationTime + (current.animationTime - previous.animationTime) * alpha;
+	for (int i = 0; i < std::min(previous.ghostCount, current.ghostCount); i++) {
+		frame.ghostX[i] = blend(previous.ghostX[i], current.ghostX[i]);
+		frame.ghostY[i] = blend(previous.ghostY[i], current.ghostY[i]);
+	}
+}
+
+/**
+ *	The simulation thread. Runs the ticks that are due and sleeps until the next one.
+ */
+void SimThread::run() {
+	while (running.load(std::memory_order_relaxed)) {
+		for (int ticks = clock.advance(now()); ticks > 0; ticks--) runTick();
+		std::this_thread::sleep_until(epoch + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+											  std::chrono::duration<double>(clock.getNext())));
+	}
+}
+
+/**
+ *	One tick with the newest controls, published as a frame
+ */
+void SimThread::runTick() {
+	double due = clock.tick();
+	controls.update();
+	tickFunction(controls.front());
+
+	capture(frames.back(), due);
+	frames.publish();
+}
+
+/**
+ *	Copies what the renderer needs out of the game
+ *	@param time - When the tick was due, on the now() clock
+ */
+void SimThread::capture(RenderFrame& frame, double time) {
+	Pacman&				  pacman = game.getPacman();
+	std::vector<Ghosts*>& ghosts = game.getGhosts();
+	if (!game.isDone()) animationTime += Game::step;
+
+	frame.time		 = time;
+	frame.tick		 = game.getTick();
+	frame.dropped	 = clock.getDropped();
+	frame.done		 = game.isDone();
+	frame.pacX		 = pacman.getPacPos().first;
+	frame.pacY		 = pacman.getPacPos().second;
+	frame.yaw		 = pacman.getYaw();
+	frame.pitch		 = pacman.getPitch();
+	frame.pacDir	 = pacman.getDirection();
+	frame.animationTime = animationTime;
+	frame.pellets	 = game.getMap().getp_count();
+	frame.pelletTotal = game.getPelletTotal();
+	frame.pelletWords = game.getMap().getPelletWords();
+	frame.pelletBits.resize(frame.pelletWords);		// Already the right size unless the level changed
+	std::memcpy(frame.pelletBits.data(), game.getMap().getPelletBits(), frame.pelletWords * sizeof(uint64_t));
+
+	frame.ghostCount = (int32_t)ghosts.size();
+	frame.ghostX.resize(ghosts.size());
+	frame.ghostY.resize(ghosts.size());
+	frame.ghostDir.resize(ghosts.size());
+	for (int i = 0; i < frame.ghostCount; i++) {
+		frame.ghostX[i]	  = ghosts[i]->getGhostPos(0).first;
+		frame.ghostY[i]	  = ghosts[i]->getGhostPos(0).second;
+		frame.ghostDir[i] = ghosts[i]->getGhostDir(0);
+	}
+}
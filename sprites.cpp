@@ -1,5 +1,3 @@
-#define TINYOBJLOADER_IMPLEMENTATION //This needs to be defined exactly once so that tinyOBJ will work
-
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <string>
@@ -7,10 +5,12 @@
 #include <iomanip>
 #include <random>
 #include <math.h>
+#include <cfloat>
 
-#include "tinyobjloader/tiny_obj_loader.h"
 #include "headers/map.h"
 #include "headers/sprites.h"
+#include "headers/cooperative.h"
+#include "headers/distances.h"
 #include "glm/glm/gtc/type_ptr.hpp"
 
 
@@ -35,7 +35,7 @@ Sprites::~Sprites() {
  * Checks if game is done by either collecting all pellets or dying to ghost(s)
  */
 bool Sprites::checkIfGameIsDone(bool ghostCollision) {
-	if (Sprites::getMap()->getp_count() < 0 || ghostCollision) {
+	if (Sprites::getMap()->getp_count() <= 0 || ghostCollision) {
 		speed = 0;
 		return true;
 	}
@@ -43,11 +43,48 @@ bool Sprites::checkIfGameIsDone(bool ghostCollision) {
 		return false;
 }
 
+/**
+ *	How far the sprite walks in one tick, in fixed point
+ */
+fixed_t Sprites::fixedStep() {
+	return (fixed_t)std::lround(speed * fixedOne / GhostModes::ticksPerSecond);
+}
+
+/**
+ *	coordsToTile() for fixed point positions
+ */
+std::pair<int, int> Sprites::fixedToTile(fixed_t x, fixed_t y) {
+	return { fixedFloor(x), map->getHeight() - 1 - fixedCeil(y) };
+}
+
+/**
+ *	checkWallCollision() for fixed point positions, with integer math only
+ */
+bool Sprites::fixedWallCollision(fixed_t posX, fixed_t posY) {
+	const std::vector<std::vector<int>>& mapArr = map->getMapArray();
+
+	fixed_t radius = fixedOne / 2,
+			inner  = fixedOne * 2 / 5;		// Slightly less than the radius, so corners can be taken
+	std::pair<int, int> nextTile1, nextTile2;
+
+	switch (direction) {
+	case 'U': nextTile1 = fixedToTile(posX + inner, posY + radius); nextTile2 = fixedToTile(posX - inner, posY + radius); break;
+	case 'D': nextTile1 = fixedToTile(posX + inner, posY - radius); nextTile2 = fixedToTile(posX - inner, posY - radius); break;
+	case 'L': nextTile1 = fixedToTile(posX - radius, posY + inner); nextTile2 = fixedToTile(posX - radius, posY - inner); break;
+	case 'R': nextTile1 = fixedToTile(posX + radius, posY + inner); nextTile2 = fixedToTile(posX + radius, posY - inner); break;
+	default:  nextTile1 = nextTile2 = fixedToTile(posX, posY);												break;
+	}
+
+	if (mapArr[nextTile1.second][nextTile1.first] == 1 || mapArr[nextTile2.second][nextTile2.first] == 1)
+		return true;
+	return posX < radius || posX > map->getWidth() * fixedOne - radius - fixedOne / 10;
+}
+
 /**
  *	Checks collision with walls
  */
 bool Sprites::checkWallCollision(float posX, float posY) {
-    std::vector<std::vector<int>> mapArr = Sprites::getMap()->getMapArray();
+    const std::vector<std::vector<int>>& mapArr = Sprites::getMap()->getMapArray();
 
     float spriteRadius = Sprites::getMap()->getTileSize() / 2.f;
     std::pair<int, int> nextTile1;
@@ -98,25 +135,16 @@ std::pair<int, int> Sprites::coordsToTile(float x, float y) {
 }
 
 /**
- *	Moves everything in the shader with offsetX and offsetY
+ *	@return Matrix that moves a model by offsetX and offsetY, turned by radians
  */
-void Sprites::moveAllToShader(float offsetX, float offsetY , const float& radians, GLuint shaderprogram) {
-	glUseProgram(shaderprogram);
-
-	// Gets the variable in the shader which 'transforms' stuff (moves, scales, etc)
-	GLuint projmat = glGetUniformLocation(shaderprogram, "u_TransformationMat");
-
-
+glm::mat4 Sprites::transformation(float offsetX, float offsetY, float radians) {
 	//Translation moves our object.        base matrix      Vector for movement along each axis
 	glm::mat4 translate = glm::translate(glm::mat4(1), glm::vec3(offsetX, offsetY, 0.f));
 
 	//Rotate the object            base matrix      degrees to rotate   axis to rotate around
 	glm::mat4 rotate = glm::rotate(glm::mat4(1), radians, { (0.f),(0.f),(1.f) });
 
-	glm::mat4 transformation = translate * rotate;
-
-	// Updates transform-variable with our translation
-	glUniformMatrix4fv(projmat, 1, false, glm::value_ptr(transformation));
+	return translate * rotate;
 }
 
 
@@ -125,8 +153,8 @@ void Sprites::moveAllToShader(float offsetX, float offsetY , const float& radian
 /**
  *	Constructor
  */
-Ghosts::Ghosts(Map* map, GLuint shader) : Sprites(map) {
-	this->ghost_Shader = shader;
+Ghosts::Ghosts(Map* map) : Sprites(map) {
+
 }
 
 /**
@@ -134,8 +162,6 @@ Ghosts::Ghosts(Map* map, GLuint shader) : Sprites(map) {
  */
 Ghosts::~Ghosts() {
 	delete ghost_points;
-
-	Sprites::getMap()->CleanVAO(potVAO);
 }
 
 /**
@@ -146,166 +172,354 @@ bool Ghosts::checkIfGameIsDone(bool ghostCollision) {
 }
 
 /**
- *	Draws the sprites
+ *	Draws the model, once per transformation in the shader storage buffer
+ *	bound at binding 0, as many times as the culling pass counted into
+ *	the indirect command
+ *	@see InstanceCulling
  */
-void Ghosts::drawGhosts() {
+void Ghosts::drawGhosts(GLuint command) {
+	if (potVAO == 0) return;	// Model not loaded yet
 	glBindVertexArray(potVAO);	// Tell the code which VAO to use
-	glDrawArrays(GL_TRIANGLES, 6, getSize());
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command);
+	glDrawArraysIndirect(GL_TRIANGLES, nullptr);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
 }
 
-// -----------------------------------------------------------------------------
-// Code handling the camera
-// -----------------------------------------------------------------------------
-GLuint Ghosts::LoadModel(const std::string path)
-{
+/**
+ *	Initialises ghosts with all its values.
+ *	The model is loaded by the AssetLoader and handed over with setModel().
+ */
+GLuint Ghosts::initGhost(time_t seed) {
+	sprite_positions.resize(1);
+	sprite_velX.resize(1);
+	sprite_velY.resize(1);
+	sprite_dir.resize(1);
+	sprite_toCentre.resize(1);
+	fixed_positions.resize(1);
+	fixed_velX.resize(1);
+	fixed_velY.resize(1);
+	fixed_toCentre.resize(1);
+	spawn(seed);
 
-	//We create a vector of Vertex structs. OpenGL can understand these, and so will accept them as input.
-	std::vector<Vertex> vertices;
+	return potVAO;
+}
 
-	//Some variables that we are going to use to store data from tinyObj
-	tinyobj::attrib_t attrib;
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials; //This one goes unused for now, seeing as we don't need materials for this model.
+/**
+ *	Puts the ghost on a random open tile, standing still
+ *	@param seed - Decides the tile and the ghost's random choices after it
+ */
+void Ghosts::spawn(uint64_t seed) {
+	// Set random positions for the ghosts
+	const std::vector<std::vector<int>>& checkArray = Sprites::getMap()->getMapArray();
+	rng.seed(seed);
+	int ghostSpawnX, ghostSpawnY;
+	do { // Gets random positions for the ghosts
+		ghostSpawnX = rng() % Sprites::getMap()->getWidth();
+		ghostSpawnY = rng() % Sprites::getMap()->getHeight();
+	} while (checkArray[ghostSpawnY][ghostSpawnX] != 0);
 
-	//Some variables incase there is something wrong with our obj file
-	std::string warn;
-	std::string err;
+	sprite_positions[0] = getMap()->getScreenCoords(ghostSpawnX + 0.5f, ghostSpawnY - 0.5f);
 
-	//We use tinobj to load our models. Feel free to find other .obj files and see if you can load them.
-	tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, (path + "/monster.obj").c_str(), path.c_str());
+	sprite_velX[0]		= 0.f;
+	sprite_velY[0]		= 0.f;
+	sprite_dir[0]		= ' ';
+	sprite_toCentre[0]	= 0.f;		// Standing on a centre, decides on the first update
+	setFixedPoint(Sprites::isFixedPoint());
+}
 
-	if (!warn.empty()) {
-		std::cout << warn << std::endl;
+/**
+ *	Switches between float and fixed point movement, carrying the
+ *	ghost's position, velocity and progress over
+ */
+void Ghosts::setFixedPoint(bool fixedPoint) {
+	Sprites::setFixedPoint(fixedPoint);
+	for (int i = 0; i < sprite_positions.size(); i++) {
+		fixed_positions[i] = { toFixed(sprite_positions[i].first), toFixed(sprite_positions[i].second) };
+		fixed_velX[i]	   = (fixed_t)std::lround(sprite_velX[i] * fixedOne / GhostModes::ticksPerSecond);
+		fixed_velY[i]	   = (fixed_t)std::lround(sprite_velY[i] * fixedOne / GhostModes::ticksPerSecond);
+		fixed_toCentre[i]  = sprite_toCentre[i] == FLT_MAX ? INT32_MAX : toFixed(sprite_toCentre[i]);
 	}
+}
 
-	if (!err.empty()) {
-		std::cerr << err << std::endl;
-	}
+/**
+ *	Gives the ghost a personality. Without one it wanders randomly.
+ *	@param modes   - Scatter / chase schedule shared by all ghosts
+ *	@param targets - Pacman's whereabouts, kept up to date by the game
+ */
+void Ghosts::setBrain(Personality personality, DistanceTable* distances, GhostModes* modes, const GhostTargets* targets) {
+	this->personality = personality;
+	this->distances	  = distances;
+	this->modes		  = modes;
+	this->targets	  = targets;
+	if (modes) seenReversals = modes->getReversals();
+}
+
+/**
+ *	Moves the ghosts one fixed step. A ghost only looks at the map when it
+ *	reaches a tile centre, in between it just keeps walking the way it is going.
+ *	In fixed point every call is one tick, whatever dt is.
+ */
+void Ghosts::movement(double dt, bool gameStatus) {
+	if (checkIfGameIsDone(gameStatus)) return;
+
+	float step	   = Sprites::getSpeed() * dt;
+	float tileSize = getMap()->getTileSize();
+
+	// Every mode change turns the ghosts around, like in the arcade
+	bool reverse = modes && modes->getReversals() != seenReversals;
+	if (reverse) seenReversals = modes->getReversals();
+
+	for (int i = 0; i < sprite_positions.size(); i++) {
+		if (reverse && sprite_dir[i] != ' ') {
+			switch (sprite_dir[i]) {
+			case 'U': sprite_dir[i] = 'D'; break;
+			case 'D': sprite_dir[i] = 'U'; break;
+			case 'L': sprite_dir[i] = 'R'; break;
+			case 'R': sprite_dir[i] = 'L'; break;
+			}
+			sprite_velX[i]	   = -sprite_velX[i];
+			sprite_velY[i]	   = -sprite_velY[i];
+			sprite_toCentre[i] = tileSize - sprite_toCentre[i];
+			fixed_velX[i]	   = -fixed_velX[i];
+			fixed_velY[i]	   = -fixed_velY[i];
+			fixed_toCentre[i]  = fixedOne - fixed_toCentre[i];
+		}
 
-	//For each shape defined in the obj file
-	for (auto shape : shapes)
-	{
-		//We find each mesh
-		for (auto meshIndex : shape.mesh.indices)
-		{
-			//And store the data for each vertice, including normals
-			glm::vec3 vertice = {
-				attrib.vertices[(meshIndex.vertex_index * 3) + 2],
-				attrib.vertices[meshIndex.vertex_index * 3],
-				attrib.vertices[(meshIndex.vertex_index * 3) + 1]
-			};
-			glm::vec3 normal = {
-				attrib.normals[(meshIndex.normal_index * 3) + 2],
-				attrib.normals[meshIndex.normal_index * 3],
-				attrib.normals[(meshIndex.normal_index * 3) + 1]
-			};
-			glm::vec2 textureCoordinate = {                         //These go unnused, but if you want textures, you will need them.
-				attrib.texcoords[meshIndex.texcoord_index * 2],
-				attrib.texcoords[(meshIndex.texcoord_index * 2) + 1]
-			};
-
-			vertices.push_back({ vertice, normal, textureCoordinate }); //We add our new vertice struct to our vector
+		if (Sprites::isFixedPoint()) {
+			fixed_positions[i].first  += fixed_velX[i];
+			fixed_positions[i].second += fixed_velY[i];
+			fixed_toCentre[i] -= fixedStep();
 
+			while (fixed_toCentre[i] <= 0) reachCentreFixed(i);
+			sprite_positions[i] = { fixedToFloat(fixed_positions[i].first), fixedToFloat(fixed_positions[i].second) };
+			continue;
 		}
+
+		sprite_positions[i].first  += sprite_velX[i] * dt;
+		sprite_positions[i].second += sprite_velY[i] * dt;
+		sprite_toCentre[i] -= step;
+
+		while (sprite_toCentre[i] <= 0.f) reachCentre(i);
 	}
+}
 
-	GLuint VAO;
-	glGenVertexArrays(1, &VAO);
-	glBindVertexArray(VAO);
+/**
+ *	@return Where a ghost at a given position and heading is drawn, for
+ *			drawing from a snapshot while the simulation runs elsewhere
+ */
+glm::mat4 Ghosts::transformation(float x, float y, char dir) {
+	float rotation = 0.0f;
+	switch (dir) {
+	case 'D': rotation = 180.0f; break;
+	case 'R': rotation = 270.0f; break;
+	case 'L': rotation = 90.0f;  break;
+	}
+	return Sprites::transformation(x, y, glm::radians(rotation));
+}
 
-	GLuint VBO;
-	glGenBuffers(1, &VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+/**
+ *	Picks one of several exits at a junction.
+ *	Ghosts with a personality take the exit whose tile is closest to their
+ *	target (ties go up, left, down, right like in the arcade). Distances come
+ *	from the baked table, so this is a handful of lookups. Wanderers pick
+ *	at random.
+ */
+unsigned char Ghosts::chooseExit(std::pair<int, int> tile, unsigned char exits) {
+	bool targeting = distances && distances->isBaked() && modes && targets
+				  && personality != WANDERER;
+
+	if (!targeting) {
+		int count = 0;
+		unsigned char options[4];
+		for (unsigned char bit = EXIT_U; bit <= EXIT_R; bit <<= 1)
+			if (exits & bit) options[count++] = bit;
+		return options[rng() % count];
+	}
 
-	//As you can see, OpenGL will accept a vector of structs as a valid input here
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertices.size(), &vertices[0], GL_STATIC_DRAW);
+	std::pair<int, int> target = ghostTarget(personality, modes->getMode(), *targets, tile,
+											 getMap()->getWidth(), getMap()->getHeight(), distances);
+	target = distances->snap(target.first, target.second);
 
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, nullptr);
+	const unsigned char order[4] = { EXIT_U, EXIT_L, EXIT_D, EXIT_R };
+	const int			stepX[4] = { 0, -1, 0, 1 };
+	const int			stepY[4] = { -1, 0, 1, 0 };
 
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 3));
+	unsigned char best = 0;
+	int bestDist = 0;
+	for (int k = 0; k < 4; k++) {
+		if (!(exits & order[k])) continue;
+		int d = distances->estimate(tile.first + stepX[k], tile.second + stepY[k], target.first, target.second);
+		if (best == 0 || d < bestDist) { best = order[k]; bestDist = d; }
+	}
+	return best;
+}
 
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 8, (void*)(sizeof(float) * 6));
+/**
+ *	Called when ghost i has walked onto (or past) a tile centre.
+ *	Corridors and corners have one way on and need no decision, at junctions
+ *	the ghost picks an exit that does not turn it around. A dead end is the
+ *	only place it reverses.
+ */
+void Ghosts::reachCentre(int i) {
+	float overshoot = -sprite_toCentre[i];
+	float speed		= Sprites::getSpeed();
+
+	// Back up to the centre we passed and snap to it, so errors never add up
+	float dirX = speed > 0.f ? sprite_velX[i] / speed : 0.f;
+	float dirY = speed > 0.f ? sprite_velY[i] / speed : 0.f;
+	std::pair<int, int> tile = coordsToTile(sprite_positions[i].first - dirX * overshoot,
+											sprite_positions[i].second - dirY * overshoot - 1.f);
+	sprite_positions[i] = getMap()->getScreenCoords(tile.first + 0.5f, tile.second - 0.5f);
+
+	unsigned char chosen = pickExit(tile, sprite_dir[i]);
+	if (chosen == 0) {			// Walled in, never move again
+		sprite_velX[i] = sprite_velY[i] = 0.f;
+		sprite_toCentre[i] = FLT_MAX;
+		return;
+	}
 
-	//This will be needed later to specify how much we need to draw. Look at the main loop to find this variable again.
-	setSize(vertices.size());
+	switch (chosen) {
+	case EXIT_U: sprite_dir[i] = 'U'; sprite_velX[i] = 0.f;	   sprite_velY[i] = speed;	break;
+	case EXIT_D: sprite_dir[i] = 'D'; sprite_velX[i] = 0.f;	   sprite_velY[i] = -speed; break;
+	case EXIT_L: sprite_dir[i] = 'L'; sprite_velX[i] = -speed; sprite_velY[i] = 0.f;	break;
+	case EXIT_R: sprite_dir[i] = 'R'; sprite_velX[i] = speed;  sprite_velY[i] = 0.f;	break;
+	}
 
-	return VAO;
+	// Carry on past the centre with whatever distance was left over
+	float tileSize = getMap()->getTileSize();
+	if (overshoot > tileSize) overshoot = tileSize;
+	sprite_positions[i].first  += sprite_velX[i] / speed * overshoot;
+	sprite_positions[i].second += sprite_velY[i] / speed * overshoot;
+	sprite_toCentre[i] = tileSize - overshoot;
 }
 
 /**
- *	Initialises ghosts with all its values
+ *	reachCentre() in fixed point
  */
-GLuint Ghosts::initGhost(time_t seed) {
-
-	potVAO = LoadModel("../../../../assets/model");
+void Ghosts::reachCentreFixed(int i) {
+	fixed_t overshoot = -fixed_toCentre[i];
+	fixed_t step	  = fixedStep();
+
+	// Back up to the centre we passed and snap to it
+	int dirX = (fixed_velX[i] > 0) - (fixed_velX[i] < 0);
+	int dirY = (fixed_velY[i] > 0) - (fixed_velY[i] < 0);
+	std::pair<int, int> tile = fixedToTile(fixed_positions[i].first - dirX * overshoot,
+										   fixed_positions[i].second - dirY * overshoot - fixedOne);
+	fixed_positions[i] = { tile.first * fixedOne + fixedOne / 2,
+						   (getMap()->getHeight() - 1 - tile.second) * fixedOne + fixedOne / 2 };
+
+	unsigned char chosen = pickExit(tile, sprite_dir[i]);
+	if (chosen == 0) {
+		fixed_velX[i] = fixed_velY[i] = 0;
+		fixed_toCentre[i] = INT32_MAX;
+		return;
+	}
 
-	// Set random positions for the ghosts
-	std::vector<std::vector<int>> checkArray = Sprites::getMap()->getMapArray();
-	srand(seed);
-	int ghostSpawnX, ghostSpawnY;
-	do { // Gets random positions for the ghosts
-		ghostSpawnX = rand() % Sprites::getMap()->getWidth();
-		ghostSpawnY = rand() % Sprites::getMap()->getHeight();
-	} while (checkArray[ghostSpawnY][ghostSpawnX] != 0);
+	switch (chosen) {
+	case EXIT_U: sprite_dir[i] = 'U'; fixed_velX[i] = 0;	 fixed_velY[i] = step;	break;
+	case EXIT_D: sprite_dir[i] = 'D'; fixed_velX[i] = 0;	 fixed_velY[i] = -step; break;
+	case EXIT_L: sprite_dir[i] = 'L'; fixed_velX[i] = -step; fixed_velY[i] = 0;		break;
+	case EXIT_R: sprite_dir[i] = 'R'; fixed_velX[i] = step;	 fixed_velY[i] = 0;		break;
+	}
 
-	sprite_positions.push_back(getMap()->getScreenCoords(ghostSpawnX + 0.5f, ghostSpawnY - 0.5f));
+	if (overshoot > fixedOne) overshoot = fixedOne;
+	fixed_positions[i].first  += ((fixed_velX[i] > 0) - (fixed_velX[i] < 0)) * overshoot;
+	fixed_positions[i].second += ((fixed_velY[i] > 0) - (fixed_velY[i] < 0)) * overshoot;
+	fixed_toCentre[i] = fixedOne - overshoot;
+}
 
-	sprite_velX.push_back(0.f);
-	sprite_velY.push_back(0.f);
+/**
+ *	Which way a ghost goes on from a tile centre. Corridors and corners have
+ *	one way on, junctions are left to chooseExit().
+ *	@return The exit bit, 0 if the ghost is walled in
+ */
+unsigned char Ghosts::pickExit(std::pair<int, int> tile, char dir) {
+	unsigned char exits = getMap()->getExits(tile.first, tile.second);
+	unsigned char back	= 0;
+	switch (dir) {
+	case 'U': back = EXIT_D; break;
+	case 'D': back = EXIT_U; break;
+	case 'L': back = EXIT_R; break;
+	case 'R': back = EXIT_L; break;
+	}
+	if (exits & ~back) exits &= ~back;
+	if (exits == 0) return 0;
 
-	glBindVertexArray(potVAO);
-	glDrawArrays(GL_TRIANGLES, 6, getSize());
-	return potVAO;
+	// Only junctions need a decision
+	return (exits & (exits - 1)) == 0 ? exits : chooseExit(tile, exits);
 }
 
 /**
- *	Initializes movement of a sprite
+ *	The tile the ghost stands on
  */
-void Ghosts::movement(GLFWwindow* window, double dt, bool gameStatus, time_t seed) {
-	float rotation = 0.0f;
-	if (!checkIfGameIsDone(gameStatus)) {
-		srand(seed);
+std::pair<int, int> Ghosts::getTile() {
+	return coordsToTile(sprite_positions[0].first, sprite_positions[0].second - 1.f);
+}
 
-		for (int i = 0; i < sprite_positions.size(); i++) {
-			int random = rand() % 4;
-			switch (random) {
-			case 0:
-				Sprites::setDirection('U');
-				sprite_velX.at(i) = 0;
-				sprite_velY.at(i) = Sprites::getSpeed();
-				rotation = 0.0f;
-				break;
-			case 1:
-				Sprites::setDirection('D');
-				sprite_velX.at(i) = 0;
-				sprite_velY.at(i) = -Sprites::getSpeed();
-				rotation = 180.0f;
-				break;
-			case 2:
-				Sprites::setDirection('R');
-				sprite_velX.at(i) = Sprites::getSpeed();
-				sprite_velY.at(i) = 0;
-				rotation = 270.0f;
-				break;
-			case 3:
-				Sprites::setDirection('L');
-				sprite_velX.at(i) = -Sprites::getSpeed();
-				sprite_velY.at(i) = 0;
-				rotation = 90.0f;
-				break;
-			}
+/**
+ *	Lets the ghost be steered by a cooperative planner shared with the other ghosts
+ */
+void Ghosts::setPlanner(CooperativePlanner* planner) {
+	std::pair<int, int> tile = getTile();
+	this->planner = planner;
+	agent = planner->addAgent(tile.first, tile.second);
+}
 
-			if (!checkWallCollision(sprite_positions.at(i).first + sprite_velX.at(i) * dt, sprite_positions.at(i).second - 1.f + sprite_velY.at(i) * dt)) {
-				sprite_positions.at(i).first += sprite_velX.at(i) * dt;
-				sprite_positions.at(i).second += sprite_velY.at(i) * dt;
-			}
+/**
+ *	Moves the ghost along its planned path
+ *	@param stepFraction - How far (0 -> 1) the planner is into its current step
+ */
+void Ghosts::followPlan(float stepFraction, bool gameStatus) {
+	if (checkIfGameIsDone(gameStatus) || !planner) return;
+
+	std::pair<int, int> from = planner->getTile(agent, 0);
+	std::pair<int, int> to	 = planner->getTile(agent, 1);
+
+	// Keeps facing the same way while waiting
+	if		(to.second < from.second) sprite_dir[0] = 'U';
+	else if (to.second > from.second) sprite_dir[0] = 'D';
+	else if (to.first  > from.first)  sprite_dir[0] = 'R';
+	else if (to.first  < from.first)  sprite_dir[0] = 'L';
+
+	std::pair<float, float> a = getMap()->getScreenCoords(from.first + 0.5f, from.second - 0.5f);
+	std::pair<float, float> b = getMap()->getScreenCoords(to.first + 0.5f, to.second - 0.5f);
+	sprite_positions[0].first  = a.first + (b.first - a.first) * stepFraction;
+	sprite_positions[0].second = a.second + (b.second - a.second) * stepFraction;
+}
 
-			moveAllToShader(sprite_positions.at(i).first, sprite_positions.at(i).second, glm::radians(rotation), ghost_Shader);
-		}
+/**
+ *	Copies out everything about the ghost that changes while playing
+ */
+void Ghosts::saveState(GhostState& state) {
+	state.x				= sprite_positions[0].first;
+	state.y				= sprite_positions[0].second;
+	state.velX			= sprite_velX[0];
+	state.velY			= sprite_velY[0];
+	state.toCentre		= sprite_toCentre[0];
+	state.speed			= Sprites::getSpeed();
+	if (Sprites::isFixedPoint()) {
+		state.velX		= fixed_velX[0] * GhostModes::ticksPerSecond / (float)fixedOne;
+		state.velY		= fixed_velY[0] * GhostModes::ticksPerSecond / (float)fixedOne;
+		state.toCentre	= fixed_toCentre[0] == INT32_MAX ? FLT_MAX : fixedToFloat(fixed_toCentre[0]);
 	}
+	state.rng			= rng;
+	state.seenReversals = seenReversals;
+	state.dir			= sprite_dir[0];
+}
+
+/**
+ *	Puts the ghost back the way saveState() found it
+ */
+void Ghosts::loadState(const GhostState& state) {
+	sprite_positions[0] = { state.x, state.y };
+	sprite_velX[0]		= state.velX;
+	sprite_velY[0]		= state.velY;
+	sprite_toCentre[0]	= state.toCentre;
+	Sprites::setSpeed(state.speed);
+	rng					= state.rng;
+	seenReversals		= state.seenReversals;
+	sprite_dir[0]		= state.dir;
+	if (Sprites::isFixedPoint()) setFixedPoint(true);
 }
 
 
@@ -314,18 +528,15 @@ void Ghosts::movement(GLFWwindow* window, double dt, bool gameStatus, time_t see
 /**
  *	Constructor
  */
-Pacman::Pacman(Map* map, GLuint shader) : Sprites(map) {
-	this->pacman_Shader = shader;
+Pacman::Pacman(Map* map) : Sprites(map) {
+	pacPos2 = map->getScreenCoords(map->getStartX() + 0.5f, map->getStartY() - 0.5f);
 }
 
 /**
  *	Destructor
  */
 Pacman::~Pacman() {
-	delete pac_points;
-	delete pac_indices;
 
-	Sprites::getMap()->CleanVAO(pac_vao);
 }
 
 /**
@@ -363,92 +574,19 @@ bool Pacman::checkPelletCollision(std::pair<int, int> currentTile) {
 }
 
 /**
- *	Initialises pacman with all its values
+ *	Moves pacman one tick, steered by the player's input for that tick
  */
-GLuint Pacman::initPacman() {
-	glGenVertexArrays(1, &pac_vao);
-	glBindVertexArray(pac_vao);
-
-	pac_points = new std::vector<float>;
-
-	//std::pair<float, float> pacPos = Sprites::getMap()->getScreenCoords(Sprites::getMap()->getStartX() + 0.5f, Sprites::getMap()->getStartY() - 0.5f);
-	pacPos2 = Sprites::getMap()->getScreenCoords(Sprites::getMap()->getStartX() + 0.5f, Sprites::getMap()->getStartY() - 0.5f);
-
-	// Bottom Left
-	pac_points->push_back(-0.5f);
-	pac_points->push_back(-0.5f);
-	pac_points->push_back(0.f); pac_points->push_back(0.f); pac_points->push_back(0.f); // Color
-	pac_points->push_back(0.f);					//nr 5 Texture coords X
-	pac_points->push_back(1.f);					//nr 6 Y
-
-	// Bottom Right
-	pac_points->push_back(-0.5f + Sprites::getMap()->getTileSize());
-	pac_points->push_back(-0.5f);
-	pac_points->push_back(0.f); pac_points->push_back(0.f); pac_points->push_back(0.f); // Color
-	pac_points->push_back(1.f / 6.f);			//nr 12 X
-	pac_points->push_back(1.f);					//nr 13 Y
-
-	// Top Right
-	pac_points->push_back(-0.5f + Sprites::getMap()->getTileSize());
-	pac_points->push_back(-0.5f + Sprites::getMap()->getTileSize());
-	pac_points->push_back(0.f); pac_points->push_back(0.f); pac_points->push_back(0.f); // Color
-	pac_points->push_back(1.f / 6.f);			//nr 19X
-	pac_points->push_back(3.f / 4.f);			//nr 20Y
-
-	// Top Left
-	pac_points->push_back(-0.5f);
-	pac_points->push_back(-0.5f + Sprites::getMap()->getTileSize());
-	pac_points->push_back(0.f); pac_points->push_back(0.f); pac_points->push_back(0.f); // Color
-	pac_points->push_back(0.f);					//nr 26 X
-	pac_points->push_back(3.f / 4.f);			//nr 27 Y
-
-
-	glGenVertexArrays(1, &pac_vao);
-	glGenBuffers(1, &pac_vbo);
-	glBindVertexArray(this->pac_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, pac_vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof_v(*pac_points), &(*pac_points)[0], GL_DYNAMIC_DRAW);
-
-	//Set position into the Shader
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 7, (void*)(sizeof(float) * 0));
-
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 7, (void*)(sizeof(float) * 2));
-
-	//Texture coordinates
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 7, (void*)(sizeof(float) * 5));
-
-	pac_indices = new std::vector<unsigned int>;
-	pac_indices->push_back(0);
-	pac_indices->push_back(1);
-	pac_indices->push_back(3);
-
-	pac_indices->push_back(1);
-	pac_indices->push_back(2);
-	pac_indices->push_back(3);
-
-	glGenBuffers(1, &pac_ebo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pac_ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof_v(*pac_indices), &(*pac_indices)[0], GL_DYNAMIC_DRAW);
-	glBindVertexArray(0);
-
-	return (pac_vao);
-}
-
-/**
- *	Initializes movement of a sprite
- */
-bool Pacman::movement(GLFWwindow* window, double dt, std::vector<Ghosts*> ghosts, bool gameStatus) {
+bool Pacman::movement(const InputFrame& input, double dt, std::vector<Ghosts*> ghosts, bool gameStatus) {
 	bool gameDone = gameStatus;
 	char previousDir = ' ';
+	setView(input.yaw, input.pitch);
 	findCameraDirection();
+	if (Sprites::isFixedPoint()) return checkIfGameIsDone(gameDone) ? gameDone : movementFixed(input, ghosts);
 	//std::cout << Sprites::getDirection() << std::endl;
 	if (!checkIfGameIsDone(gameDone)) {
 		switch (Sprites::getViewDir()){			//Sets movement based on the direction the player is facing
 		case 'U':								// U = UP (North), R = RIGHT (East), D = DOWN (South), L = LEFT (West)
-			if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+			if (input.keys & KEY_W) {
 				previousDir = Sprites::getDirection();
 				Sprites::setDirection('D');
 				if (!checkWallCollision(pacPos2.first + 0 * dt, pacPos2.second - 1.f - Sprites::getSpeed() * dt)) {
@@ -458,7 +596,7 @@ bool Pacman::movement(GLFWwindow* window, double dt, std::vector<Ghosts*> ghosts
 				else
 					Sprites::setDirection(previousDir);
 			}
-			if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+			if (input.keys & KEY_S) {
 				previousDir = Sprites::getDirection();
 				Sprites::setDirection('U');
 				if (!checkWallCollision(pacPos2.first + 0 * dt, pacPos2.second - 1.f + Sprites::getSpeed() * dt)) {
@@ -468,7 +606,7 @@ bool Pacman::movement(GLFWwindow* window, double dt, std::vector<Ghosts*> ghosts
 				else
 					Sprites::setDirection(previousDir);
 			}
-			if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+			if (input.keys & KEY_D) {
 				previousDir = Sprites::getDirection();
 				Sprites::setDirection('L');
 				if (!checkWallCollision(pacPos2.first - Sprites::getSpeed() * dt, pacPos2.second - 1.f + 0 * dt)) {
@@ -478,7 +616,7 @@ bool Pacman::movement(GLFWwindow* window, double dt, std::vector<Ghosts*> ghosts
 				else
 					Sprites::setDirection(previousDir);
 			}
-			if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+			if (input.keys & KEY_A) {
 				previousDir = Sprites::getDirection();
 				Sprites::setDirection('R');
 				if (!checkWallCollision(pacPos2.first + Sprites::getSpeed() * dt, pacPos2.second - 1.f + 0 * dt)) {
@@ -490,7 +628,7 @@ bool Pacman::movement(GLFWwindow* window, double dt, std::vector<Ghosts*> ghosts
 			}
 			break;
 		case 'D':
-			if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+			if (input.keys & KEY_W) {
 				previousDir = Sprites::getDirection();
 				Sprites::setDirection('U');
 				if (!checkWallCollision(pacPos2.first + 0 * dt, pacPos2.second - 1.f + Sprites::getSpeed() * dt)) {
@@ -500,7 +638,7 @@ bool Pacman::movement(GLFWwindow* window, double dt, std::vector<Ghosts*> ghosts
 				else
 					Sprites::setDirection(previousDir);
 			}
-			if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+			if (input.keys & KEY_S) {
 				previousDir = Sprites::getDirection();
 				Sprites::setDirection('D');
 				if (!checkWallCollision(pacPos2.first + 0 * dt, pacPos2.second - 1.f - Sprites::getSpeed() * dt)) {
@@ -510,7 +648,7 @@ bool Pacman::movement(GLFWwindow* window, double dt, std::vector<Ghosts*> ghosts
 				else
 					Sprites::setDirection(previousDir);
 			}
-			if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+			if (input.keys & KEY_D) {
 				previousDir = Sprites::getDirection();
 				Sprites::setDirection('R');
 				if (!checkWallCollision(pacPos2.first + Sprites::getSpeed() * dt, pacPos2.second - 1.f + 0 * dt)) {
@@ -520,7 +658,7 @@ bool Pacman::movement(GLFWwindow* window, double dt, std::vector<Ghosts*> ghosts
 				else
 					Sprites::setDirection(previousDir);
 			}
-			if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+			if (input.keys & KEY_A) {
 				previousDir = Sprites::getDirection();
 				Sprites::setDirection('L');
 				if (!checkWallCollision(pacPos2.first - Sprites::getSpeed() * dt, pacPos2.second - 1.f + 0 * dt)) {
@@ -532,7 +670,7 @@ bool Pacman::movement(GLFWwindow* window, double dt, std::vector<Ghosts*> ghosts
 			}
 			break;
 		case 'R':	
-			if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+			if (input.keys & KEY_W) {
 				previousDir = Sprites::getDirection();
 				Sprites::setDirection('R');
 				if (!checkWallCollision(pacPos2.first + Sprites::getSpeed() * dt, pacPos2.second - 1.f + 0 * dt)) {
@@ -542,7 +680,7 @@ bool Pacman::movement(GLFWwindow* window, double dt, std::vector<Ghosts*> ghosts
 				else
 					Sprites::setDirection(previousDir);
 			}
-			if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+			if (input.keys & KEY_S) {
 				previousDir = Sprites::getDirection();
 				Sprites::setDirection('L');
 				if (!checkWallCollision(pacPos2.first - Sprites::getSpeed() * dt, pacPos2.second - 1.f + 0 * dt)) {
@@ -552,7 +690,7 @@ bool Pacman::movement(GLFWwindow* window, double dt, std::vector<Ghosts*> ghosts
 				else
 					Sprites::setDirection(previousDir);
 			}
-			if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+			if (input.keys & KEY_D) {
 				previousDir = Sprites::getDirection();
 				Sprites::setDirection('D');
 				if (!checkWallCollision(pacPos2.first + 0 * dt, pacPos2.second - 1.f - Sprites::getSpeed() * dt)) {
@@ -562,7 +700,7 @@ bool Pacman::movement(GLFWwindow* window, double dt, std::vector<Ghosts*> ghosts
 				else
 					Sprites::setDirection(previousDir);
 			}
-			if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+			if (input.keys & KEY_A) {
 				previousDir = Sprites::getDirection();
 				Sprites::setDirection('U');
 				if (!checkWallCollision(pacPos2.first + 0 * dt, pacPos2.second - 1.f + Sprites::getSpeed() * dt)) {
@@ -574,7 +712,7 @@ bool Pacman::movement(GLFWwindow* window, double dt, std::vector<Ghosts*> ghosts
 			}
 			break;
 		case 'L':	
-			if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) {
+			if (input.keys & KEY_W) {
 				previousDir = Sprites::getDirection();
 				Sprites::setDirection('L');
 				if (!checkWallCollision(pacPos2.first - Sprites::getSpeed() * dt, pacPos2.second - 1.f + 0 * dt)) {
@@ -584,7 +722,7 @@ bool Pacman::movement(GLFWwindow* window, double dt, std::vector<Ghosts*> ghosts
 				else
 					Sprites::setDirection(previousDir);
 			}
-			if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) {
+			if (input.keys & KEY_S) {
 				previousDir = Sprites::getDirection();
 				Sprites::setDirection('R');
 				if (!checkWallCollision(pacPos2.first + Sprites::getSpeed() * dt, pacPos2.second - 1.f + 0 * dt)) {
@@ -594,7 +732,7 @@ bool Pacman::movement(GLFWwindow* window, double dt, std::vector<Ghosts*> ghosts
 				else
 					Sprites::setDirection(previousDir);
 			}
-			if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
+			if (input.keys & KEY_D) {
 				previousDir = Sprites::getDirection();
 				Sprites::setDirection('U');
 				if (!checkWallCollision(pacPos2.first + 0 * dt, pacPos2.second - 1.f + Sprites::getSpeed() * dt)) {
@@ -604,7 +742,7 @@ bool Pacman::movement(GLFWwindow* window, double dt, std::vector<Ghosts*> ghosts
 				else
 					Sprites::setDirection(previousDir);
 			}
-			if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) {
+			if (input.keys & KEY_A) {
 				previousDir = Sprites::getDirection();
 				Sprites::setDirection('D');
 				if (!checkWallCollision(pacPos2.first + 0 * dt, pacPos2.second - 1.f - Sprites::getSpeed() * dt)) {
@@ -633,82 +771,72 @@ bool Pacman::movement(GLFWwindow* window, double dt, std::vector<Ghosts*> ghosts
 
 		if (checkGhostCollision(ghosts, pacPos2.first, pacPos2.second))
 					gameDone = true;
-		
-
-		if (Sprites::getMovAni() == 30) {
-			pacAnimate(); Sprites::setMovAni(0);
-		}
-
-		Sprites::setMovAni(Sprites::getMovAni() + 1);
-
-		moveAllToShader(pacPos2.first, pacPos2.second, 0.0f,pacman_Shader);
 	}
 
 	return gameDone;
 }
 
 /**
- *	Animates pacman sprite
+ *	movement() in fixed point, with integer math only. Every call is one tick.
+ *	@return true if a ghost caught pacman
  */
-void Pacman::pacAnimate() {
-
-	Sprites::getMap()->CleanVAO(pac_vao);
-
-
-	if (increaseStep == true) { Step++; }
-	else if (increaseStep == false) { Step--; }
-
-	widthX = (Step / 6.f);
-
-	// Change the texture coordinates based on the direction
-	switch (Sprites::getDirection()) {
-	case 'U': heightY = (2.f / 4.f); break;		// UP
-	case 'D': heightY = (1.f / 4.f); break;		// DOWN
-	case 'L': heightY = (3.f / 4.f); break;		// LEFT
-	case 'R': heightY = (1); break;				// RIGHT
+bool Pacman::movementFixed(const InputFrame& input, std::vector<Ghosts*> ghosts) {
+	// Where each key walks, for each way pacman can look (see movement())
+	static const char	 views[4]	 = { 'U', 'D', 'R', 'L' };
+	static const uint8_t keys[4]	 = { KEY_W, KEY_S, KEY_D, KEY_A };
+	static const char	 walks[4][4] = { { 'D', 'U', 'L', 'R' },
+										 { 'U', 'D', 'R', 'L' },
+										 { 'R', 'L', 'D', 'U' },
+										 { 'L', 'R', 'U', 'D' } };
+	fixed_t step = Sprites::fixedStep();
+
+	for (int v = 0; v < 4; v++) {
+		if (views[v] != Sprites::getViewDir()) continue;
+
+		for (int k = 0; k < 4; k++) {
+			if (!(input.keys & keys[k])) continue;
+
+			char previousDir = Sprites::getDirection();
+			char dir		 = walks[v][k];
+			int	 dirX		 = dir == 'R' ? 1 : dir == 'L' ? -1 : 0;
+			int	 dirY		 = dir == 'U' ? 1 : dir == 'D' ? -1 : 0;
+			Sprites::setDirection(dir);
+			if (!fixedWallCollision(fixedPos.first + dirX * step, fixedPos.second - fixedOne + dirY * step)) {
+				fixedVelX = dirX * step;
+				fixedVelY = dirY * step;
+			}
+			else
+				Sprites::setDirection(previousDir);
+		}
 	}
-	if (Step == 3) { increaseStep = false; }
-	else if (Step == 0) { increaseStep = true; }
 
+	if (!fixedWallCollision(fixedPos.first + fixedVelX, fixedPos.second - fixedOne + fixedVelY)) {
+		fixedPos.first	+= fixedVelX;
+		fixedPos.second += fixedVelY;
+	}
+	pacPos2 = { fixedToFloat(fixedPos.first), fixedToFloat(fixedPos.second) };
 
-	// Edit the vertices 5 & 6, 12 & 13, 19 & 20, 26 & 27
-	// They are our texture coordinates in pac_points
-
-	//Bottom left
-	pac_points->at(5) = widthX; pac_points->at(6) = heightY;
-
-	//Bottom Right
-	pac_points->at(12) = widthX + (1.f / 6.f); pac_points->at(13) = heightY;
-
-	//Top Right
-	pac_points->at(19) = widthX + (1.f / 6.f); pac_points->at(20) = heightY - (1.f / 4.f);
-
-	//Top Left
-	pac_points->at(26) = widthX; pac_points->at(27) = heightY - (1.f / 4.f);
-
-
-	glGenVertexArrays(1, &pac_vao);
-	glGenBuffers(1, &pac_vbo);
-	glBindVertexArray(this->pac_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, pac_vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof_v(*pac_points), &(*pac_points)[0], GL_DYNAMIC_DRAW);
-
-	// Set position into the Shader
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 7, (void*)(sizeof(float) * 0));
-
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 7, (void*)(sizeof(float) * 2));
+	std::pair<int, int> currentTile = fixedToTile(fixedPos.first, fixedPos.second - fixedOne);
+	if (checkPelletCollision(currentTile))
+		Sprites::getMap()->deletePellet(currentTile);
 
-	// Texture coordinates
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 7, (void*)(sizeof(float) * 5));
+	bool gameDone = false;
+	std::pair<int, int> pacmanTile = fixedToTile(fixedPos.first, fixedPos.second);
+	for (auto ghost : ghosts)
+		if (fixedToTile(ghost->getFixedPos(0).first, ghost->getFixedPos(0).second) == pacmanTile) gameDone = true;
 
-	glGenBuffers(1, &pac_ebo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pac_ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof_v(*pac_indices), &(*pac_indices)[0], GL_DYNAMIC_DRAW);
-	glBindVertexArray(0);
+	return gameDone;
+}
 
+/**
+ *	Switches between float and fixed point movement, carrying pacman's
+ *	position and velocity over
+ */
+void Pacman::setFixedPoint(bool fixedPoint) {
+	Sprites::setFixedPoint(fixedPoint);
+	fixedPos  = { toFixed(pacPos2.first), toFixed(pacPos2.second) };
+	fixedVelX = (fixed_t)std::lround(velX * fixedOne / GhostModes::ticksPerSecond);
+	fixedVelY = (fixed_t)std::lround(velY * fixedOne / GhostModes::ticksPerSecond);
 }
 
 /**
@@ -722,38 +850,51 @@ void Pacman::findCameraDirection() {
 }
 
 /**
- *	Updates the firstperson camera on pacman
+ *	Points the camera, angles are in thousandths of a degree
+ *	@see InputFrame
  */
-void Pacman::updateCamera(double xpos, double ypos) {
-	if (firstMouse)
-	{
-		lastX = xpos;
-		lastY = ypos;
-		firstMouse = false;
-	}
-
-	float xoffset = xpos - lastX;
-	float yoffset = lastY - ypos; // reversed since y-coordinates go from bottom to top
-	lastX = xpos;
-	lastY = ypos;
-
-	float sensitivity = 0.1f; // change this value to your liking
-	xoffset *= sensitivity;
-	yoffset *= sensitivity;
-
-	yaw += xoffset;
-	pitch += yoffset;
-
-	// make sure that when pitch is out of bounds, screen doesn't get flipped
-	if (pitch > 89.0f)
-		pitch = 89.0f;
-	if (pitch < -89.0f)
-		pitch = -89.0f;
+void Pacman::setView(int32_t yawMilli, int32_t pitchMilli) {
+	yaw			= yawMilli / 1000.f;
+	pitch		= pitchMilli / 1000.f;
+	cameraFront = viewDirection(yaw, pitch);
+}
 
+/**
+ *	Unit vector the camera looks along, angles are in degrees
+ */
+glm::vec3 Pacman::viewDirection(float yaw, float pitch) {
 	glm::vec3 direction;
 	direction.z = sin(glm::radians(pitch));
 	direction.x = -cos(glm::radians(yaw)) * cos(glm::radians(pitch));
 	direction.y = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
-	cameraFront = glm::normalize(direction);
+	return glm::normalize(direction);
+}
 
-}
\ No newline at end of file
+/**
+ *	Copies out everything about pacman that changes while playing
+ */
+void Pacman::saveState(PacmanState& state) {
+	state.x				= pacPos2.first;
+	state.y				= pacPos2.second;
+	state.velX			= Sprites::isFixedPoint() ? fixedVelX * GhostModes::ticksPerSecond / (float)fixedOne : velX;
+	state.velY			= Sprites::isFixedPoint() ? fixedVelY * GhostModes::ticksPerSecond / (float)fixedOne : velY;
+	state.speed			= Sprites::getSpeed();
+	state.yaw			= (int32_t)std::lround(yaw * 1000.0);
+	state.pitch			= (int32_t)std::lround(pitch * 1000.0);
+	state.direction		= Sprites::getDirection();
+	state.viewDir		= Sprites::getViewDir();
+}
+
+/**
+ *	Puts pacman back the way saveState() found him
+ */
+void Pacman::loadState(const PacmanState& state) {
+	pacPos2		 = { state.x, state.y };
+	velX		 = state.velX;
+	velY		 = state.velY;
+	Sprites::setSpeed(state.speed);
+	setView(state.yaw, state.pitch);
+	Sprites::setDirection(state.direction);
+	Sprites::setViewDirection(state.viewDir);
+	if (Sprites::isFixedPoint()) setFixedPoint(true);
+}
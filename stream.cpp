@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <iostream>
+
+#include "headers/stream.h"
+
+
+/**
+ *	Constructor
+ *	@param frameSize - Bytes one frame can allocate, the buffer is 3 times that
+ */
+StreamBuffer::StreamBuffer(size_t frameSize) : frameSize(frameSize) {
+
+}
+
+/**
+ *	Destructor
+ */
+StreamBuffer::~StreamBuffer() {
+
+}
+
+/**
+ *	Makes and maps the buffer, on the GL thread
+ *	@return false if GL couldn't make it
+ */
+bool StreamBuffer::init() {
+	GLint ssboAlignment = 0, uboAlignment = 0;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &ssboAlignment);
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uboAlignment);
+	bindAlignment = (size_t)std::max({ ssboAlignment, uboAlignment, 16 });
+
+	GLsizeiptr size = (GLsizeiptr)(frameSize * frames);
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	persistent = GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage;
+	if (persistent) {
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+		mapped = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags);
+		persistent = mapped != nullptr;
+		if (!persistent) {							// Storage is immutable, start over
+			glDeleteBuffers(1, &buffer);
+			glGenBuffers(1, &buffer);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		}
+	}
+	if (!persistent) {
+		glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+		shadow.resize(frameSize * frames);
+		mapped = shadow.data();
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	if (!buffer) {
+		std::cout << "Couldnt make the streaming buffer" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+/**
+ *	Unmaps and deletes the buffer, while the context is still there
+ */
+void StreamBuffer::release() {
+	for (GLsync& fence : fences) {
+		if (fence) glDeleteSync(fence);
+		fence = nullptr;
+	}
+	if (buffer && persistent) {
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+	if (buffer) glDeleteBuffers(1, &buffer);
+	buffer = 0;
+	mapped = nullptr;
+	std::vector<unsigned char>().swap(shadow);
+}
+
+/**
+ *	Starts a frame in the next region, once the GPU is done with the frame
+ *	that used it last
+ */
+void StreamBuffer::beginFrame() {
+	region = (region + 1) % frames;
+	used   = 0;
+
+	GLsync& fence = fences[region];
+	if (fence) {
+		if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+			stalls++;
+			glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);	// 1 second at most
+		}
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+}
+
+/**
+ *	Ends the frame, its region is free again once the GPU passes this point
+ */
+void StreamBuffer::endFrame() {
+	if (buffer) fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/**
+ *	Hands out a piece of this frame's region
+ *	@param align - Offset the piece starts on a multiple of (any size, like
+ *				   a vertex), 0 for one glBindBufferRange() accepts
+ *	@return An empty range if the region is full, or for 0 bytes
+ */
+StreamBuffer::Range StreamBuffer::allocate(size_t bytes, size_t align) {
+	Range range;
+	if (!mapped || bytes == 0) return range;
+	if (align == 0) align = bindAlignment;
+
+	size_t start  = region * frameSize;
+	size_t offset = (start + used + align - 1) / align * align;
+	if (offset + bytes > start + frameSize) return range;
+
+	used		 = offset + bytes - start;
+	range.data	 = mapped + offset;
+	range.offset = (GLintptr)offset;
+	range.size	 = (GLsizeiptr)bytes;
+	return range;
+}
+
+/**
+ *	Makes what was written to a range visible to the GPU. A mapped buffer
+ *	sees it already, this only copies when there is no persistent mapping.
+ *	@param from	 - First byte of the range to send
+ *	@param bytes - How many, the rest of the range by default
+ */
+void StreamBuffer::commit(const Range& range, size_t from, size_t bytes) {
+	if (persistent || !range) return;
+
+	bytes = std::min(bytes, (size_t)range.size - from);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, range.offset + from, bytes, range.data + from);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+/**
+ *	Commits a range and binds it to an indexed target
+ *	(GL_SHADER_STORAGE_BUFFER, GL_UNIFORM_BUFFER)
+ */
+void StreamBuffer::bind(GLenum target, GLuint index, const Range& range) {
+	if (!range) return;
+	commit(range);
+	glBindBufferRange(target, index, buffer, range.offset, range.size);
+}
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "headers/swarm.h"
+#include "headers/ghostai.h"
+
+
+/**
+ *	Next number of a ghost's xorshift32 random state, as the shader has it
+ */
+static uint32_t nextRandom(uint32_t& state) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+/**
+ *	Which way a ghost goes on from a tile centre, like Ghosts::pickExit()
+ *	for a wanderer
+ *	@param exit - The exit it came in through, 0 if it was standing
+ *	@return The exit bit, 0 if the ghost is walled in
+ */
+static uint32_t pickExit(Map& map, int x, int y, uint32_t exit, uint32_t& rng) {
+	uint32_t exits = map.getExits(x, y);
+	uint32_t back  = exit == EXIT_U ? EXIT_D : exit == EXIT_D ? EXIT_U : exit == EXIT_L ? EXIT_R : exit == EXIT_R ? EXIT_L : 0;
+	if (exits & ~back) exits &= ~back;
+	if (exits == 0 || (exits & (exits - 1)) == 0) return exits;
+
+	uint32_t options[4], count = 0;
+	for (uint32_t bit = EXIT_U; bit <= EXIT_R; bit <<= 1)
+		if (exits & bit) options[count++] = bit;
+	return options[nextRandom(rng) % count];
+}
+
+
+/**
+ *	Constructor, puts every ghost on a random open tile, standing still
+ *	@param speed - Tiles per second
+ */
+GhostSwarm::GhostSwarm(Map& map, int count, uint32_t seed, float speed)
+	: map(map), count(count), speed((fixed_t)std::lround(speed * fixedOne / GhostModes::ticksPerSecond)) {
+
+	std::vector<std::pair<int, int>> open;
+	const std::vector<std::vector<int>>& mapArr = map.getMapArray();
+	for (int y = 0; y < map.getHeight(); y++)
+		for (int x = 0; x < map.getWidth(); x++)
+			if (mapArr[y][x] == 0) open.push_back({ x, y });
+	if (open.empty()) this->count = 0;
+
+	GhostRng rng;
+	rng.seed(seed);
+	spawn.resize(this->count);
+	for (Ghost& ghost : spawn) {
+		std::pair<int, int> tile = open[rng() % open.size()];
+		ghost = { tile.first, tile.second, 0, 0, rng() | 1 };
+	}
+}
+
+/**
+ *	Destructor
+ */
+GhostSwarm::~GhostSwarm() {
+
+}
+
+/**
+ *	Uploads the ghosts and the exits, on the GL thread
+ *	@param simShader - Compute program with the swarm shader
+ *	@return false if GL couldn't make the buffers
+ */
+bool GhostSwarm::init(GLuint simShader) {
+	shader = simShader;
+
+	glGenBuffers(1, &ghosts);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ghosts);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<size_t>(spawn.size() * sizeof(Ghost), 4), spawn.data(), GL_DYNAMIC_COPY);
+
+	glGenBuffers(1, &transforms);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, transforms);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<size_t>(spawn.size() * 16 * sizeof(float), 4), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	// One texel per tile, its Exit bits
+	std::vector<unsigned char> bits(map.getWidth() * map.getHeight());
+	for (int y = 0; y < map.getHeight(); y++)
+		for (int x = 0; x < map.getWidth(); x++) bits[y * map.getWidth() + x] = map.getExits(x, y);
+
+	glGenTextures(1, &exits);
+	glBindTexture(GL_TEXTURE_2D, exits);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, map.getWidth(), map.getHeight(), 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, bits.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	if (!ghosts || !transforms || !exits) {
+		std::cout << "Couldnt make the buffers of the ghost swarm" << std::endl;
+		return false;
+	}
+	step(0);		// Transformations for where they spawned
+	return true;
+}
+
+/**
+ *	Deletes the buffers and the texture, while the context is still there
+ */
+void GhostSwarm::release() {
+	if (ghosts)		glDeleteBuffers(1, &ghosts);
+	if (transforms) glDeleteBuffers(1, &transforms);
+	if (exits)		glDeleteTextures(1, &exits);
+	ghosts = transforms = exits = 0;
+}
+
+/**
+ *	Moves every ghost some ticks on, and writes where they are drawn
+ */
+void GhostSwarm::step(int ticks) {
+	if (!ghosts || count == 0) return;
+
+	std::pair<float, float> origin = map.getScreenCoords(0.5f, -0.5f);		// Centre of tile (0, 0)
+	glUseProgram(shader);
+	glUniform1ui(glGetUniformLocation(shader, "u_Count"), (GLuint)count);
+	glUniform1i(glGetUniformLocation(shader, "u_Ticks"), ticks);
+	glUniform1i(glGetUniformLocation(shader, "u_Speed"), speed);
+	glUniform2f(glGetUniformLocation(shader, "u_Origin"), origin.first, origin.second);
+	glUniform1i(glGetUniformLocation(shader, "u_Exits"), 1);
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, exits);
+	glActiveTexture(GL_TEXTURE0);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, ghosts);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, transforms);
+	glDispatchCompute((count + 63) / 64, 1, 1);
+
+	// Culling and the next step read what this one wrote
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+/**
+ *	Copies the ghosts back from the GPU, which waits for it to finish
+ */
+void GhostSwarm::read(std::vector<Ghost>& ghosts) {
+	ghosts.resize(count);
+	if (!this->ghosts || count == 0) return;
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->ghosts);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * sizeof(Ghost), ghosts.data());
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/**
+ *	What step() does, on the CPU, to check the shader against
+ */
+void GhostSwarm::stepReference(std::vector<Ghost>& ghosts, int ticks) {
+	const int stepX[9] = { 0, 0, 0, 0, -1, 0, 0, 0, 1 },		// By Exit bit
+			  stepY[9] = { 0, -1, 1, 0, 0, 0, 0, 0, 0 };
+
+	for (Ghost& ghost : ghosts) {
+		for (int t = 0; t < ticks; t++) {
+			if (ghost.exit == 0) {
+				ghost.exit = pickExit(map, ghost.tileX, ghost.tileY, 0, ghost.rng);
+				if (ghost.exit == 0) continue;
+			}
+
+			ghost.progress += speed;
+			while (ghost.progress >= fixedOne) {
+				ghost.tileX += stepX[ghost.exit];
+				ghost.tileY += stepY[ghost.exit];
+				ghost.progress -= fixedOne;
+				ghost.exit = pickExit(map, ghost.tileX, ghost.tileY, ghost.exit, ghost.rng);
+				if (ghost.exit == 0) { ghost.progress = 0; break; }
+			}
+		}
+	}
+}
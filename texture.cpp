@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+
+#include "headers/pack.h"
+#include "headers/texture.h"
+
+namespace {
+	const char		textureMagic[4]	= { 'P', 'T', 'E', 'X' };
+	const uint32_t	textureVersion	= 3;						// 2: array textures, 3: images packed into shared layers
+	const int		maxSize			= 16384;					// Biggest layer we make or read
+	const int		border			= 8;						// Texels of repeated edge around every image
+	const int		align			= 2 * border;				// Images start on multiples of this, so the first
+																// levels box filter each one on its own
+
+	struct TextureHeader {
+		char		magic[4];
+		uint32_t	version,
+					format,
+					width,
+					height,
+					levels,
+					layers,
+					images;
+	};
+
+	/**
+	 *	Where build() puts an image
+	 */
+	struct Spot {
+		int			layer,
+					x,
+					y;
+	};
+
+	int alignUp(int value) { return (value + align - 1) / align * align; }
+
+	/**
+	 *	Shelf packing: left to right along a shelf as tall as its tallest
+	 *	image, a new shelf below when one is full and a new layer when the
+	 *	layer is
+	 *	@param order - The images, tallest first
+	 *	@return Layers used, 0 if an image is bigger than a layer
+	 */
+	int shelfPack(const std::vector<MipChain::Image>& images, const std::vector<size_t>& order, int width, int height,
+				  std::vector<Spot>& spots) {
+		int layer = 0, x = 0, y = 0, shelf = 0;
+		for (size_t i : order) {
+			const MipChain::Image& image = images[i];
+			if (image.width > width || image.height > height) return 0;
+
+			if (x > 0 && x + image.width > width) {
+				x	  = 0;
+				y	  = alignUp(y + shelf + 2 * border);
+				shelf = 0;
+			}
+			if (y > 0 && y + image.height > height) {
+				layer++;
+				x = y = shelf = 0;
+			}
+			spots[i] = { layer, x, y };
+			x		 = alignUp(x + image.width + 2 * border);
+			shelf	 = std::max(shelf, image.height);
+		}
+		return layer + 1;
+	}
+
+	/**
+	 *	Halves a level, every texel is the alpha weighted average of (up to) 4
+	 */
+	void downsample(const unsigned char* src, int width, int height, unsigned char* dst) {
+		int w = std::max(1, width / 2), h = std::max(1, height / 2);
+		for (int y = 0; y < h; y++)
+			for (int x = 0; x < w; x++) {
+				int x0 = std::min(2 * x, width - 1),  x1 = std::min(2 * x + 1, width - 1);
+				int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+				const unsigned char* texels[4] = { src + (y0 * width + x0) * 4, src + (y0 * width + x1) * 4,
+												   src + (y1 * width + x0) * 4, src + (y1 * width + x1) * 4 };
+
+				unsigned alpha = 0, colour[3] = { 0, 0, 0 }, plain[3] = { 0, 0, 0 };
+				for (const unsigned char* t : texels) {
+					alpha += t[3];
+					for (int c = 0; c < 3; c++) { colour[c] += t[c] * t[3]; plain[c] += t[c]; }
+				}
+
+				unsigned char* out = dst + (y * w + x) * 4;
+				for (int c = 0; c < 3; c++)
+					out[c] = (unsigned char)(alpha ? (colour[c] + alpha / 2) / alpha : (plain[c] + 2) / 4);
+				out[3] = (unsigned char)((alpha + 2) / 4);
+			}
+	}
+}
+
+
+/**
+ *	@return Levels in a full chain, down to 1x1
+ */
+int MipChain::levelCount(int width, int height) {
+	int count = 1;
+	for (int size = std::max(width, height); size > 1; size /= 2) count++;
+	return count;
+}
+
+/**
+ *	@return Name the packer stores the chain of a single image under
+ */
+std::string MipChain::cacheName(const std::string& name) {
+	return name.substr(0, name.rfind('.')) + ".tex";
+}
+
+/**
+ *	Makes the full chain out of RGBA images, packed into as few texels as
+ *	it takes, copying them
+ *	@return false if there is nothing to build from
+ */
+bool MipChain::build(const std::vector<Image>& images) {
+	clear();
+	if (images.empty()) return false;
+
+	int width = 0, height = 0;
+	for (const Image& image : images) {
+		if (!image.pixels || image.width <= 0 || image.height <= 0 || image.width > maxSize || image.height > maxSize) return false;
+		width  = std::max(width, image.width);
+		height = std::max(height, image.height);
+	}
+
+	// Layers as big as the biggest image, or one layer as tall as it takes to hold them all, whichever is smaller
+	std::vector<size_t> order(images.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return images[a].height > images[b].height; });
+
+	std::vector<Spot> spots(images.size()), tall(images.size());
+	int layers = shelfPack(images, order, width, height, spots);
+	if (shelfPack(images, order, width, maxSize, tall) == 1) {
+		int tallHeight = 0;
+		for (size_t i = 0; i < images.size(); i++) tallHeight = std::max(tallHeight, tall[i].y + images[i].height);
+		if ((size_t)tallHeight < (size_t)height * layers) {
+			spots.swap(tall);
+			height	   = tallHeight;
+			layers = 1;
+		}
+	}
+
+	TextureHeader header = {};
+	std::memcpy(header.magic, textureMagic, sizeof(textureMagic));
+	header.version = textureVersion;
+	header.format  = formatRGBA8;
+	header.width   = width;
+	header.height  = height;
+	header.levels  = levelCount(width, height);
+	header.layers  = (uint32_t)layers;
+	header.images  = (uint32_t)images.size();
+
+	size_t layerBytes = (size_t)width * height * 4, total = 0;
+	for (int level = 0, w = width, h = height; level < (int)header.levels; level++, w = std::max(1, w / 2), h = std::max(1, h / 2))
+		total += (size_t)w * h * 4 * layers;
+
+	size_t tableBytes = sizeof(Placed) * images.size();
+	storage.resize(sizeof(header) + tableBytes + total);
+	std::memcpy(storage.data(), &header, sizeof(header));
+
+	unsigned char* level = storage.data() + sizeof(header) + tableBytes;
+	for (size_t i = 0; i < images.size(); i++) {
+		const Image& image = images[i];
+		const Spot&	 spot  = spots[i];
+		Placed placed = { (uint32_t)spot.layer, (uint32_t)spot.x, (uint32_t)spot.y, (uint32_t)image.width, (uint32_t)image.height,
+						  0, AssetPack::hashName(image.name) };
+		std::memcpy(storage.data() + sizeof(header) + i * sizeof(Placed), &placed, sizeof(placed));
+
+		// The image with its edge repeated around it, as far as the layer goes
+		unsigned char* target = level + spot.layer * layerBytes;
+		int x0 = std::max(0, spot.x - border), x1 = std::min(width, spot.x + image.width + border);
+		int y0 = std::max(0, spot.y - border), y1 = std::min(height, spot.y + image.height + border);
+		for (int y = y0; y < y1; y++) {
+			const unsigned char* row = image.pixels + (size_t)std::min(std::max(y - spot.y, 0), image.height - 1) * image.width * 4;
+			unsigned char*		 out = target + (size_t)y * width * 4;
+			std::memcpy(out + spot.x * 4, row, (size_t)image.width * 4);
+			for (int x = x0; x < spot.x; x++) std::memcpy(out + x * 4, row, 4);
+			for (int x = spot.x + image.width; x < x1; x++) std::memcpy(out + x * 4, row + (image.width - 1) * 4, 4);
+		}
+	}
+
+	for (int w = width, h = height; w > 1 || h > 1; w = std::max(1, w / 2), h = std::max(1, h / 2)) {
+		size_t bytes = (size_t)w * h * 4, next = (size_t)std::max(1, w / 2) * std::max(1, h / 2) * 4;
+		for (int i = 0; i < layers; i++)
+			downsample(level + i * bytes, w, h, level + layers * bytes + i * next);
+		level += layers * bytes;
+	}
+
+	// The levels are found the same way as in a cached file
+	std::vector<unsigned char> file;
+	file.swap(storage);
+	bool parsed = parse(file.data(), file.size());
+	storage.swap(file);
+	return parsed;
+}
+
+/**
+ *	Reads a chain written by build(), without copying it. The data has to
+ *	stay alive as long as the chain is used.
+ *	@return false if it is broken or a format this version can't read
+ */
+bool MipChain::parse(const unsigned char* data, size_t size) {
+	clear();
+
+	TextureHeader header;
+	if (!data || size < sizeof(header)) return false;
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, textureMagic, sizeof(textureMagic)) != 0 || header.version != textureVersion
+		|| header.format != formatRGBA8 || header.width == 0 || header.height == 0 || header.width > maxSize || header.height > maxSize
+		|| header.levels != (uint32_t)levelCount(header.width, header.height) || header.layers == 0 || header.layers > 2048
+		|| header.images == 0 || header.images > 2048 || sizeof(header) + header.images * sizeof(Placed) > size)
+		return false;
+
+	images.resize(header.images);
+	std::memcpy(images.data(), data + sizeof(header), header.images * sizeof(Placed));
+	for (const Placed& image : images)
+		if (image.layer >= header.layers || image.width == 0 || image.height == 0
+			|| image.x + image.width > header.width || image.y + image.height > header.height) {
+			clear();
+			return false;
+		}
+	layerCount = (int)header.layers;
+
+	const unsigned char* pixels = data + sizeof(header) + header.images * sizeof(Placed);
+	int w = header.width, h = header.height;
+	for (uint32_t level = 0; level < header.levels; level++) {
+		levels.push_back({ w, h, pixels });
+		pixels	   += (size_t)w * h * 4 * header.layers;
+		this->size += (size_t)w * h * 4 * header.layers;
+		w = std::max(1, w / 2);
+		h = std::max(1, h / 2);
+	}
+
+	if (pixels > data + size) {
+		clear();
+		return false;
+	}
+	return true;
+}
+
+/**
+ *	Drops the levels, and the storage if they were built here
+ */
+void MipChain::clear() {
+	levels.clear();
+	images.clear();
+	layerCount = 0;
+	size	   = 0;
+	std::vector<unsigned char>().swap(storage);
+}
+
+const unsigned char* MipChain::getPixels(int level, int layer) {
+	return levels[level].pixels + (size_t)levels[level].width * levels[level].height * 4 * layer;
+}
+
+/**
+ *	@return Where a level's layer starts, counted from the first pixel of level 0
+ */
+size_t MipChain::getOffset(int level, int layer) {
+	return getPixels(level, layer) - levels[0].pixels;
+}
+
+/**
+ *	@return The image of that name, -1 if there is none
+ */
+int MipChain::findImage(const std::string& name) {
+	uint64_t hash = AssetPack::hashName(name);
+	for (int i = 0; i < (int)images.size(); i++)
+		if (images[i].name == hash) return i;
+	return -1;
+}
+
+/**
+ *	Where an image sits in the array. Its own texture coordinates (0 -> 1)
+ *	times the scale plus the offset sample it out of the layer.
+ */
+void MipChain::getImageRect(int image, int& layer, float& offsetU, float& offsetV, float& scaleU, float& scaleV) {
+	const Placed& placed = images[image];
+	layer	= (int)placed.layer;
+	offsetU = (float)placed.x		/ levels[0].width;
+	offsetV = (float)placed.y		/ levels[0].height;
+	scaleU	= (float)placed.width	/ levels[0].width;
+	scaleV	= (float)placed.height	/ levels[0].height;
+}
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <cstring>
+
+#include "headers/vecenv.h"
+#include "headers/parallel.h"
+
+
+/**
+ *	Constructor
+ *	@param envs		 - Games stepped together
+ *	@param frameSkip - Ticks every action is held for
+ *	@param threads	 - Games are stepped on this many threads, every core if 0
+ */
+VecEnv::VecEnv(const std::string& levelPath, int envs, int ghostAmount, int frameSkip, int threads) {
+	this->frameSkip = frameSkip > 0 ? frameSkip : 1;
+	this->threads	= std::min(threadCount(threads), std::max(1, envs));
+
+	for (int i = 0; i < envs; i++) games.emplace_back(new Game(levelPath, i, ghostAmount, true));
+	seeds.assign(envs, 0);
+	episodes.assign(envs, 0);
+
+	if (!games.empty()) {
+		Map& map = games[0]->getMap();
+		width  = map.getWidth();
+		height = map.getHeight();
+
+		const std::vector<std::vector<int>>& mapArr = map.getMapArray();
+		wallPlane.resize(width * height);
+		for (int y = 0; y < height; y++)
+			for (int x = 0; x < width; x++) wallPlane[y * width + x] = mapArr[y][x] == 1;
+	}
+
+	ownObservations.resize(envs * getObservationSize());
+	ownRewards.resize(envs);
+	ownDones.resize(envs);
+	bind(nullptr, nullptr, nullptr);
+}
+
+/**
+ *	Destructor
+ */
+VecEnv::~VecEnv() {
+
+}
+
+/**
+ *	Makes step() and reset() write into the caller's arrays. Any that are
+ *	nullptr go back to the environment's own.
+ *	@param observations - envs x getObservationSize() bytes
+ *	@param rewards		- envs floats
+ *	@param dones		- envs bytes of DoneFlag bits
+ */
+void VecEnv::bind(uint8_t* observations, float* rewards, uint8_t* dones) {
+	this->observations	= observations ? observations : ownObservations.data();
+	this->rewards		= rewards	   ? rewards	  : ownRewards.data();
+	this->dones			= dones		   ? dones		  : ownDones.data();
+}
+
+/**
+ *	Starts every game over
+ *	@param seeds - One per game, nullptr for 0, 1, 2...
+ */
+void VecEnv::reset(const uint32_t* seeds) {
+	for (int i = 0; i < getEnvCount(); i++) {
+		this->seeds[i] = seeds ? seeds[i] : (uint32_t)i;
+		episodes[i]	   = 0;
+		games[i]->reset(this->seeds[i]);
+		rewards[i]	   = 0.f;
+		dones[i]	   = 0;
+		observe(i);
+	}
+}
+
+/**
+ *	Advances every game by one action
+ *	@param actions - One heading (0 -> 3) per game
+ */
+void VecEnv::step(const int32_t* actions) {
+	parallelFor(getEnvCount(), threads, [&](int, int env) {
+		stepEnv(env, actions[env]);
+	});
+	steps += getEnvCount();
+}
+
+void VecEnv::stepEnv(int env, int action) {
+	Game& game = *games[env];
+	int pellets = game.getMap().getp_count();
+
+	InputFrame input = headingInput(action & 3);
+	for (int t = 0; t < frameSkip && !game.isDone() && !game.isCleared(); t++) game.tick(input);
+
+	// The bits only cover real pellets, so the start tile never pays out
+	rewards[env] = (pellets - game.getMap().getp_count()) * pelletReward + (game.isDone() ? caughtReward : 0.f);
+	dones[env]	 = (game.isDone() || game.isCleared() ? DONE_TERMINAL : 0)
+				 | (game.getTick() >= maxTicks ? DONE_TRUNCATED : 0);
+
+	// Seeds of later episodes are spread out so games never line up
+	if (dones[env]) game.reset(seeds[env] + ++episodes[env] * 0x9E3779B9u);
+	observe(env);
+}
+
+/**
+ *	Writes a game's observation: the wall plane, the pellet bits spread out
+ *	to bytes, and the tiles pacman and the ghosts stand on
+ */
+void VecEnv::observe(int env) {
+	Game&	 game  = *games[env];
+	int		 tiles = width * height;
+	uint8_t* out   = observations + env * getObservationSize();
+
+	memcpy(out, wallPlane.data(), tiles);
+
+	const uint64_t* pellets = game.getMap().getPelletBits();
+	uint8_t*		pelletPlane = out + tiles;
+	for (int i = 0; i < tiles; i++) pelletPlane[i] = (pellets[i >> 6] >> (i & 63)) & 1;
+
+	uint8_t* pacPlane	= out + 2 * tiles;
+	uint8_t* ghostPlane = out + 3 * tiles;
+	memset(pacPlane, 0, 2 * tiles);
+
+	Pacman& pacman = game.getPacman();
+	std::pair<int, int> tile = pacman.coordsToTile(pacman.getPacPos().first, pacman.getPacPos().second - 1.f);
+	if (tile.first >= 0 && tile.second >= 0 && tile.first < width && tile.second < height)
+		pacPlane[tile.second * width + tile.first] = 1;
+
+	for (auto ghost : game.getGhosts()) {
+		tile = ghost->getTile();
+		if (tile.first >= 0 && tile.second >= 0 && tile.first < width && tile.second < height)
+			ghostPlane[tile.second * width + tile.first]++;
+	}
+}
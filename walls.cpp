@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <iostream>
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "headers/walls.h"
+
+
+/**
+ *	Constructor
+ */
+WallMesher::WallMesher() {
+
+}
+
+/**
+ *	Destructor
+ */
+WallMesher::~WallMesher() {
+
+}
+
+/**
+ *	Makes the buffers and the vertex array, on the GL thread
+ *	@param meshShader - Compute program with the wall mesh shader
+ *	@return false if the shader didn't compile or GL couldn't make the buffers
+ */
+bool WallMesher::init(GLuint meshShader) {
+	if (!meshShader) {
+		std::cout << "Couldnt mesh the walls on the GPU without a shader" << std::endl;
+		return false;
+	}
+	shader = meshShader;
+
+	for (GLuint* buffer : { &tiles, &scan, &vbo, &ebo, &command }) glGenBuffers(1, buffer);
+	glGenVertexArrays(1, &vao);
+	if (!vao || !tiles || !scan || !vbo || !ebo || !command) {
+		std::cout << "Couldnt make the buffers for the walls" << std::endl;
+		return false;
+	}
+
+	// The shader writes Map::meshWallTile()'s vertices: position, colour, texture coordinates
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+	// location=0 -> position
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+
+	// location=1 -> Color
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+
+	// location=2 -> Texture coordinates, the layer and the offset are the same for every vertex
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return true;
+}
+
+/**
+ *	Deletes the buffers, while the context is still there
+ */
+void WallMesher::release() {
+	for (GLuint* buffer : { &tiles, &scan, &vbo, &ebo, &command }) {
+		if (*buffer) glDeleteBuffers(1, buffer);
+		*buffer = 0;
+	}
+	if (vao) glDeleteVertexArrays(1, &vao);
+	vao		 = 0;
+	walls	 = 0;
+	capacity = 0;
+}
+
+/**
+ *	Sends a level's tiles up and meshes its walls
+ *	@return false if init() wasn't called
+ */
+bool WallMesher::build(Map& map) {
+	if (!vao) return false;
+
+	const auto& mapArr = map.getMapArray();
+	std::pair<float, float> start = map.getScreenCoords(0.f, (float)(map.getHeight() - 1));
+	width	 = map.getWidth();
+	height	 = map.getHeight();
+	startX	 = start.first;
+	startY	 = start.second;
+	tileSize = map.getTileSize();
+
+	// Counting the walls is all the CPU does, to size the buffers
+	grid.resize((size_t)width * height);
+	walls = 0;
+	for (int y = 0; y < height; y++) {
+		std::copy(mapArr[y].begin(), mapArr[y].begin() + width, grid.begin() + (size_t)y * width);
+		walls += (int)std::count(mapArr[y].begin(), mapArr[y].begin() + width, 1);
+	}
+
+	// Levels of the scan: a value per tile, then one per 256 of the level below, up to the total
+	levels = { 0, (GLuint)grid.size() };
+	while (levels.size() == 2 || levels[levels.size() - 1] - levels[levels.size() - 2] > 1)
+		levels.push_back(levels.back() + (levels[levels.size() - 1] - levels[levels.size() - 2] + 255) / 256);
+
+	auto storage = [](GLuint buffer, size_t bytes, const void* data) {
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<size_t>(bytes, 4), data, data ? GL_STATIC_DRAW : GL_DYNAMIC_COPY);
+	};
+	storage(tiles,	 grid.size() * sizeof(int),		grid.data());
+	storage(scan,	 levels.back() * sizeof(GLuint),	nullptr);
+	storage(command, sizeof(DrawCommand),			nullptr);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	capacity = 0;
+	reserve();
+	mesh();
+	return true;
+}
+
+/**
+ *	Makes the vertex and index buffers big enough for every side of every
+ *	wall, and half as big again when they grow so edits rarely make them
+ */
+void WallMesher::reserve() {
+	capacity = std::max(walls, capacity + capacity / 2);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, vbo);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<size_t>((size_t)capacity * Map::wallFloats * sizeof(float), 4), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, ebo);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<size_t>((size_t)capacity * Map::wallIndices * sizeof(unsigned int), 4), nullptr, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+/**
+ *	Changes one tile in the tile buffer, for levels that change while
+ *	playing. Call mesh() once every change is in.
+ *	@return false if the tile isn't in the level or build() wasn't called
+ */
+bool WallMesher::setTile(int x, int y, int tile) {
+	if (!vao || x < 0 || y < 0 || x >= width || y >= height) return false;
+
+	int& old = grid[(size_t)y * width + x];
+	walls += (tile == 1) - (old == 1);
+	old	   = tile;
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, tiles);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, ((size_t)y * width + x) * sizeof(int), sizeof(int), &tile);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	if (walls > capacity) reserve();
+	return true;
+}
+
+/**
+ *	Meshes the walls of the tile buffer again
+ */
+void WallMesher::mesh() {
+	if (!vao) return;
+
+	// The last tile fills the index count in
+	DrawCommand start = { 0, 1, 0, 0, 0 };
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, command);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(DrawCommand), &start);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	if (grid.empty()) return;
+
+	glUseProgram(shader);
+	glUniform1i(glGetUniformLocation(shader, "u_Width"), width);
+	glUniform1i(glGetUniformLocation(shader, "u_Height"), height);
+	glUniform2f(glGetUniformLocation(shader, "u_Start"), startX, startY);
+	glUniform1f(glGetUniformLocation(shader, "u_TileSize"), tileSize);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, tiles);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, scan);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, vbo);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, ebo);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, command);
+
+	// One invocation per value of the level, every pass reads what the one before wrote
+	auto pass = [&](int pass, size_t level) {
+		GLuint length = levels[level + 1] - levels[level];
+		glUniform1i(glGetUniformLocation(shader, "u_Pass"), pass);
+		glUniform1ui(glGetUniformLocation(shader, "u_Level"), levels[level]);
+		glUniform1ui(glGetUniformLocation(shader, "u_Next"), levels[level + 1]);
+		glUniform1ui(glGetUniformLocation(shader, "u_Length"), length);
+
+		// Past 65535 work groups the dispatch has to go 2D
+		GLuint groups = (length + 255) / 256, columns = std::min<GLuint>(groups, 32768);
+		glDispatchCompute(columns, (groups + columns - 1) / columns, 1);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	};
+
+	// Count, scan every level but the total at the top, add each level's sums back into the one below, mesh
+	pass(0, 0);
+	for (size_t level = 0; level + 2 < levels.size(); level++) pass(1, level);
+	for (int level = (int)levels.size() - 3; level >= 0; level--)
+		if (levels[level + 1] - levels[level] > 256) pass(2, level);
+	pass(3, 0);
+
+	// The draw reads the mesh and the command the shader wrote
+	glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT
+				  | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+/**
+ *	Copies the mesh back from the GPU, laid out like Map::buildWallMesh()'s
+ */
+void WallMesher::read(std::vector<float>& vertices, std::vector<unsigned int>& indices) {
+	DrawCommand drawn = { 0, 0, 0, 0, 0 };
+	if (vao) {
+		glBindBuffer(GL_COPY_READ_BUFFER, command);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(DrawCommand), &drawn);
+	}
+	size_t sides = drawn.count / Map::sideIndices;
+	vertices.resize(sides * Map::sideFloats);
+	indices.resize(sides * Map::sideIndices);
+
+	if (sides > 0) {
+		glBindBuffer(GL_COPY_READ_BUFFER, vbo);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, vertices.size() * sizeof(float), vertices.data());
+		glBindBuffer(GL_COPY_READ_BUFFER, ebo);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, 0, indices.size() * sizeof(unsigned int), indices.data());
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+/**
+ *	Draws the walls with the scene shader, in one indirect call
+ *	@param image - Layer of the array texture the walls show
+ */
+void WallMesher::draw(GLuint shader, const AssetLoader::Layer& image, const glm::mat4& projection, const glm::mat4& view) {
+	if (!vao || walls == 0) return;
+
+	glBindVertexArray(vao);
+	glUseProgram(shader);
+	glUniformMatrix4fv(glGetUniformLocation(shader, "u_ProjectionMat"), 1, false, glm::value_ptr(projection));
+	glUniformMatrix4fv(glGetUniformLocation(shader, "u_ViewMat"), 1, false, glm::value_ptr(view));
+	glUniform2f(glGetUniformLocation(shader, "u_TexScale"), image.scaleU, image.scaleV);
+	glUniform2f(glGetUniformLocation(shader, "u_TexOffset"), image.offsetU, image.offsetV);
+	glVertexAttribI1i(3, image.layer);
+	glVertexAttrib3f(4, 0.f, 0.f, 0.f);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command);
+	glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	// StaticScene's vertices are scaled already
+	glUniform2f(glGetUniformLocation(shader, "u_TexScale"), 1.f, 1.f);
+	glUniform2f(glGetUniformLocation(shader, "u_TexOffset"), 0.f, 0.f);
+	glBindVertexArray(0);
+}